@@ -0,0 +1,122 @@
+/// \file kalman_filter/assignment.hpp
+/// \brief Defines the kalman_filter::assignment_t class.
+#ifndef KALMAN_FILTER___ASSIGNMENT_H
+#define KALMAN_FILTER___ASSIGNMENT_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace kalman_filter {
+
+/// \brief A sparse linear assignment solver.
+/// \details Solves the minimum cost assignment of rows (e.g. tracks) to columns (e.g. detections) over a sparse set of
+/// allowed pairs. Every row may instead be left unassigned at a fixed cost. The solver uses shortest augmenting paths
+/// with column potentials (the augmentation phase of Jonker-Volgenant), where each path search only visits the rows and
+/// columns connected to the row being assigned. This makes the cost proportional to the size of the gated clusters
+/// rather than the full rows x columns matrix.
+/// \note All storage is reused between solves.
+class assignment_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new assignment_t object.
+    assignment_t();
+
+    // METHODS
+    /// \brief Clears all pairs and sets the problem dimensions.
+    /// \param n_rows The number of rows.
+    /// \param n_cols The number of columns.
+    void reset(uint32_t n_rows, uint32_t n_cols);
+    /// \brief Adds an allowed pair.
+    /// \param row The index of the row.
+    /// \param col The index of the column.
+    /// \param cost The cost of assigning the row to the column. Must be non-negative.
+    void add(uint32_t row, uint32_t col, double_t cost);
+    /// \brief Solves the assignment.
+    /// \param unassigned_cost The cost of leaving a row unassigned.
+    /// \details Pairs with a cost above unassigned_cost are never assigned.
+    void solve(double_t unassigned_cost);
+
+    // ACCESS
+    /// \brief Gets the number of allowed pairs.
+    /// \returns The number of pairs.
+    uint32_t n_pairs() const;
+    /// \brief Gets the column assigned to each row.
+    /// \returns A reference to the column index of each row, or -1 if the row is unassigned.
+    const std::vector<int32_t>& row_assignments() const;
+    /// \brief Gets the row assigned to each column.
+    /// \returns A reference to the row index of each column, or -1 if the column is unassigned.
+    const std::vector<int32_t>& col_assignments() const;
+    /// \brief Gets the total cost of the last solution, including the cost of unassigned rows.
+    /// \returns The total cost.
+    double_t cost() const;
+
+private:
+    // TYPES
+    /// \brief An allowed pair.
+    struct edge_t
+    {
+        /// \brief The index of the row.
+        uint32_t row;
+        /// \brief The index of the column.
+        uint32_t col;
+        /// \brief The cost of the pair.
+        double_t cost;
+    };
+
+    // DIMENSIONS
+    /// \brief The number of rows.
+    uint32_t n_r;
+    /// \brief The number of columns.
+    uint32_t n_c;
+
+    // STORAGE: GRAPH
+    /// \brief The allowed pairs in insertion order.
+    std::vector<edge_t> m_edges;
+    /// \brief The start of each row's pairs in m_row_edges.
+    std::vector<uint32_t> m_row_start;
+    /// \brief The pairs grouped by row.
+    std::vector<edge_t> m_row_edges;
+
+    // STORAGE: SOLUTION
+    /// \brief The column assigned to each row, or -1.
+    std::vector<int32_t> m_row_assignments;
+    /// \brief The row assigned to each column, or -1.
+    std::vector<int32_t> m_col_assignments;
+    /// \brief The cost of each row's assignment.
+    std::vector<double_t> m_row_costs;
+    /// \brief The total cost of the solution.
+    double_t m_cost;
+
+    // STORAGE: SEARCH
+    /// \brief The potential of each column.
+    /// \details Columns n_c + r are the unassigned options of each row r.
+    std::vector<double_t> v;
+    /// \brief The shortest path distance to each column.
+    std::vector<double_t> d;
+    /// \brief The row preceding each column on its shortest path.
+    std::vector<int32_t> m_predecessor;
+    /// \brief The cost of the pair from the preceding row to each column.
+    std::vector<double_t> m_predecessor_costs;
+    /// \brief Indicates if each column has been scanned.
+    std::vector<uint8_t> m_scanned;
+    /// \brief The columns touched by the current search.
+    std::vector<uint32_t> m_touched;
+    /// \brief The search heap of (distance, column).
+    std::vector<std::pair<double_t, uint32_t>> m_heap;
+
+    // METHODS
+    /// \brief Finds a shortest augmenting path from a row and augments the assignment along it.
+    /// \param row The unassigned row to start from.
+    /// \param unassigned_cost The cost of leaving a row unassigned.
+    void augment(uint32_t row, double_t unassigned_cost);
+    /// \brief Gets the row that a column is assigned to, including unassigned option columns.
+    /// \param col The column index.
+    /// \returns The assigned row, or -1.
+    int32_t owner(uint32_t col) const;
+};
+
+}
+
+#endif
@@ -3,14 +3,289 @@
 #ifndef KALMAN_FILTER___BASE_H
 #define KALMAN_FILTER___BASE_H
 
+#include <kalman_filter/log.hpp>
+
 #include <eigen3/Eigen/Dense>
 
-#include <map>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <memory>
+#include <vector>
+
+/// \def KALMAN_FILTER_CHECK_BOUNDS
+/// \brief Enables index checks in the status code API.
+/// \details Defaults to enabled, unless NDEBUG is defined by a release build. Define as 0 or 1 to override.
+/// The exception API always checks indices. This is a build option of the library: the status code API is compiled
+/// into the library, so the value used is the one defined when the library is built (e.g. in CMAKE_CXX_FLAGS or with
+/// CMAKE_BUILD_TYPE). Defining it in the build of code that uses the library has no effect.
+#ifndef KALMAN_FILTER_CHECK_BOUNDS
+#ifdef NDEBUG
+#define KALMAN_FILTER_CHECK_BOUNDS 0
+#else
+#define KALMAN_FILTER_CHECK_BOUNDS 1
+#endif
+#endif
 
 /// \brief Contains objects for Kalman Filtering.
 namespace kalman_filter {
 
+// Forward declaration for friendship.
+class imm_t;
+// Forward declaration for state publishing.
+class shm_publisher_t;
+
+/// \brief Stores the observations made between filter iterations.
+/// \details Storage is preallocated for all observers, so adding observations does not allocate.
+/// By default a new observation replaces any earlier observation from the same observer. In averaging mode,
+/// all samples from an observer are fused into a single observation with correspondingly reduced noise.
+class observation_buffer_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new observation_buffer_t object.
+    /// \param n_observers The number of state observers.
+    observation_buffer_t(uint32_t n_observers);
+
+    // METHODS
+    /// \brief Adds an observation for an observer.
+    /// \param observer_index The index of the observer. Must be in range.
+    /// \param observation The value of the observation.
+    void insert(uint32_t observer_index, double_t observation);
+    /// \brief Adds an observation for an observer with its own noise variance.
+    /// \param observer_index The index of the observer. Must be in range.
+    /// \param observation The value of the observation.
+    /// \param variance The noise variance of the observation. Must be valid.
+    void insert(uint32_t observer_index, double_t observation, double_t variance);
+    /// \brief Adds or replaces observations for a contiguous range of observers with their own noise covariance.
+    /// \param first_observer_index The index of the first observer. The range must be in range.
+    /// \param observations The values of the observations.
+    /// \param covariance The noise covariance of the observations. Must be valid.
+    /// \note Correlated blocks are never averaged; they replace earlier samples of their observers.
+    void insert(uint32_t first_observer_index, const Eigen::VectorXd& observations, const Eigen::MatrixXd& covariance);
+    /// \brief Removes all observations.
+    void clear();
+    /// \brief Checks if an observation noise variance is valid.
+    /// \param variance The noise variance.
+    /// \returns TRUE if the variance is positive and finite, otherwise FALSE.
+    static bool valid_variance(double_t variance);
+    /// \brief Checks if an observation noise covariance block is valid.
+    /// \param covariance The noise covariance.
+    /// \returns TRUE if the covariance is finite and symmetric with a positive diagonal, otherwise FALSE.
+    static bool valid_covariance(const Eigen::MatrixXd& covariance);
+    /// \brief Enables or disables averaging of multiple samples per observer.
+    /// \param enabled TRUE to average samples, FALSE to keep only the latest sample.
+    /// \note Changing the mode removes all stored observations.
+    void set_averaging(bool enabled);
+
+    // ACCESS
+    /// \brief Indicates if no observations are stored.
+    /// \returns TRUE if the buffer is empty, otherwise FALSE.
+    bool empty() const;
+    /// \brief Gets the number of observers with stored observations.
+    /// \returns The number of observations.
+    uint32_t size() const;
+    /// \brief Indicates if an observation is stored for an observer.
+    /// \param observer_index The index of the observer. Must be in range.
+    /// \returns TRUE if an observation is stored, otherwise FALSE.
+    bool contains(uint32_t observer_index) const;
+    /// \brief Gets the stored (or fused) observation for an observer.
+    /// \param observer_index The index of the observer. Must be in range.
+    /// \param R The static observation noise covariance matrix, used to weight samples without their own noise.
+    /// \returns The value of the observation.
+    double_t value(uint32_t observer_index, const Eigen::MatrixXd& R) const;
+    /// \brief Gets the indices of the observers with stored observations.
+    /// \returns The observer indices, in ascending order.
+    const std::vector<uint32_t>& indices() const;
+    /// \brief Indicates if averaging of multiple samples per observer is enabled.
+    /// \returns TRUE if averaging is enabled, otherwise FALSE.
+    bool averaging() const;
+    /// \brief Adds the observation noise covariance of the stored observations to a matrix.
+    /// \param R The static observation noise covariance matrix.
+    /// \param S (OUTPUT) The matrix to add the noise covariance to.
+    /// \details Observations with their own or averaged noise use it in place of their rows and columns of R.
+    void add_noise(const Eigen::MatrixXd& R, Eigen::MatrixXd& S) const;
+    /// \brief Indicates if the noise of any stored observation differs from R.
+    /// \returns TRUE if add_noise() corrects any rows and columns of R, otherwise FALSE.
+    /// \details Observations with their own noise, and averages of weighted or multiple samples, are corrected.
+    bool corrected() const;
+
+private:
+    /// \brief The observation value of each observer.
+    /// \details Holds the sum of samples without their own noise when averaging.
+    Eigen::VectorXd m_values;
+    /// \brief Flags indicating which observers have observations.
+    std::vector<uint8_t> m_flags;
+    /// \brief The indices of the observers with observations, in ascending order.
+    std::vector<uint32_t> m_indices;
+    /// \brief Flags indicating which observers have observation specific noise.
+    std::vector<uint8_t> m_noise_flags;
+    /// \brief The observation specific noise covariance.
+    /// \details Allocated on first use.
+    Eigen::MatrixXd m_noise;
+
+    // AVERAGING
+    /// \brief Indicates if multiple samples per observer are averaged.
+    bool m_averaging;
+    /// \brief The number of samples without their own noise for each observer.
+    std::vector<uint32_t> m_counts;
+    /// \brief The sum of inverse variances of samples with their own noise for each observer.
+    Eigen::VectorXd m_weights;
+    /// \brief The inverse variance weighted sum of samples with their own noise for each observer.
+    Eigen::VectorXd m_weighted_values;
+
+    /// \brief Marks an observer as having a new observation.
+    /// \param observer_index The index of the observer.
+    void flag(uint32_t observer_index);
+    /// \brief Removes an observer's observation specific noise.
+    /// \param observer_index The index of the observer.
+    void clear_noise(uint32_t observer_index);
+    /// \brief Resets an observer's averaging accumulators if it is starting a new average.
+    /// \param observer_index The index of the observer.
+    void start_average(uint32_t observer_index);
+    /// \brief Indicates if an observer's noise differs from its rows and columns of R.
+    /// \param observer_index The index of the observer.
+    /// \returns TRUE if the observer's noise must be corrected, otherwise FALSE.
+    bool corrected(uint32_t observer_index) const;
+    /// \brief Calculates the effective noise covariance between two observers.
+    /// \param i The index of the first observer.
+    /// \param j The index of the second observer.
+    /// \param R The static observation noise covariance matrix.
+    /// \returns The effective noise covariance.
+    double_t noise(uint32_t i, uint32_t j, const Eigen::MatrixXd& R) const;
+};
+
+/// \brief A snapshot of a filter's consistency and health metrics.
+struct health_t
+{
+    /// \brief The total number of updates monitored.
+    uint64_t n_updates;
+    /// \brief The number of updates in the current window.
+    uint32_t n_window;
+    /// \brief The mean normalized innovation squared (NIS) over the window.
+    double_t nis_mean;
+    /// \brief The mean NIS divided by its degrees of freedom (the number of observations) over the window.
+    /// \details Close to one for a consistent filter. Larger values indicate overconfidence or divergence.
+    double_t nis_ratio;
+    /// \brief The fraction of updates in the window whose NIS exceeded its chi-square threshold.
+    /// \details Close to one minus the monitor's probability for a consistent filter.
+    double_t exceedance_rate;
+    /// \brief An estimate of the condition number of P after the last applied covariance update.
+    /// \details The ratio of the largest to smallest diagonal element, which is a lower bound on the condition number.
+    /// Infinite if a diagonal element is not positive or not finite.
+    double_t condition;
+};
+
+/// \brief Tracks windowed innovation consistency statistics of a filter.
+/// \details Statistics are updated by the filter thread and may be read from any thread without locks.
+/// Writers and readers synchronize with a seqlock on a sequence counter: the sequence is odd while a write is in progress.
+class health_monitor_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new health_monitor_t object.
+    /// \param n_observers The number of state observers.
+    /// \param window The number of updates in the statistics window. Must be at least one.
+    /// \param probability The chi-square probability of the NIS exceedance threshold (0 < probability < 1).
+    health_monitor_t(uint32_t n_observers, uint32_t window, double_t probability);
+
+    // METHODS
+    /// \brief Adds the result of an update to the statistics.
+    /// \param nis The normalized innovation squared of the update.
+    /// \param n_observations The number of observations in the update.
+    void add(double_t nis, uint32_t n_observations);
+    /// \brief Updates the condition estimate from the covariance matrix after an update.
+    /// \param P The covariance matrix after the update.
+    /// \details Called separately from add(), as a deferred covariance update is only applied in the next iteration.
+    void add_covariance(const Eigen::MatrixXd& P);
+    /// \brief Reads a consistent snapshot of the statistics.
+    /// \param health (OUTPUT) The statistics.
+    void read(health_t& health) const;
+    /// \brief Removes all updates from the statistics.
+    void clear();
+    /// \brief Changes the statistics window and exceedance threshold, and removes all updates from the statistics.
+    /// \param window The number of updates in the statistics window. Must be at least one.
+    /// \param probability The chi-square probability of the NIS exceedance threshold (0 < probability < 1).
+    /// \details Safe to call while other threads read the statistics, as readers only access the snapshot.
+    void configure(uint32_t window, double_t probability);
+
+    // ACCESS
+    /// \brief Gets the NIS exceedance threshold for a number of observations.
+    /// \param n_observations The number of observations (degrees of freedom). Must be in range.
+    /// \returns The chi-square threshold.
+    double_t threshold(uint32_t n_observations) const;
+
+private:
+    /// \brief The chi-square threshold for each number of observations, indexed from one.
+    std::vector<double_t> m_thresholds;
+
+    // WINDOW
+    /// \brief The NIS of each update in the window.
+    std::vector<double_t> m_nis;
+    /// \brief The NIS divided by its degrees of freedom of each update in the window.
+    std::vector<double_t> m_ratios;
+    /// \brief Flags indicating which updates in the window exceeded their threshold.
+    std::vector<uint8_t> m_exceeded;
+    /// \brief The window position of the next update.
+    uint32_t m_next;
+    /// \brief The running sum of NIS over the window.
+    double_t m_nis_sum;
+    /// \brief The running sum of NIS ratios over the window.
+    double_t m_ratio_sum;
+    /// \brief The running number of exceedances over the window.
+    uint32_t m_exceeded_count;
+
+    // SNAPSHOT
+    /// \brief The seqlock sequence counter.
+    std::atomic<uint64_t> m_sequence;
+    /// \brief The latest statistics.
+    health_t m_health;
+};
+
+/// \brief The degradations a deadline-aware iteration may take to complete in time.
+/// \details Degradations are flags, combined into a bitmask by degradations().
+enum class degradation_t : uint32_t
+{
+    /// \brief Reuses a previously calculated covariance square root instead of factorizing again.
+    REUSE_FACTOR = 1,
+    /// \brief Skips symmetrizing and conditioning the updated covariance.
+    SKIP_CONDITIONING = 2,
+    /// \brief Uses a minimal (spherical simplex) set of sigma points.
+    MINIMAL_SIGMA = 4,
+    /// \brief Defers the covariance update to the start of the next iteration.
+    DEFER_COVARIANCE = 8
+};
+
+/// \brief The filter engines, which identify the type of filter stored in checkpoints.
+enum class filter_type_t : uint32_t
+{
+    /// \brief The linear Kalman Filter (kf_t).
+    KF = 1,
+    /// \brief The Unscented Kalman Filter (ukf_t).
+    UKF = 2,
+    /// \brief The augmented Unscented Kalman Filter (ukfa_t).
+    UKFA = 3
+};
+
+/// \brief The result of an operation in the status code API.
+enum class status_t : uint32_t
+{
+    /// \brief The operation succeeded.
+    OK = 0,
+    /// \brief The operation succeeded after repairing a covariance matrix P that was not positive definite.
+    REPAIRED = 1,
+    /// \brief An observer or state variable index was out of range. Nothing was changed.
+    INVALID_INDEX = 2,
+    /// \brief A covariance matrix could not be factorized, even after repairing P.
+    /// \details The failed phase is abandoned, pending observations are discarded, and x and P keep the result of
+    /// the last successful phase.
+    NOT_POSITIVE_DEFINITE = 3,
+    /// \brief A model function or the log writer threw an exception, which was caught.
+    /// \details The failed phase is abandoned and pending observations are discarded. x and P may be left partially
+    /// updated by the phase.
+    EXCEPTION = 4
+};
+
 /// \brief Provides base functionality for all Kalman Filter object types.
 class base_t
 {
@@ -20,16 +295,83 @@ public:
     /// \param n_variables The number of variables in the state vector.
     /// \param n_observers The number of state observers.
     base_t(uint32_t n_variables, uint32_t n_observers);
-    ~base_t();
+    /// \brief Instantiates a copy of an existing base_t object.
+    /// \param other The filter to copy.
+    /// \note The copy does not inherit the other filter's log file, health monitor, or shared observation stream.
+    base_t(const base_t& other);
+    virtual ~base_t();
+
+    // CLONING
+    /// \brief Creates a deep copy of the filter.
+    /// \returns A new filter with the same state, covariances, models, and pending observations, or nullptr if the
+    /// filter does not implement cloning.
+    /// \details Filters extending ukf_t or ukfa_t must override this to be used with pool_t, tracker_t, or sweep_t,
+    /// usually as: return std::unique_ptr<base_t>(new model_t(*this));
+    virtual std::unique_ptr<base_t> clone() const;
+
+    // RESETTING
+    /// \brief Clears the filter's runtime state.
+    /// \details Removes pending observations, discards deferred covariance propagation, and clears the update
+    /// statistics, health statistics, and iteration count. The state, covariances, models, and parameters are kept.
+    void reset();
 
     // FILTER METHODS
     /// \brief Predicts a new state and performs update corrections with available observations.
+    /// \details If a phase throws, the iteration is still completed before the exception is rethrown: the unchanged
+    /// state is logged as the estimate, the iteration count is incremented, and the state is published.
     /// \note The iteration rate should be at least as fast as the fastest observer rate.
-    virtual void iterate() = 0;
+    virtual void iterate();
+    /// \brief Predicts a new state and covariance.
+    /// \details This is the first half of iterate(). It must be followed by update().
+    virtual void predict() = 0;
+    /// \brief Performs update corrections with available observations and completes the iteration.
+    /// \details This is the second half of iterate(). Observations may be added between predict() and update().
+    virtual void update() = 0;
+    /// \brief Calculates the predicted observation and its covariance for all observers.
+    /// \param z (OUTPUT) The predicted observation vector.
+    /// \param S (OUTPUT) The predicted observation covariance, including the observation noise R.
+    /// \details Call between predict() and update() to gate candidate observations before they are added.
+    /// Observation specific noise is not included, as no observations are required.
+    virtual void predicted_observation(Eigen::VectorXd& z, Eigen::MatrixXd& S) const = 0;
+    /// \brief Predicts future states and covariances without modifying the filter.
+    /// \param horizon The number of steps to predict.
+    /// \param states (OUTPUT) The predicted state for each step. Existing storage is reused.
+    /// \param covariances (OUTPUT) The predicted covariance for each step. Existing storage is reused.
+    /// \details Each step is a prediction without observations, using the current model and inputs.
+    virtual void forecast(uint32_t horizon, std::vector<Eigen::VectorXd>& states, std::vector<Eigen::MatrixXd>& covariances) const = 0;
     /// \brief Adds a new observation to the filter.
     /// \param observer_index The index of the observer that made the observation.
     /// \param observation The value of the observation.
     void new_observation(uint32_t observer_index, double_t observation);
+    /// \brief Adds a batch of new observations to the filter.
+    /// \param observer_indices The indices of the observers that made the observations.
+    /// \param observations The values of the observations.
+    /// \param count The number of observations in the batch.
+    void new_observations(const uint32_t* observer_indices, const double_t* observations, uint32_t count);
+    /// \brief Adds new observations from a contiguous range of observers to the filter.
+    /// \param first_observer_index The index of the observer that made the first observation.
+    /// \param observations The values of the observations, ordered by observer index.
+    /// \param count The number of observations in the range.
+    void new_observations(uint32_t first_observer_index, const double_t* observations, uint32_t count);
+    /// \brief Adds a new observation to the filter with its own noise variance.
+    /// \param observer_index The index of the observer that made the observation.
+    /// \param observation The value of the observation.
+    /// \param variance The noise variance of the observation, used in place of the observer's R row and column.
+    void new_observation(uint32_t observer_index, double_t observation, double_t variance);
+    /// \brief Adds new observations from a contiguous range of observers to the filter with their own noise covariance.
+    /// \param first_observer_index The index of the observer that made the first observation.
+    /// \param observations The values of the observations, ordered by observer index.
+    /// \param covariance The noise covariance of the observations, used in place of the observers' R rows and columns.
+    void new_observations(uint32_t first_observer_index, const Eigen::VectorXd& observations, const Eigen::MatrixXd& covariance);
+    /// \brief Enables or disables averaging of multiple observations per observer between iterations.
+    /// \param enabled TRUE to fuse all observations made by an observer, FALSE to keep only the latest.
+    /// \details When enabled, samples without their own noise are averaged with their R row and column
+    /// scaled by 1/sqrt(n_samples). Samples with their own variance are fused by inverse variance weighting.
+    /// \note Changing the mode removes any pending observations.
+    void set_observation_averaging(bool enabled);
+    /// \brief Indicates if averaging of multiple observations per observer is enabled.
+    /// \returns TRUE if averaging is enabled, otherwise FALSE.
+    bool observation_averaging() const;
     /// \brief Indicates if a new observation is available.
     /// \param observer_index The index of the observer to check for a new observation.
     /// \returns TRUE if a new observation is available, otherwise FALSE.
@@ -42,6 +384,13 @@ public:
     /// \brief Gets the number of observers.
     /// \returns The number of observers.
     uint32_t n_observers() const;
+    /// \brief Estimates the relative computational cost of one iteration.
+    /// \returns The estimated number of floating point operations of an iteration with all observations.
+    /// \details Used to balance work between threads. Only the relative cost between filters matters.
+    virtual double_t iteration_cost() const;
+    /// \brief Gets the number of iterations the filter has performed.
+    /// \returns The number of iterations.
+    uint64_t n_iterations() const;
     /// \brief Gets the current estimated value of a state variable.
     /// \param index The index of the variable to get.
     /// \returns The current estimated value of the state variable.
@@ -64,6 +413,87 @@ public:
 
     Eigen::VectorXd get_state();
     Eigen::MatrixXd get_covariance();
+    /// \brief Gets a read-only reference to the current estimated state vector.
+    /// \returns A reference to the internal state vector.
+    const Eigen::VectorXd& state() const;
+    /// \brief Gets a read-only reference to the current estimated covariance matrix.
+    /// \returns A reference to the internal covariance matrix.
+    const Eigen::MatrixXd& covariance() const;
+    /// \brief Copies the current estimated covariance matrix without applying deferred propagation to the filter.
+    /// \param P (OUTPUT) The covariance matrix.
+    /// \details Unlike covariance(), deferred covariance propagation is only applied to the copy, so observing the
+    /// covariance does not change when a lazy filter propagates it.
+    void covariance(Eigen::MatrixXd& P) const;
+    /// \brief Gets the normalized innovation squared (NIS) of the last update.
+    /// \returns The NIS of the last update, or zero if no update has been performed.
+    double_t nis() const;
+    /// \brief Gets the log-likelihood of the observations used in the last update.
+    /// \returns The log-likelihood of the last update, or zero if no update has been performed.
+    double_t log_likelihood() const;
+
+    // HEALTH
+    /// \brief Enables or disables streaming consistency and health monitoring of updates.
+    /// \param window The number of updates in the statistics window, or zero to disable monitoring.
+    /// \param probability The chi-square probability of the NIS exceedance threshold. DEFAULT = 0.95
+    /// \details Each update adds its NIS, chi-square exceedance, and a condition estimate of P to the statistics.
+    /// \note Enabling monitoring resets the statistics.
+    void set_health_monitoring(uint32_t window, double_t probability = 0.95);
+    /// \brief Gets a snapshot of the health statistics.
+    /// \param health (OUTPUT) The health statistics.
+    /// \returns TRUE if monitoring is enabled, otherwise FALSE.
+    /// \details Safe to call from any thread while the filter is iterating. Does not lock.
+    bool health(health_t& health) const;
+
+    // DEADLINE
+    /// \brief Gets the degradations taken by the last deadline-aware iteration.
+    /// \returns A bitmask of degradation_t flags, or zero if no degradations were taken.
+    uint32_t degradations() const;
+    /// \brief Indicates if a degradation was taken by the last deadline-aware iteration.
+    /// \param degradation The degradation to check.
+    /// \returns TRUE if the degradation was taken, otherwise FALSE.
+    bool degraded(degradation_t degradation) const;
+
+    // STATUS API
+    /// \brief Predicts a new state and performs update corrections without throwing exceptions.
+    /// \returns The status of the iteration.
+    /// \details If a phase fails because P is not positive definite, P is repaired by clamping its eigenvalues and
+    /// the phase is retried once. If the iteration still fails, it is completed with the unchanged state as its
+    /// estimate, as in iterate(). Exceptions thrown by model functions or the log writer (e.g. std::bad_alloc) are
+    /// caught and returned as EXCEPTION.
+    status_t try_iterate() noexcept;
+    /// \brief Adds a new observation to the filter without throwing exceptions.
+    /// \param observer_index The index of the observer that made the observation.
+    /// \param observation The value of the observation.
+    /// \returns The status of the operation.
+    status_t try_new_observation(uint32_t observer_index, double_t observation) noexcept;
+    /// \brief Adds a batch of new observations to the filter without throwing exceptions.
+    /// \param observer_indices The indices of the observers that made the observations.
+    /// \param observations The values of the observations.
+    /// \param count The number of observations in the batch.
+    /// \returns The status of the operation.
+    status_t try_new_observations(const uint32_t* observer_indices, const double_t* observations, uint32_t count) noexcept;
+    /// \brief Gets the current estimated value of a state variable without throwing exceptions.
+    /// \param index The index of the variable to get.
+    /// \param value (OUTPUT) The current estimated value of the state variable.
+    /// \returns The status of the operation.
+    status_t try_state(uint32_t index, double_t& value) const noexcept;
+    /// \brief Sets the value of an estimated state variable without throwing exceptions.
+    /// \param index The index of the variable to set.
+    /// \param value The value to assign to the variable.
+    /// \returns The status of the operation.
+    status_t try_set_state(uint32_t index, double_t value) noexcept;
+    /// \brief Gets the current covariance between two estimated state variables without throwing exceptions.
+    /// \param index_a The index of the first estimated state.
+    /// \param index_b The index of the second estimated state.
+    /// \param value (OUTPUT) The covariance between the two estimated states.
+    /// \returns The status of the operation.
+    status_t try_covariance(uint32_t index_a, uint32_t index_b, double_t& value) const noexcept;
+    /// \brief Sets the covariance between two estimated state variables without throwing exceptions.
+    /// \param index_a The index of the first estimated state.
+    /// \param index_b The index of the second estimated state.
+    /// \param value The value to assign to the covariance.
+    /// \returns The status of the operation.
+    status_t try_set_covariance(uint32_t index_a, uint32_t index_b, double_t value) noexcept;
 
     // COVARIANCES
     /// \brief The process noise covariance matrix.
@@ -71,15 +501,53 @@ public:
     /// \brief The observation noise covariance matrix.
     Eigen::MatrixXd R;
 
+    // CHECKPOINTING
+    /// \brief Saves the filter's state, covariances, models, and parameters to a binary checkpoint file.
+    /// \param checkpoint_file The file to save the checkpoint to.
+    /// \returns TRUE if the checkpoint was saved, otherwise FALSE.
+    bool save_checkpoint(const std::string& checkpoint_file) const;
+    /// \brief Saves the filter's state, covariances, models, and parameters to a binary checkpoint buffer.
+    /// \param checkpoint (OUTPUT) The buffer to write the checkpoint to.
+    void save_checkpoint(std::vector<uint8_t>& checkpoint) const;
+    /// \brief Loads the filter's state, covariances, models, and parameters from a binary checkpoint file.
+    /// \param checkpoint_file The file to load the checkpoint from.
+    /// \returns TRUE if the checkpoint was loaded, otherwise FALSE.
+    /// \details The file is memory mapped. The filter is left unchanged if the checkpoint does not match the filter's
+    /// type and dimensions.
+    bool load_checkpoint(const std::string& checkpoint_file);
+    /// \brief Loads the filter's state, covariances, models, and parameters from a binary checkpoint in memory.
+    /// \param checkpoint The checkpoint data.
+    /// \param size The size of the checkpoint data in bytes.
+    /// \returns TRUE if the checkpoint was loaded, otherwise FALSE.
+    /// \details The filter is left unchanged if the checkpoint does not match the filter's type and dimensions.
+    bool load_checkpoint(const void* checkpoint, size_t size);
+
     // LOGGING
     /// \brief Opens up a log file and begins logging data.
     /// \param log_file The file to log to.
     /// \param precision The precision to write numbers with. DEFAULT = 6
     /// \returns TRUE if the logging successfully started, otherwise FALSE.
     bool start_log(const std::string& log_file, uint8_t precision = 6);
+    /// \brief Opens up a log file and begins logging selected data.
+    /// \param log_file The file to log to.
+    /// \param config The columns to log and how often to log them.
+    /// \param precision The precision to write numbers with. DEFAULT = 6
+    /// \returns TRUE if the logging successfully started, otherwise FALSE if the file could not be opened or the
+    /// configuration contains an invalid index.
+    /// \details Each logged iteration is one row. Values that are not available in an iteration are left empty.
+    bool start_log(const std::string& log_file, const log_config_t& config, uint8_t precision = 6);
     /// \brief Stops logging.
     void stop_log();
 
+    // PUBLISHING
+    /// \brief Begins publishing the state and covariance to a shared memory segment after each iteration.
+    /// \param segment_name The name of the POSIX shared memory segment (e.g. "/kalman_filter").
+    /// \returns TRUE if publishing successfully started, otherwise FALSE (e.g. if the segment already exists).
+    /// \details Other processes may read the published state with a shm_subscriber_t.
+    bool start_publishing(const std::string& segment_name);
+    /// \brief Stops publishing and removes the shared memory segment.
+    void stop_publishing();
+
 protected:
     
     // DIMENSIONS
@@ -110,25 +578,214 @@ protected:
     /// \brief Indicates if any observations have been made since the last iteration.
     /// \returns TRUE if new observations exist, otherwise FALSE.
     bool has_observations() const;
+    /// \brief Adds the observation noise covariance of the current observations to a matrix.
+    /// \param S (OUTPUT) The matrix to add the noise covariance to.
+    /// \details Uses R, replacing the rows and columns of observations that were given their own noise.
+    void add_observation_noise(Eigen::MatrixXd& S) const;
+    /// \brief Indicates if the noise of any current observation differs from R.
+    /// \returns TRUE if add_observation_noise() does not add exactly R, otherwise FALSE.
+    bool has_observation_noise() const;
     /// \brief Performs a Kalman update masked by available observations.
+    /// \returns TRUE if the update succeeded, otherwise FALSE if S could not be factorized (status API only).
     /// \details S and C must be calculated first.
-    void masked_kalman_update();
-    /// \brief Writes the predicted state to the log file.
+    bool masked_kalman_update();
+    /// \brief Applies any deferred covariance propagation to P.
+    /// \details Applies a deferred covariance update. Filters that defer covariance prediction override this and must
+    /// call the base implementation first. It is called before P is read or written.
+    virtual void flush_covariance();
+    /// \brief Discards any deferred covariance propagation without applying it.
+    /// \details Called before P is replaced. Filters that defer covariance prediction override this and must call the
+    /// base implementation.
+    virtual void discard_covariance();
+    /// \brief Calculates the covariance with any deferred covariance propagation applied, without changing the filter.
+    /// \param P_out (OUTPUT) The covariance.
+    /// \details Used by const methods that must not flush. Filters that defer covariance prediction override this and
+    /// must call the base implementation first.
+    virtual void flushed_covariance(Eigen::MatrixXd& P_out) const;
+    /// \brief Checks if any covariance propagation is deferred.
+    /// \returns TRUE if P does not yet include all covariance propagation, otherwise FALSE.
+    /// \details Filters that defer covariance prediction override this and must call the base implementation.
+    virtual bool covariance_deferred() const;
+    /// \brief Gets the covariance with any deferred covariance propagation applied, without changing the filter.
+    /// \param P_storage (OUTPUT) Storage for the covariance, only written if propagation is deferred.
+    /// \returns P if no propagation is deferred, otherwise P_storage.
+    const Eigen::MatrixXd& current_covariance(Eigen::MatrixXd& P_storage) const;
+    /// \brief Gets the type of the filter stored in checkpoints.
+    /// \returns The filter type.
+    virtual filter_type_t filter_type() const = 0;
+    /// \brief Collects the fields loaded from checkpoints.
+    /// \param fields (OUTPUT) The list of (data, size) fields to append to.
+    /// \details Derived filters should call the base implementation before appending their own fields.
+    virtual void checkpoint_fields(std::vector<std::pair<double_t*, uint32_t>>& fields);
+    /// \brief Collects the fields saved to checkpoints.
+    /// \param fields (OUTPUT) The list of (data, size) fields to append to.
+    /// \details Must list the same fields in the same order as the non-const overload.
+    virtual void checkpoint_fields(std::vector<std::pair<const double_t*, uint32_t>>& fields) const;
+    /// \brief Stages the predicted state for the log file.
     void log_predicted_state();
-    /// \brief Writes observations to the log file.
+    /// \brief Stages observations for the log file.
     /// \param empty Indicates if there are no observations available.
     void log_observations(bool empty = false);
-    /// \brief Writes the estimated state to the log file.
+    /// \brief Writes the iteration's row to the log file if it is selected by the log configuration.
     void log_estimated_state();
+    /// \brief Completes an iteration by updating the iteration count and publishing the state.
+    void complete_iteration();
+    /// \brief Completes an iteration that failed, so that it is logged, counted, and published.
+    /// \param predicted Indicates if the prediction succeeded, so the predicted state is already staged for the log.
+    /// \details The unchanged state is logged as the estimate.
+    void complete_failed_iteration(bool predicted);
+    /// \brief Reports a failure of the current operation.
+    /// \param status The status describing the failure.
+    /// \param message The message of the exception.
+    /// \details Throws a std::runtime_error unless running under the status API, in which case the failure is
+    /// recorded and the caller must return without modifying the filter further.
+    void fail(status_t status, const char* message) const;
+    /// \brief Indicates if a failure was recorded by the status API.
+    /// \returns TRUE if the current operation failed, otherwise FALSE.
+    bool failed() const;
+
+    // DEADLINE
+    /// \brief The separately timed components of an iteration.
+    enum class component_t
+    {
+        /// \brief Factorizing the predicted covariance for the update.
+        FACTOR = 0,
+        /// \brief Applying the Kalman gain to the covariance.
+        COVARIANCE = 1,
+        /// \brief Symmetrizing and conditioning the covariance.
+        CONDITIONING = 2
+    };
+    /// \brief Runs predict() and update(), taking degradations if the estimated cost exceeds the time remaining.
+    /// \param deadline The time by which the iteration should complete.
+    /// \param available The bitmask of degradations the filter supports.
+    /// \param minimal_fraction The cost of predicting and updating with minimal sigma points relative to the full set.
+    /// \details Degradations are taken in the order of degradation_t until the estimated cost fits. Costs are
+    /// estimated from the measured durations of previous deadline-aware iterations.
+    void iterate_until(std::chrono::steady_clock::time_point deadline, uint32_t available, double_t minimal_fraction);
+    /// \brief Indicates if a degradation is planned for the current iteration and records it as taken.
+    /// \param degradation The degradation to check.
+    /// \returns TRUE if the caller should degrade, otherwise FALSE.
+    bool degrade(degradation_t degradation);
+    /// \brief Starts timing a component of a deadline-aware iteration.
+    /// \returns The start time, or the epoch if the iteration is not being timed.
+    std::chrono::steady_clock::time_point start_timing() const;
+    /// \brief Stops timing a component of a deadline-aware iteration.
+    /// \param component The component being timed.
+    /// \param start The start time returned by start_timing().
+    void stop_timing(component_t component, std::chrono::steady_clock::time_point start);
 
 private:
     // VARIABLES
     /// \brief Stores the actual observations made between iterations.
-    std::map<uint32_t, double_t> m_observations;
+    observation_buffer_t m_observations;
+    /// \brief The observation buffer currently used by the filter.
+    /// \details Points to m_observations unless the filter is attached to a shared observation stream.
+    observation_buffer_t* m_observation_source;
+    /// \brief The normalized innovation squared of the last update.
+    double_t m_nis;
+    /// \brief The log-likelihood of the last update.
+    double_t m_log_likelihood;
+    /// \brief The contiguous workspace for the masked update matrices.
+    Eigen::VectorXd m_workspace;
+
+    // HEALTH
+    /// \brief The health monitor, allocated when monitoring is first enabled.
+    /// \details Never released before destruction, so health() may read it from other threads.
+    std::unique_ptr<health_monitor_t> m_health;
+    /// \brief Indicates if health monitoring is enabled.
+    std::atomic<bool> m_health_enabled;
+
+    // DEADLINE
+    /// \brief The degradations planned for the current deadline-aware iteration.
+    uint32_t m_planned;
+    /// \brief The degradations taken by the last deadline-aware iteration.
+    uint32_t m_taken;
+    /// \brief Indicates if the current iteration is being timed.
+    bool m_timing;
+    /// \brief The estimated duration of each component_t, in seconds.
+    double_t m_component_costs[3];
+    /// \brief The measured duration of each component_t in the current iteration, in seconds.
+    double_t m_component_times[3];
+    /// \brief The estimated duration of the remaining work of an iteration without and with observations, in seconds.
+    double_t m_base_costs[2];
+
+    // DEFERRED COVARIANCE
+    /// \brief The number of observations of the deferred covariance update, or zero if none is deferred.
+    uint32_t m_deferred_n;
+    /// \brief Indicates if the deferred covariance update must be conditioned.
+    bool m_deferred_conditioning;
+    /// \brief The storage for the deferred C_m and K_m'.
+    /// \details Allocated on first use.
+    Eigen::VectorXd m_deferred;
+
+    // STATUS
+    /// \brief Indicates if the filter is running under the status API.
+    bool m_nothrow;
+    /// \brief The first failure recorded by the status API.
+    mutable status_t m_status;
+    /// \brief The eigensolver used to repair P.
+    /// \details Preallocated so that repairs do not allocate.
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> m_repair;
+
+    // METHODS
+    /// \brief Forces a covariance matrix to be symmetric and diagonally dominant.
+    /// \param P The covariance matrix to condition in place.
+    void condition_covariance(Eigen::MatrixXd& P) const;
+    /// \brief Repairs P by clamping its eigenvalues to a small positive value.
+    /// \returns TRUE if P was repaired, otherwise FALSE if P is not finite.
+    bool repair_covariance();
+    /// \brief Runs a phase of an iteration under the status API, repairing P and retrying once on failure.
+    /// \param update_phase Indicates if the update phase is run, otherwise the predict phase.
+    /// \returns The status of the phase.
+    status_t try_phase(bool update_phase) noexcept;
 
     // LOGGING
-    /// \brief The log file instance.
-    std::ofstream m_log_file;
+    /// \brief The buffered log file writer.
+    log_writer_t m_log;
+    /// \brief The binary matrix log writer.
+    log_writer_t m_log_matrices;
+    /// \brief The log configuration.
+    log_config_t m_log_config;
+    /// \brief The indices of the logged state variables.
+    std::vector<uint32_t> m_log_states;
+    /// \brief The indices of the logged observers.
+    std::vector<uint32_t> m_log_observers;
+    /// \brief The log column of each observer, or -1 if the observer is not logged.
+    std::vector<int32_t> m_log_observer_columns;
+    /// \brief The staged predicted state of the current iteration.
+    Eigen::VectorXd m_log_xp;
+    /// \brief The staged predicted observations of the current iteration, or NaN if not available.
+    Eigen::VectorXd m_log_zp;
+    /// \brief The staged actual observations of the current iteration, or NaN if not available.
+    Eigen::VectorXd m_log_za;
+    /// \brief The staged Kalman gains of the current iteration, or NaN if not available.
+    Eigen::MatrixXd m_log_gains;
+    /// \brief The staged innovation covariance of the current iteration, or NaN if not available.
+    Eigen::MatrixXd m_log_S;
+    /// \brief The logged covariance with any deferred propagation applied, so logging does not flush the filter.
+    /// \details Shared by the Pd_i columns and the covariance matrix log.
+    Eigen::MatrixXd m_log_P;
+    /// \brief Indicates if the current iteration performed an update.
+    bool m_log_updated;
+    /// \brief The number of eligible iterations since logging started.
+    uint64_t m_log_count;
+
+    // METHODS
+    /// \brief Stages the Kalman gain and innovation covariance of the current update for logging.
+    /// \param Kt_m The transposed Kalman gain masked by the current observations.
+    /// \param observers The indices of the current observations.
+    void log_update(const Eigen::Ref<const Eigen::MatrixXd>& Kt_m, const std::vector<uint32_t>& observers);
+
+    // PUBLISHING
+    /// \brief The number of iterations performed.
+    uint64_t m_iterations;
+    /// \brief The shared memory state publisher.
+    std::unique_ptr<shm_publisher_t> m_publisher;
+    /// \brief The published covariance with any deferred propagation applied, so publishing does not flush the filter.
+    Eigen::MatrixXd m_publish_P;
+
+    // FRIENDS
+    friend class imm_t;
 };
 
 }
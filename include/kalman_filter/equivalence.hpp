@@ -0,0 +1,92 @@
+/// \file kalman_filter/equivalence.hpp
+/// \brief Defines the kalman_filter::equivalence_t class.
+#ifndef KALMAN_FILTER___EQUIVALENCE_H
+#define KALMAN_FILTER___EQUIVALENCE_H
+
+#include <kalman_filter/sweep.hpp>
+
+namespace kalman_filter {
+
+/// \brief The phases of a filter iteration.
+enum class phase_t
+{
+    /// \brief The state and covariance prediction.
+    PREDICT = 0,
+    /// \brief The observation update.
+    UPDATE = 1
+};
+
+/// \brief The result of comparing a candidate filter against a reference filter.
+struct equivalence_report_t
+{
+    /// \brief Indicates if the trajectories matched within tolerance at every step.
+    bool equivalent;
+    /// \brief The number of steps compared, including the first divergent step.
+    uint32_t n_steps;
+    /// \brief The first divergent step. Only valid if the filters are not equivalent.
+    uint32_t step;
+    /// \brief The phase of the first divergent step. Only valid if the filters are not equivalent.
+    phase_t phase;
+    /// \brief Describes the first divergence (the diverging element, or the error thrown by one of the filters).
+    std::string description;
+    /// \brief The largest absolute difference between the state vectors over all compared phases.
+    double_t max_state_error;
+    /// \brief The largest absolute difference between the covariance matrices over all compared phases.
+    double_t max_covariance_error;
+};
+
+/// \brief Checks that an optimized filter reproduces a reference filter.
+/// \details The reference and candidate filters replay the same recording side by side. After the predict and update
+/// phase of every step, x and P of both filters are compared element-wise. The comparison stops at the first element
+/// that differs by more than absolute_tolerance + relative_tolerance * max(|reference|, |candidate|). P is copied with
+/// covariance(P), so deferred covariance propagation of lazy filters is compared without being flushed.
+class equivalence_t
+{
+public:
+    // TYPES
+    /// \brief A function called on both filters before each step is replayed.
+    /// \details Called as step_function(filter, step), for example to set inputs or discretize a model for the step.
+    typedef std::function<void(base_t&, uint32_t)> step_function_t;
+
+    // CONSTRUCTORS
+    /// \brief Instantiates a new equivalence_t object.
+    /// \param absolute_tolerance The absolute tolerance of each element. DEFAULT = 1E-9
+    /// \param relative_tolerance The relative tolerance of each element. DEFAULT = 1E-9
+    equivalence_t(double_t absolute_tolerance = 1E-9, double_t relative_tolerance = 1E-9);
+
+    // METHODS
+    /// \brief Replays a recording on a reference and a candidate filter and compares their trajectories.
+    /// \param reference The reference filter. Must be in the same initial state as the candidate.
+    /// \param candidate The candidate filter. Must have the same dimensions as the reference.
+    /// \param recording The recording to replay.
+    /// \param report (OUTPUT) The comparison result.
+    /// \returns TRUE if the filters are equivalent, otherwise FALSE.
+    /// \note Both filters are iterated by the replay.
+    bool compare(base_t& reference, base_t& candidate, const recording_t& recording, equivalence_report_t& report) const;
+
+    // PARAMETERS
+    /// \brief The absolute tolerance of each element.
+    double_t absolute_tolerance;
+    /// \brief The relative tolerance of each element.
+    double_t relative_tolerance;
+    /// \brief The function called on both filters before each step is replayed. May be empty.
+    step_function_t step_function;
+
+private:
+    // METHODS
+    /// \brief Compares the state and covariance of both filters.
+    /// \param reference The reference filter.
+    /// \param candidate The candidate filter.
+    /// \param report (OUTPUT) The report to update with the largest differences and any divergence.
+    /// \returns TRUE if all elements match within tolerance, otherwise FALSE.
+    bool compare_phase(const base_t& reference, const base_t& candidate, equivalence_report_t& report) const;
+    /// \brief Indicates if two elements match within tolerance.
+    /// \param a The first element.
+    /// \param b The second element.
+    /// \returns TRUE if the elements match, otherwise FALSE.
+    bool match(double_t a, double_t b) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,138 @@
+/// \file kalman_filter/imm.hpp
+/// \brief Defines the kalman_filter::imm_t class.
+#ifndef KALMAN_FILTER___IMM_H
+#define KALMAN_FILTER___IMM_H
+
+#include <kalman_filter/base.hpp>
+#include <kalman_filter/scheduler.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace kalman_filter {
+
+/// \brief An Interacting Multiple Model (IMM) estimator.
+/// \details The IMM runs a bank of mode filters (kf_t, ukf_t, ukfa_t) over a shared observation stream,
+/// mixing their estimates according to a Markov mode transition model.
+class imm_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new imm_t object.
+    /// \param modes The mode filters to run. All modes must have the same dimensions.
+    /// \note The mode filters are not owned by the IMM and must outlive it.
+    imm_t(const std::vector<base_t*>& modes);
+    /// \brief The IMM is not copyable, as its modes read the IMM's shared observation stream.
+    imm_t(const imm_t&) = delete;
+    /// \brief The IMM is not copyable, as its modes read the IMM's shared observation stream.
+    imm_t& operator=(const imm_t&) = delete;
+    ~imm_t();
+
+    // FILTER METHODS
+    /// \brief Mixes the mode estimates, iterates each mode, and updates the mode probabilities.
+    void iterate();
+    /// \brief Adds a new observation to all modes of the filter.
+    /// \param observer_index The index of the observer that made the observation.
+    /// \param observation The value of the observation.
+    /// \details The observation is stored once and shared by all modes.
+    void new_observation(uint32_t observer_index, double_t observation);
+    /// \brief Adds a batch of new observations to all modes of the filter.
+    /// \param observer_indices The indices of the observers that made the observations.
+    /// \param observations The values of the observations.
+    /// \param count The number of observations in the batch.
+    void new_observations(const uint32_t* observer_indices, const double_t* observations, uint32_t count);
+    /// \brief Adds new observations from a contiguous range of observers to all modes of the filter.
+    /// \param first_observer_index The index of the observer that made the first observation.
+    /// \param observations The values of the observations, ordered by observer index.
+    /// \param count The number of observations in the range.
+    void new_observations(uint32_t first_observer_index, const double_t* observations, uint32_t count);
+    /// \brief Adds a new observation to all modes of the filter with its own noise variance.
+    /// \param observer_index The index of the observer that made the observation.
+    /// \param observation The value of the observation.
+    /// \param variance The noise variance of the observation.
+    void new_observation(uint32_t observer_index, double_t observation, double_t variance);
+    /// \brief Adds new observations from a contiguous range of observers to all modes of the filter with their own noise covariance.
+    /// \param first_observer_index The index of the observer that made the first observation.
+    /// \param observations The values of the observations, ordered by observer index.
+    /// \param covariance The noise covariance of the observations.
+    void new_observations(uint32_t first_observer_index, const Eigen::VectorXd& observations, const Eigen::MatrixXd& covariance);
+    /// \brief Enables or disables averaging of multiple observations per observer between iterations.
+    /// \param enabled TRUE to fuse all observations made by an observer, FALSE to keep only the latest.
+    void set_observation_averaging(bool enabled);
+
+    // PARAMETERS
+    /// \brief The Markov mode transition matrix.
+    /// \details M(i,j) is the probability of switching from mode i to mode j. Rows must sum to one.
+    Eigen::MatrixXd M;
+    /// \brief Enables running the mode iterations in parallel threads.
+    /// \details The threads are started by the first parallel iteration and reused until the IMM is destroyed.
+    bool parallel;
+
+    // ACCESS
+    /// \brief Gets the number of modes.
+    /// \returns The number of modes.
+    uint32_t n_modes() const;
+    /// \brief Gets a mode filter.
+    /// \param index The index of the mode.
+    /// \returns A reference to the mode filter.
+    base_t& mode(uint32_t index) const;
+    /// \brief Sets the probabilities of each mode.
+    /// \param probabilities The probability of each mode. Must sum to one.
+    void set_mode_probabilities(const Eigen::VectorXd& probabilities);
+    /// \brief Gets the current probabilities of each mode.
+    /// \returns A reference to the mode probability vector.
+    const Eigen::VectorXd& mode_probabilities() const;
+    /// \brief Gets the combined state estimate of all modes.
+    /// \returns A reference to the combined state vector.
+    const Eigen::VectorXd& state() const;
+    /// \brief Gets the combined covariance estimate of all modes.
+    /// \returns A reference to the combined covariance matrix.
+    const Eigen::MatrixXd& covariance() const;
+
+private:
+    // DIMENSIONS
+    /// \brief The number of modes.
+    uint32_t n_m;
+    /// \brief The number of variables in each mode's state vector.
+    uint32_t n_x;
+
+    // MODES
+    /// \brief The mode filters.
+    std::vector<base_t*> m_modes;
+    /// \brief The observations shared by all modes.
+    observation_buffer_t m_observations;
+    /// \brief The scheduler that iterates the modes in parallel, created by the first parallel iteration.
+    std::unique_ptr<scheduler_t> m_scheduler;
+
+    // STORAGE: PROBABILITIES
+    /// \brief The mode probability vector.
+    Eigen::VectorXd mu;
+    /// \brief The predicted mode probability vector.
+    Eigen::VectorXd c;
+    /// \brief The mixing probability matrix.
+    Eigen::MatrixXd W;
+    /// \brief The log-likelihood of each mode's update.
+    Eigen::VectorXd l;
+
+    // STORAGE: ESTIMATES
+    /// \brief The mixed initial state of each mode.
+    std::vector<Eigen::VectorXd> x0;
+    /// \brief The mixed initial covariance of each mode.
+    std::vector<Eigen::MatrixXd> P0;
+    /// \brief The combined state estimate.
+    Eigen::VectorXd x;
+    /// \brief The combined covariance estimate.
+    Eigen::MatrixXd P;
+
+    // STORAGE: TEMPORARIES
+    /// \brief A temporary vector of size n_x.
+    Eigen::VectorXd t_x;
+
+    // METHODS
+    /// \brief Combines the mode estimates into a single estimate.
+    void combine();
+};
+
+}
+
+#endif
@@ -20,10 +20,43 @@ public:
     /// \param n_observers The number of state observers.
     kf_t(uint32_t n_variables, uint32_t n_inputs, uint32_t n_observers);
 
+    // CLONING
+    std::unique_ptr<base_t> clone() const override;
+
     // FILTER METHODS
-    void iterate() override;
+    void predict() override;
+    void update() override;
+    void predicted_observation(Eigen::VectorXd& z, Eigen::MatrixXd& S) const override;
+    void forecast(uint32_t horizon, std::vector<Eigen::VectorXd>& states, std::vector<Eigen::MatrixXd>& covariances) const override;
     /// \brief Updates an input in the control input model.
     void new_input(uint32_t input_index, double_t input);
+    /// \brief Updates an input in the control input model without throwing exceptions.
+    /// \param input_index The index of the input to update.
+    /// \param input The value of the input.
+    /// \returns The status of the operation.
+    status_t try_new_input(uint32_t input_index, double_t input) noexcept;
+    /// \brief Enables or disables lazy covariance prediction.
+    /// \param enabled TRUE to defer covariance prediction during iterations without observations.
+    /// \details While enabled, iterations without observations only predict the state mean. The deferred
+    /// covariance prediction is applied in O(log k) matrix products when an observation arrives or P is accessed.
+    /// \note Deferral restarts whenever A or Q change between iterations.
+    void set_lazy_covariance(bool enabled);
+
+    // CONTINUOUS MODEL
+    /// \brief Sets a continuous-time state model to discretize from.
+    /// \param F The continuous state matrix (n_variables x n_variables).
+    /// \param G The continuous input matrix (n_variables x n_inputs).
+    /// \param Qc The continuous process noise spectral density (n_variables x n_variables).
+    /// \param cache_size The number of discretizations to cache.
+    /// \details The model is x' = F*x + G*u + w, where w is white noise with spectral density Qc.
+    void set_continuous_model(const Eigen::MatrixXd& F, const Eigen::MatrixXd& G, const Eigen::MatrixXd& Qc, uint32_t cache_size = 8);
+    /// \brief Discretizes the continuous-time model into A, B, and Q for a sample interval.
+    /// \param dt The sample interval.
+    /// \details The discretization uses the matrix exponential (Van Loan's method). Results are cached per dt,
+    /// so repeating sample intervals only copy the cached matrices. Intervals within a relative 1e-9 of a
+    /// cached interval use the cached result.
+    /// \note The input is assumed constant over the interval (zero order hold).
+    void discretize(double_t dt);
 
     // MODEL
     /// \brief The state transition model matrix.
@@ -37,6 +70,18 @@ public:
     /// \brief Gets the number of inputs in the state model.
     uint32_t n_inputs() const;
 
+protected:
+    // CHECKPOINTING
+    filter_type_t filter_type() const override;
+    void checkpoint_fields(std::vector<std::pair<double_t*, uint32_t>>& fields) override;
+    void checkpoint_fields(std::vector<std::pair<const double_t*, uint32_t>>& fields) const override;
+
+    // LAZY COVARIANCE
+    void flush_covariance() override;
+    void discard_covariance() override;
+    void flushed_covariance(Eigen::MatrixXd& P_out) const override;
+    bool covariance_deferred() const override;
+
 private:
     // DIMENSIONS
     /// \brief The number of inputs in the state model.
@@ -52,6 +97,76 @@ private:
     /// \brief A temporary matrix of size n_z,n_x.
     Eigen::MatrixXd t_zx;
 
+    // STORAGE: QUERIES
+    // NOTE: Const queries reuse this storage, so they must not be called concurrently on the same filter.
+    /// \brief The covariance with deferred propagation applied, used by queries.
+    mutable Eigen::MatrixXd q_P;
+    /// \brief A temporary vector of size n_x, used by queries.
+    mutable Eigen::VectorXd q_x;
+    /// \brief A temporary matrix of size n_x,n_x, used by queries.
+    mutable Eigen::MatrixXd q_xx;
+    /// \brief A temporary matrix of size n_z,n_x, used by queries.
+    mutable Eigen::MatrixXd q_zx;
+
+    // STORAGE: LAZY COVARIANCE
+    /// \brief Indicates if covariance prediction is deferred during iterations without observations.
+    bool m_lazy;
+    /// \brief The number of deferred covariance predictions.
+    uint32_t m_deferred;
+    /// \brief The state transition matrix used for the deferred predictions.
+    Eigen::MatrixXd l_A;
+    /// \brief The process covariance matrix used for the deferred predictions.
+    Eigen::MatrixXd l_Q;
+    /// \brief The accumulated state transition of the deferred predictions.
+    Eigen::MatrixXd l_Phi;
+    /// \brief The accumulated process covariance of the deferred predictions.
+    Eigen::MatrixXd l_Qk;
+    /// \brief The repeatedly squared state transition.
+    Eigen::MatrixXd l_Phi_s;
+    /// \brief The repeatedly squared process covariance.
+    Eigen::MatrixXd l_Q_s;
+    /// \brief Composes the deferred predictions into a single state transition and process covariance.
+    /// \param Phi (OUTPUT) The composed state transition.
+    /// \param Qk (OUTPUT) The composed process covariance.
+    /// \param Phi_s (OUTPUT) Storage for the repeatedly squared state transition.
+    /// \param Q_s (OUTPUT) Storage for the repeatedly squared process covariance.
+    /// \param t (OUTPUT) A temporary matrix of size n_x,n_x.
+    void compose_predictions(Eigen::MatrixXd& Phi, Eigen::MatrixXd& Qk, Eigen::MatrixXd& Phi_s, Eigen::MatrixXd& Q_s, Eigen::MatrixXd& t) const;
+
+    // STORAGE: CONTINUOUS MODEL
+    /// \brief A cached discretization of the continuous model.
+    struct discretization_t
+    {
+        /// \brief The sample interval of the discretization.
+        double_t dt;
+        /// \brief The discrete state transition matrix.
+        Eigen::MatrixXd A;
+        /// \brief The discrete control input matrix.
+        Eigen::MatrixXd B;
+        /// \brief The discrete process covariance matrix.
+        Eigen::MatrixXd Q;
+    };
+    /// \brief The continuous state matrix.
+    Eigen::MatrixXd c_F;
+    /// \brief The continuous input matrix.
+    Eigen::MatrixXd c_G;
+    /// \brief The continuous process noise spectral density.
+    Eigen::MatrixXd c_Qc;
+    /// \brief The Van Loan block matrix to exponentiate.
+    Eigen::MatrixXd c_M;
+    /// \brief The exponentiated Van Loan block matrix.
+    Eigen::MatrixXd c_E;
+    /// \brief The input block matrix to exponentiate.
+    Eigen::MatrixXd c_Mu;
+    /// \brief The exponentiated input block matrix.
+    Eigen::MatrixXd c_Eu;
+    /// \brief The discretization cache.
+    std::vector<discretization_t> m_cache;
+    /// \brief The number of valid entries in the discretization cache.
+    uint32_t m_cache_count;
+    /// \brief The next discretization cache entry to replace.
+    uint32_t m_cache_next;
+
     // Hide base class protected members.
     // NOTE: State variable and covariance access is still protected.
     using base_t::n_x;
@@ -61,6 +176,7 @@ private:
     using base_t::C;
     using base_t::t_xx;
     using base_t::has_observations;
+    using base_t::add_observation_noise;
     using base_t::masked_kalman_update;
 };
 
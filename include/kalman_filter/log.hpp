@@ -0,0 +1,284 @@
+/// \file kalman_filter/log.hpp
+/// \brief Defines the kalman_filter::log_writer_t and kalman_filter::log_reader_t classes.
+#ifndef KALMAN_FILTER___LOG_H
+#define KALMAN_FILTER___LOG_H
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace kalman_filter {
+
+/// \brief Configures which values a filter logs, how often, and how the log is stored.
+/// \details By default every predicted state, observation, and estimated state is logged every iteration to a
+/// single CSV file, formatted and written by the filter thread. Matrices are logged to a separate binary file.
+struct log_config_t
+{
+    /// \brief Instantiates a log_config_t with default values.
+    log_config_t();
+
+    // COLUMNS
+    /// \brief Enables the iteration index column (iteration), written first as an integer. DEFAULT = FALSE
+    /// \details Required by replay_t, which uses it to detect skipped iterations.
+    bool iteration;
+    /// \brief The indices of the state variables to log. Left empty to log all state variables.
+    std::vector<uint32_t> states;
+    /// \brief The indices of the observers to log. Left empty to log all observers.
+    std::vector<uint32_t> observers;
+    /// \brief Enables the predicted state columns (xp_i). DEFAULT = TRUE
+    bool predicted_state;
+    /// \brief Enables the predicted and actual observation columns (zp_j, za_j). DEFAULT = TRUE
+    bool observations;
+    /// \brief Enables the estimated state columns (xe_i). DEFAULT = TRUE
+    bool estimated_state;
+    /// \brief Enables the estimated covariance diagonal columns (Pd_i). DEFAULT = FALSE
+    bool covariance;
+    /// \brief Enables the innovation columns (zd_j = za_j - zp_j). DEFAULT = FALSE
+    bool innovations;
+    /// \brief Enables the Kalman gain columns (K_i_j) of the selected states and observers. DEFAULT = FALSE
+    bool gains;
+
+    // MATRICES
+    /// \brief Enables the packed lower triangle of P over the selected states (P_i_j, i >= j). DEFAULT = FALSE
+    bool covariance_matrix;
+    /// \brief Enables the packed lower triangle of the innovation covariance S over the selected observers
+    /// (S_j_k, j >= k). DEFAULT = FALSE
+    bool innovation_covariance;
+    /// \brief Enables the Kalman gain K of the selected states and observers (K_i_j). DEFAULT = FALSE
+    bool gain_matrix;
+    /// \brief The file of the matrix log. Left empty to replace the extension of the log file with ".bin".
+    /// \details Matrices are written to a separate compressed binary log, one row for each row of the main log, so
+    /// they are never formatted as text. The storage settings apply to both logs.
+    std::string matrix_file;
+
+    // DECIMATION
+    /// \brief Logs every Nth eligible iteration. DEFAULT = 1
+    uint32_t decimation;
+    /// \brief Only iterations that performed an update are eligible. DEFAULT = FALSE
+    bool updates_only;
+
+    // STORAGE
+    /// \brief Stores the log in the compressed binary format instead of CSV. DEFAULT = FALSE
+    /// \details Each column is XOR encoded against its value in the previous row (Gorilla compression), so slowly
+    /// changing and repeated values take only a few bits. Read compressed logs with log_reader_t.
+    bool compress;
+    /// \brief Formats, compresses, and writes the log on a background thread. DEFAULT = FALSE
+    /// \details The filter thread only copies each row into a buffer. If the background thread falls behind by
+    /// more than the buffered rows, the filter thread waits for a buffer to be written.
+    bool background;
+    /// \brief Starts a new file once the current file reaches this size in bytes, or zero to disable. DEFAULT = 0
+    uint64_t rotate_size;
+    /// \brief Starts a new file once the current file is this old in seconds, or zero to disable. DEFAULT = 0
+    double_t rotate_interval;
+    /// \brief The number of most recent files kept when rotating, or zero to keep all files. DEFAULT = 0
+    uint32_t rotate_files;
+    /// \brief The size of each row buffer in bytes. DEFAULT = 64 KiB
+    uint32_t buffer_size;
+};
+
+/// \brief Writes rows of numbers to a CSV or compressed log file.
+/// \details Rows are collected in buffers of whole rows. Each full buffer is formatted or compressed and written
+/// to the file in one chunk, either by the calling thread or by a background thread. When rotation is enabled,
+/// files are named by inserting a sequence number before the extension (e.g. log.0.csv, log.1.csv), and every
+/// file starts with its own header.
+class log_writer_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new log_writer_t object.
+    log_writer_t();
+    ~log_writer_t();
+
+    // METHODS
+    /// \brief Opens a log and writes its header.
+    /// \param file The file to write.
+    /// \param columns The names of the columns.
+    /// \param config The storage configuration.
+    /// \param precision The number of digits written after the decimal point in CSV files. DEFAULT = 6
+    /// \param integer_columns Flags the columns written as integers in CSV files instead of in fixed notation. Left
+    /// empty to write all columns in fixed notation.
+    /// \returns TRUE if the file was opened, otherwise FALSE.
+    bool open(const std::string& file, const std::vector<std::string>& columns, const log_config_t& config, uint8_t precision = 6, const std::vector<bool>& integer_columns = std::vector<bool>());
+    /// \brief Writes all buffered rows and closes the log.
+    void close();
+    /// \brief Indicates if a log is open.
+    /// \returns TRUE if a log is open, otherwise FALSE.
+    bool is_open() const;
+    /// \brief Writes all complete buffered rows.
+    void flush();
+
+    // ROWS
+    /// \brief Appends a number to the current row.
+    /// \param value The number to append. missing() is written as an empty CSV column, and any other NaN as "nan".
+    void write(double_t value);
+    /// \brief Ends the current row.
+    /// \details Missing columns are filled with missing().
+    void end_row();
+
+    // MISSING VALUES
+    /// \brief Gets the value that marks a missing column.
+    /// \returns A NaN with a payload reserved for missing columns.
+    static double_t missing();
+    /// \brief Checks if a value marks a missing column.
+    /// \param value The value to check.
+    /// \returns TRUE if the value has the bit pattern of missing(), otherwise FALSE.
+    static bool is_missing(double_t value);
+
+private:
+    // CONFIGURATION
+    /// \brief The file name.
+    std::string m_file_name;
+    /// \brief The storage configuration.
+    log_config_t m_config;
+    /// \brief The number of digits written after the decimal point.
+    uint8_t m_precision;
+    /// \brief Flags the columns written as integers.
+    std::vector<bool> m_integer_columns;
+    /// \brief The CSV header line.
+    std::string m_header;
+    /// \brief The number of columns.
+    uint32_t n_c;
+    /// \brief The number of rows in each buffer.
+    uint32_t n_r;
+    /// \brief Indicates if a log is open.
+    bool m_open;
+
+    // BUFFERS
+    /// \brief A buffer of complete rows.
+    struct chunk_t
+    {
+        /// \brief The row values, in row-major order.
+        std::vector<double_t> values;
+        /// \brief The number of complete rows.
+        uint32_t n_rows;
+    };
+    /// \brief The row buffers.
+    std::vector<chunk_t> m_chunks;
+    /// \brief The buffer currently being filled.
+    chunk_t* m_current;
+    /// \brief The number of values written to the current row.
+    uint32_t m_column;
+
+    // BACKGROUND
+    /// \brief The background writer thread, if enabled.
+    std::thread m_thread;
+    /// \brief Protects the buffer queues.
+    std::mutex m_mutex;
+    /// \brief Signals that a buffer was queued or the writer is stopping.
+    std::condition_variable m_queued;
+    /// \brief Signals that a buffer was written.
+    std::condition_variable m_written;
+    /// \brief The buffers waiting to be written.
+    std::deque<chunk_t*> m_full;
+    /// \brief The buffers available for filling.
+    std::deque<chunk_t*> m_free;
+    /// \brief Indicates if the background writer should stop once all buffers are written.
+    bool m_stop;
+
+    // OUTPUT
+    /// \brief The current file stream.
+    std::ofstream m_file;
+    /// \brief The sequence number of the current file.
+    uint64_t m_segment;
+    /// \brief The number of bytes written to the current file.
+    uint64_t m_segment_size;
+    /// \brief The time the current file was opened.
+    std::chrono::steady_clock::time_point m_segment_start;
+    /// \brief The formatted or compressed output of a buffer.
+    std::vector<char> m_output;
+
+    // METHODS
+    /// \brief Queues the current buffer for writing and gets an empty buffer.
+    void submit();
+    /// \brief Formats or compresses a buffer and writes it to the file.
+    /// \param chunk The buffer to write.
+    void write_chunk(chunk_t& chunk);
+    /// \brief Formats a buffer as CSV rows into the output.
+    /// \param chunk The buffer to format.
+    void format(const chunk_t& chunk);
+    /// \brief Compresses a buffer into a block of the compressed format in the output.
+    /// \param chunk The buffer to compress.
+    void compress(const chunk_t& chunk);
+    /// \brief Opens the next file and writes its header.
+    /// \returns TRUE if the file was opened, otherwise FALSE.
+    bool open_segment();
+    /// \brief Gets the name of a file.
+    /// \param segment The sequence number of the file.
+    /// \returns The file name.
+    std::string segment_name(uint64_t segment) const;
+    /// \brief The background writer thread.
+    void run();
+};
+
+/// \brief Reads rows from a CSV or compressed log file.
+class log_reader_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new log_reader_t object.
+    log_reader_t();
+
+    // METHODS
+    /// \brief Opens a log and reads its header.
+    /// \param file The file to read. The format is detected from the file contents.
+    /// \returns TRUE if the file was opened and has a valid header, otherwise FALSE.
+    bool open(const std::string& file);
+    /// \brief Reads the next row.
+    /// \param row (OUTPUT) The row values. Empty CSV columns are read as log_writer_t::missing(). Existing storage is reused.
+    /// \returns TRUE if a row was read, otherwise FALSE at the end of the file.
+    bool read(std::vector<double_t>& row);
+    /// \brief Closes the file.
+    void close();
+
+    // ACCESS
+    /// \brief Gets the names of the columns.
+    /// \returns A reference to the column names.
+    const std::vector<std::string>& columns() const;
+    /// \brief Gets the index of a column.
+    /// \param name The name of the column.
+    /// \returns The index of the column, or -1 if the column does not exist.
+    int32_t column(const std::string& name) const;
+    /// \brief Indicates if the file is in the compressed format.
+    /// \returns TRUE if the file is compressed, otherwise FALSE.
+    bool compressed() const;
+
+private:
+    /// \brief The file stream.
+    std::ifstream m_file;
+    /// \brief The column names.
+    std::vector<std::string> m_columns;
+    /// \brief Indicates if the file is in the compressed format.
+    bool m_compressed;
+    /// \brief A line of a CSV file.
+    std::string m_line;
+
+    // COMPRESSED BLOCKS
+    /// \brief The current block.
+    std::vector<uint8_t> m_block;
+    /// \brief The number of rows remaining in the current block.
+    uint32_t m_rows;
+    /// \brief The read position in the current block, in bits.
+    uint64_t m_bit;
+    /// \brief The previous value of each column, as bits.
+    std::vector<uint64_t> m_previous;
+    /// \brief The leading zeros of the previous XOR window of each column.
+    std::vector<uint32_t> m_leading;
+    /// \brief The trailing zeros of the previous XOR window of each column.
+    std::vector<uint32_t> m_trailing;
+
+    // METHODS
+    /// \brief Reads bits from the current block.
+    /// \param count The number of bits to read (at most 64).
+    /// \returns The bits, most significant first.
+    uint64_t read_bits(uint32_t count);
+};
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+/// \file kalman_filter/pool.hpp
+/// \brief Defines the kalman_filter::pool_t class.
+#ifndef KALMAN_FILTER___POOL_H
+#define KALMAN_FILTER___POOL_H
+
+#include <kalman_filter/base.hpp>
+
+namespace kalman_filter {
+
+/// \brief A pool of recycled filters cloned from a prototype.
+/// \details Filters released to the pool keep their storage and are reset to the prototype when acquired again,
+/// so churning filters does not allocate once the pool has grown to its working size. Resetting copies the
+/// prototype's checkpoint fields (state, covariances, models, and parameters) into the recycled filter, then clears
+/// its pending observations, deferred covariance propagation, and statistics with base_t::reset().
+class pool_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new pool_t object.
+    /// \param prototype The filter to clone. The filter must implement clone().
+    /// \param reserve The number of filters to allocate up front.
+    pool_t(const base_t& prototype, uint32_t reserve = 0);
+
+    // METHODS
+    /// \brief Takes a filter from the pool, allocating a new one if none are available.
+    /// \returns A filter in the state of the prototype, without pending observations. The filter remains owned by
+    /// the pool.
+    base_t* acquire();
+    /// \brief Returns a filter to the pool.
+    /// \param filter The filter to return. Must have been acquired from this pool.
+    /// \note Any pending observations are removed when the filter is acquired again.
+    void release(base_t* filter);
+
+    // ACCESS
+    /// \brief Gets the number of filters allocated by the pool.
+    /// \returns The number of allocated filters.
+    uint32_t n_allocated() const;
+    /// \brief Gets the number of filters available in the pool.
+    /// \returns The number of available filters.
+    uint32_t n_available() const;
+
+private:
+    /// \brief The prototype filter.
+    std::unique_ptr<base_t> m_prototype;
+    /// \brief The checkpoint of the prototype filter.
+    std::vector<uint8_t> m_checkpoint;
+    /// \brief All allocated filters.
+    std::vector<std::unique_ptr<base_t>> m_filters;
+    /// \brief The filters available for acquisition.
+    std::vector<base_t*> m_available;
+};
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+/// \file kalman_filter/replay.hpp
+/// \brief Defines the kalman_filter::replay_t class.
+#ifndef KALMAN_FILTER___REPLAY_H
+#define KALMAN_FILTER___REPLAY_H
+
+#include <kalman_filter/sweep.hpp>
+
+namespace kalman_filter {
+
+/// \brief The result of replaying a log on a filter.
+struct replay_report_t
+{
+    /// \brief Indicates if the filter replayed all steps without throwing.
+    bool valid;
+    /// \brief The error reported by the filter if the replay is not valid.
+    std::string error;
+    /// \brief Indicates if the estimated state matched the logged estimated state within tolerance at every step.
+    bool matched;
+    /// \brief The number of steps replayed, including the step that failed.
+    uint32_t n_steps;
+    /// \brief The first step that did not match. Only valid if the replay did not match.
+    uint32_t step;
+    /// \brief Describes the first mismatching element. Only valid if the replay did not match.
+    std::string description;
+    /// \brief The largest absolute difference between the estimated and logged state over all steps.
+    double_t max_state_error;
+    /// \brief The wall clock time of the replay in seconds.
+    double_t runtime;
+    /// \brief The number of iterations per second.
+    double_t rate;
+};
+
+/// \brief Replays a filter log on a filter at full speed, as an end-to-end benchmark and regression check.
+/// \details The actual observations (za_j columns) of each logged iteration are loaded into memory and fed to the
+/// filter with new_observations() and iterate(), without waiting between iterations. After each iteration the
+/// estimated state is compared against the logged estimated state (xe_i columns). An element matches if it differs by
+/// at most absolute_tolerance + relative_tolerance * |logged|. The log must be written with log_config_t::iteration
+/// and contain every iteration of every observer: logs with decimation, updates_only, or an observer subset are
+/// rejected when they are loaded or replayed, using the iteration column and the za_j columns. Observations are replayed with the filter's default observation
+/// noise. CSV logs round observations and estimates to their precision, so compressed logs should be used for exact
+/// replays.
+class replay_t
+{
+public:
+    // TYPES
+    /// \brief A function called before each step is replayed.
+    /// \details Called as step_function(filter, step), for example to set inputs or discretize a model for the step.
+    typedef std::function<void(base_t&, uint32_t)> step_function_t;
+
+    // CONSTRUCTORS
+    /// \brief Instantiates a new replay_t object.
+    /// \param absolute_tolerance The absolute tolerance of each element. DEFAULT = 1E-4
+    /// \param relative_tolerance The relative tolerance of each element. DEFAULT = 1E-6
+    replay_t(double_t absolute_tolerance = 1E-4, double_t relative_tolerance = 1E-6);
+
+    // METHODS
+    /// \brief Loads a CSV or compressed log written by base_t.
+    /// \param log_file The log to load. For rotated logs, the file name passed to start_log (e.g. log.csv), which
+    /// loads all remaining numbered files (log.N.csv) in order.
+    /// \returns TRUE if the log was loaded, otherwise FALSE if it could not be read or is incomplete.
+    /// \details A log is incomplete if it has no iteration column (log_config_t::iteration) or no za_j columns, skips iterations (decimation,
+    /// updates_only, or a missing rotated file), or does not log observers 0 to N-1. The loaded log is left unchanged
+    /// if loading fails.
+    bool load(const std::string& log_file);
+    /// \brief Loads consecutive files of a rotated CSV or compressed log written by base_t.
+    /// \param log_files The files to load, in order. All files must have the same columns.
+    /// \returns TRUE if the log was loaded, otherwise FALSE if a file could not be read or the log is incomplete.
+    bool load(const std::vector<std::string>& log_files);
+    /// \brief Replays the loaded log on a filter.
+    /// \param filter The filter to replay on. Must be in the same state as the filter that wrote the log was at the
+    /// first logged iteration, and have as many observers as the log.
+    /// \param report (OUTPUT) The replay result.
+    /// \returns TRUE if the filter replayed all steps and matched the log, otherwise FALSE.
+    bool run(base_t& filter, replay_report_t& report) const;
+
+    // PARAMETERS
+    /// \brief The absolute tolerance of each element.
+    double_t absolute_tolerance;
+    /// \brief The relative tolerance of each element.
+    double_t relative_tolerance;
+    /// \brief The function called before each step is replayed. May be empty.
+    step_function_t step_function;
+
+    // ACCESS
+    /// \brief Gets the loaded observations.
+    /// \returns A reference to the recording of the loaded observations.
+    const recording_t& recording() const;
+    /// \brief Gets the state indices of the logged estimated state.
+    /// \returns A reference to the state indices.
+    const std::vector<uint32_t>& states() const;
+    /// \brief Gets the filter iteration of the first loaded step.
+    /// \returns The iteration index, which is non-zero if the log was started late or old rotated files were removed.
+    uint64_t first_iteration() const;
+
+private:
+    /// \brief The loaded observations.
+    recording_t m_recording;
+    /// \brief The state indices of the logged estimated state.
+    std::vector<uint32_t> m_states;
+    /// \brief The logged estimated states of all steps.
+    std::vector<double_t> m_estimates;
+    /// \brief The filter iteration of the first loaded step.
+    uint64_t m_first_iteration;
+};
+
+}
+
+#endif
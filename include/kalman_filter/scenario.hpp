@@ -0,0 +1,227 @@
+/// \file kalman_filter/scenario.hpp
+/// \brief Defines the kalman_filter::scenario_t class and the scenario stream format.
+#ifndef KALMAN_FILTER___SCENARIO_H
+#define KALMAN_FILTER___SCENARIO_H
+
+#include <kalman_filter/sweep.hpp>
+
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace kalman_filter {
+
+/// \brief The motion and observation models available for synthetic scenarios.
+enum class scenario_model_t
+{
+    /// \brief Constant velocity in n_dimensions, with position observers.
+    /// \details State: [position (n_dimensions), velocity (n_dimensions)]. Process noise is white acceleration.
+    CONSTANT_VELOCITY = 0,
+    /// \brief Constant acceleration in n_dimensions, with position observers.
+    /// \details State: [position, velocity, acceleration (n_dimensions each)]. Process noise is white jerk.
+    CONSTANT_ACCELERATION = 1,
+    /// \brief Planar coordinated turn, with x/y position observers.
+    /// \details State: [x, y, vx, vy, turn rate]. Process noise is white acceleration and turn rate.
+    COORDINATED_TURN = 2,
+    /// \brief Planar constant velocity target observed by n_dimensions bearing-only sensors.
+    /// \details State: [x, y, vx, vy]. Sensors are fixed on the x axis, spaced by sensor_spacing from the origin.
+    BEARING_ONLY = 3,
+    /// \brief A simple pendulum, with x/y bob position observers.
+    /// \details State: [angle, angular rate]. Process noise is white angular acceleration.
+    PENDULUM = 4
+};
+
+/// \brief The configuration of a synthetic scenario.
+struct scenario_config_t
+{
+    /// \brief Instantiates a scenario_config_t with default values.
+    scenario_config_t();
+
+    /// \brief The motion and observation model.
+    scenario_model_t model;
+    /// \brief The number of spatial dimensions (constant velocity/acceleration) or sensors (bearing-only).
+    uint32_t n_dimensions;
+    /// \brief The number of steps to generate.
+    uint32_t n_steps;
+    /// \brief The time between steps.
+    double_t dt;
+    /// \brief The random seed. Scenarios with the same configuration and seed are identical on all platforms.
+    uint64_t seed;
+    /// \brief The standard deviation of the process noise.
+    double_t process_noise;
+    /// \brief The standard deviation of the turn rate noise (coordinated turn).
+    double_t turn_rate_noise;
+    /// \brief The standard deviation of the observation noise.
+    double_t observation_noise;
+    /// \brief The spacing between bearing-only sensors.
+    double_t sensor_spacing;
+    /// \brief The pendulum length.
+    double_t length;
+    /// \brief The initial true state. Left empty to use the model's default.
+    Eigen::VectorXd x0;
+    /// \brief The number of steps between observations of each observer. Left empty to observe every step.
+    std::vector<uint32_t> periods;
+    /// \brief The probability that each observation is dropped. Left empty for no dropouts.
+    std::vector<double_t> dropouts;
+};
+
+/// \brief Writes a scenario to a streaming binary file.
+/// \details The file is a header followed by one record per step. Each record is the observation count (uint32),
+/// the observer indices (uint32 each), the observation values (double each), and the true state (double each).
+/// Records are written as they are generated, so scenarios of any length can be streamed to disk.
+class scenario_writer_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new scenario_writer_t object.
+    scenario_writer_t();
+
+    // METHODS
+    /// \brief Creates a scenario file and writes its header.
+    /// \param file The file to write.
+    /// \param n_variables The number of variables in the true state.
+    /// \param n_observers The number of observers.
+    /// \param dt The time between steps.
+    /// \returns TRUE if the file was opened, otherwise FALSE.
+    bool open(const std::string& file, uint32_t n_variables, uint32_t n_observers, double_t dt);
+    /// \brief Writes a step to the file.
+    /// \param observer_indices The indices of the observers that made the observations.
+    /// \param observations The values of the observations.
+    /// \param count The number of observations in the step.
+    /// \param truth The true state after the step.
+    void write(const uint32_t* observer_indices, const double_t* observations, uint32_t count, const Eigen::VectorXd& truth);
+    /// \brief Flushes and closes the file.
+    /// \returns TRUE if all data was written, otherwise FALSE.
+    bool close();
+
+private:
+    /// \brief The file stream.
+    std::ofstream m_file;
+    /// \brief The number of variables in the true state.
+    uint32_t n_x;
+};
+
+/// \brief Reads a scenario from a streaming binary file.
+class scenario_reader_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new scenario_reader_t object.
+    scenario_reader_t();
+
+    // METHODS
+    /// \brief Opens a scenario file and reads its header.
+    /// \param file The file to read.
+    /// \returns TRUE if the file was opened and is a scenario file, otherwise FALSE.
+    bool open(const std::string& file);
+    /// \brief Reads the next step from the file.
+    /// \param observer_indices (OUTPUT) The indices of the observers. Existing storage is reused.
+    /// \param observations (OUTPUT) The values of the observations. Existing storage is reused.
+    /// \param truth (OUTPUT) The true state after the step.
+    /// \returns TRUE if a step was read, otherwise FALSE at the end of the file.
+    bool read(std::vector<uint32_t>& observer_indices, std::vector<double_t>& observations, Eigen::VectorXd& truth);
+    /// \brief Reads all remaining steps into a recording.
+    /// \param recording (OUTPUT) The recording to append to. Must have the same number of observers as the file.
+    /// \returns The number of steps read.
+    uint32_t read(recording_t& recording);
+    /// \brief Closes the file.
+    void close();
+
+    // ACCESS
+    /// \brief Gets the number of variables in the true state.
+    /// \returns The number of variables.
+    uint32_t n_variables() const;
+    /// \brief Gets the number of observers.
+    /// \returns The number of observers.
+    uint32_t n_observers() const;
+    /// \brief Gets the time between steps.
+    /// \returns The time between steps.
+    double_t dt() const;
+
+private:
+    /// \brief The file stream.
+    std::ifstream m_file;
+    /// \brief The number of variables in the true state.
+    uint32_t n_x;
+    /// \brief The number of observers.
+    uint32_t n_z;
+    /// \brief The time between steps.
+    double_t m_dt;
+};
+
+/// \brief Generates ground truth trajectories and noisy multi-rate observations for a standard model.
+class scenario_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new scenario_t object.
+    /// \param config The scenario configuration.
+    scenario_t(const scenario_config_t& config);
+
+    // METHODS
+    /// \brief Generates the next step of the scenario.
+    /// \param observer_indices (OUTPUT) The indices of the observers that made observations. Existing storage is reused.
+    /// \param observations (OUTPUT) The values of the observations. Existing storage is reused.
+    /// \returns TRUE if a step was generated, otherwise FALSE once all steps have been generated.
+    /// \details The true state after the step is available from truth().
+    bool step(std::vector<uint32_t>& observer_indices, std::vector<double_t>& observations);
+    /// \brief Generates all remaining steps into a scenario file.
+    /// \param writer The open scenario writer.
+    void generate(scenario_writer_t& writer);
+    /// \brief Generates all remaining steps into a recording.
+    /// \param recording (OUTPUT) The recording to append to. Must have the same number of observers as the scenario.
+    void generate(recording_t& recording);
+
+    // ACCESS
+    /// \brief Gets the number of variables in the true state.
+    /// \returns The number of variables.
+    uint32_t n_variables() const;
+    /// \brief Gets the number of observers.
+    /// \returns The number of observers.
+    uint32_t n_observers() const;
+    /// \brief Gets the current true state.
+    /// \returns A reference to the true state.
+    const Eigen::VectorXd& truth() const;
+    /// \brief Gets the scenario configuration.
+    /// \returns A reference to the configuration.
+    const scenario_config_t& config() const;
+
+private:
+    /// \brief The scenario configuration.
+    scenario_config_t m_config;
+    /// \brief The number of variables in the true state.
+    uint32_t n_x;
+    /// \brief The number of observers.
+    uint32_t n_z;
+    /// \brief The number of steps generated.
+    uint32_t m_step;
+    /// \brief The true state.
+    Eigen::VectorXd x;
+    /// \brief The noise free observation of the true state.
+    Eigen::VectorXd z;
+
+    // RANDOM
+    /// \brief The random number engine.
+    /// \details The engine's output sequence is fully specified by the standard, unlike its distributions.
+    std::mt19937_64 m_engine;
+    /// \brief A cached second normal sample from the Box-Muller transform.
+    double_t m_normal;
+    /// \brief Indicates if a cached normal sample is available.
+    bool m_has_normal;
+
+    // METHODS
+    /// \brief Draws a uniform sample in [0, 1).
+    /// \returns The sample.
+    double_t uniform();
+    /// \brief Draws a standard normal sample.
+    /// \returns The sample.
+    double_t normal();
+    /// \brief Propagates the true state by one step.
+    void propagate();
+    /// \brief Calculates the noise free observation of the true state.
+    void observe();
+};
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+/// \file kalman_filter/scheduler.hpp
+/// \brief Defines the kalman_filter::scheduler_t class.
+#ifndef KALMAN_FILTER___SCHEDULER_H
+#define KALMAN_FILTER___SCHEDULER_H
+
+#include <kalman_filter/base.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace kalman_filter {
+
+/// \brief Iterates a fleet of filters in parallel on a work-stealing thread pool.
+/// \details Each call to iterate() seeds one task queue per thread, placing the filters in order of decreasing
+/// estimated cost onto the least loaded queue. Threads run their own queue from the most expensive filter down,
+/// and steal the cheapest remaining filters from other queues when their own queue is empty. The call returns once
+/// every filter has iterated.
+/// \note The calling thread participates as one of the threads. iterate() must not be called concurrently.
+class scheduler_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new scheduler_t object.
+    /// \param n_threads The number of threads to run filters on, including the calling thread.
+    /// DEFAULT = 0 uses the number of hardware threads.
+    scheduler_t(uint32_t n_threads = 0);
+    ~scheduler_t();
+
+    // METHODS
+    /// \brief Iterates all filters and waits for them to complete.
+    /// \param filters The filters to iterate. Each filter must appear only once.
+    /// \details If any filter throws, the remaining filters still iterate and the first exception is rethrown.
+    void iterate(const std::vector<base_t*>& filters);
+
+    // ACCESS
+    /// \brief Gets the number of threads, including the calling thread.
+    /// \returns The number of threads.
+    uint32_t n_threads() const;
+
+private:
+    // TYPES
+    /// \brief A task queue owned by one thread.
+    struct queue_t
+    {
+        /// \brief Protects the queue range.
+        std::mutex mutex;
+        /// \brief The filter indices, in order of decreasing cost.
+        std::vector<uint32_t> tasks;
+        /// \brief The index of the next task for the owning thread.
+        uint32_t begin;
+        /// \brief One past the index of the next task for stealing threads.
+        uint32_t end;
+        /// \brief The total estimated cost of the queue's tasks.
+        double_t load;
+    };
+
+    // THREADS
+    /// \brief The background threads.
+    std::vector<std::thread> m_threads;
+    /// \brief The task queue of each thread. Queue 0 belongs to the calling thread.
+    std::vector<std::unique_ptr<queue_t>> m_queues;
+
+    // SYNCHRONIZATION
+    /// \brief Protects the batch state.
+    std::mutex m_mutex;
+    /// \brief Signals the background threads that a new batch is available or that they must stop.
+    std::condition_variable m_start;
+    /// \brief Signals the calling thread that all threads have finished the batch.
+    std::condition_variable m_done;
+    /// \brief The current batch number.
+    uint64_t m_batch;
+    /// \brief Indicates if the background threads must stop.
+    bool m_stop;
+    /// \brief The number of threads still working on the current batch.
+    std::atomic<uint32_t> m_active;
+
+    // BATCH
+    /// \brief The filters of the current batch.
+    const std::vector<base_t*>* m_filters;
+    /// \brief The estimated cost of each filter in the current batch.
+    std::vector<double_t> m_costs;
+    /// \brief The filter indices in order of decreasing cost.
+    std::vector<uint32_t> m_order;
+    /// \brief The first exception thrown by a filter in the current batch.
+    std::exception_ptr m_exception;
+
+    // METHODS
+    /// \brief The main loop of a background thread.
+    /// \param index The index of the thread's queue.
+    void worker(uint32_t index);
+    /// \brief Runs tasks until all queues are empty.
+    /// \param index The index of the thread's queue.
+    void run(uint32_t index);
+    /// \brief Takes the next task from the thread's own queue, or steals one from another queue.
+    /// \param index The index of the thread's queue.
+    /// \param task (OUTPUT) The index of the filter to iterate.
+    /// \returns TRUE if a task was taken, otherwise FALSE if all queues are empty.
+    bool take(uint32_t index, uint32_t& task);
+};
+
+}
+
+#endif
@@ -0,0 +1,115 @@
+/// \file kalman_filter/shm.hpp
+/// \brief Defines the kalman_filter::shm_publisher_t and kalman_filter::shm_subscriber_t classes.
+#ifndef KALMAN_FILTER___SHM_H
+#define KALMAN_FILTER___SHM_H
+
+#include <eigen3/Eigen/Dense>
+
+#include <atomic>
+#include <string>
+
+#include <sys/types.h>
+
+namespace kalman_filter {
+
+/// \brief The header of a shared memory state segment.
+/// \details The header is followed by the state vector (n_variables doubles) and the column-major
+/// covariance matrix (n_variables^2 doubles). Writers and readers synchronize with a seqlock on the
+/// sequence counter: the sequence is odd while a write is in progress.
+struct shm_header_t
+{
+    /// \brief The magic number identifying the segment.
+    uint32_t magic;
+    /// \brief The segment format version.
+    uint32_t version;
+    /// \brief The number of variables in the state vector.
+    uint32_t n_variables;
+    /// \brief Reserved for alignment.
+    uint32_t reserved;
+    /// \brief The seqlock sequence counter.
+    std::atomic<uint64_t> sequence;
+    /// \brief The filter iteration count of the published state.
+    uint64_t iteration;
+    /// \brief The time the state was published, in nanoseconds since the epoch.
+    int64_t timestamp;
+};
+
+/// \brief Publishes a filter's state and covariance to a POSIX shared memory segment.
+class shm_publisher_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new shm_publisher_t object.
+    shm_publisher_t();
+    ~shm_publisher_t();
+
+    // METHODS
+    /// \brief Creates and maps the shared memory segment.
+    /// \param name The name of the shared memory segment (e.g. "/kalman_filter").
+    /// \param n_variables The number of variables in the state vector.
+    /// \returns TRUE if the segment was opened, otherwise FALSE if it already exists or could not be created.
+    /// \details A segment left behind by a publisher that did not close it must be removed (e.g. with shm_unlink)
+    /// before it can be opened again.
+    bool open(const std::string& name, uint32_t n_variables);
+    /// \brief Unmaps the shared memory segment, and removes it if its name still refers to this publisher's segment.
+    void close();
+    /// \brief Writes a new state and covariance to the shared memory segment.
+    /// \param x The state vector.
+    /// \param P The covariance matrix.
+    /// \param iteration The filter iteration count.
+    void publish(const Eigen::VectorXd& x, const Eigen::MatrixXd& P, uint64_t iteration);
+
+private:
+    /// \brief The name of the shared memory segment.
+    std::string m_name;
+    /// \brief The size of the shared memory segment in bytes.
+    size_t m_size;
+    /// \brief The mapped shared memory segment.
+    shm_header_t* m_header;
+    /// \brief The device of the created segment, which identifies it together with its inode.
+    dev_t m_device;
+    /// \brief The inode of the created segment.
+    ino_t m_inode;
+};
+
+/// \brief Reads a filter's state and covariance from a POSIX shared memory segment.
+class shm_subscriber_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new shm_subscriber_t object.
+    shm_subscriber_t();
+    ~shm_subscriber_t();
+
+    // METHODS
+    /// \brief Maps an existing shared memory segment as read-only.
+    /// \param name The name of the shared memory segment.
+    /// \returns TRUE if the segment was opened, otherwise FALSE.
+    bool open(const std::string& name);
+    /// \brief Unmaps the shared memory segment.
+    void close();
+    /// \brief Reads a consistent snapshot of the published state and covariance.
+    /// \param x (OUTPUT) The state vector.
+    /// \param P (OUTPUT) The covariance matrix.
+    /// \param iteration (OUTPUT) The filter iteration count of the snapshot.
+    /// \param timestamp (OUTPUT) The time the snapshot was published, in nanoseconds since the epoch.
+    /// \returns TRUE if a snapshot was read, otherwise FALSE if the segment is not open, nothing has been published,
+    /// or no consistent snapshot could be read within a bounded number of attempts (e.g. the publisher stopped
+    /// mid-write).
+    bool read(Eigen::VectorXd& x, Eigen::MatrixXd& P, uint64_t& iteration, int64_t& timestamp) const;
+
+    // ACCESS
+    /// \brief Gets the number of variables in the published state vector.
+    /// \returns The number of variables.
+    uint32_t n_variables() const;
+
+private:
+    /// \brief The size of the shared memory segment in bytes.
+    size_t m_size;
+    /// \brief The mapped shared memory segment.
+    const shm_header_t* m_header;
+};
+
+}
+
+#endif
@@ -0,0 +1,173 @@
+/// \file kalman_filter/sweep.hpp
+/// \brief Defines the kalman_filter::sweep_t class.
+#ifndef KALMAN_FILTER___SWEEP_H
+#define KALMAN_FILTER___SWEEP_H
+
+#include <kalman_filter/base.hpp>
+
+#include <functional>
+#include <string>
+
+namespace kalman_filter {
+
+/// \brief A recorded sequence of observations for offline replay.
+/// \details Each step holds the observations made before one filter iteration. Observations of all steps are
+/// stored contiguously, so a recording can be shared read-only by many replaying threads.
+class recording_t
+{
+public:
+    // CONSTRUCTORS
+    /// \brief Instantiates a new recording_t object.
+    /// \param n_observers The number of state observers.
+    recording_t(uint32_t n_observers);
+
+    // METHODS
+    /// \brief Appends a step to the recording.
+    /// \param observer_indices The indices of the observers that made the observations.
+    /// \param observations The values of the observations.
+    /// \param count The number of observations in the step. May be zero.
+    void add_step(const uint32_t* observer_indices, const double_t* observations, uint32_t count);
+    /// \brief Appends a step with a ground truth state to the recording.
+    /// \param observer_indices The indices of the observers that made the observations.
+    /// \param observations The values of the observations.
+    /// \param count The number of observations in the step. May be zero.
+    /// \param truth The true state after the step.
+    /// \note Either all steps or no steps must have a ground truth state.
+    void add_step(const uint32_t* observer_indices, const double_t* observations, uint32_t count, const Eigen::VectorXd& truth);
+    /// \brief Removes all steps.
+    void clear();
+
+    // ACCESS
+    /// \brief Gets the number of observers.
+    /// \returns The number of observers.
+    uint32_t n_observers() const;
+    /// \brief Gets the number of steps.
+    /// \returns The number of steps.
+    uint32_t n_steps() const;
+    /// \brief Gets the number of observations in a step.
+    /// \param step The index of the step.
+    /// \returns The number of observations.
+    uint32_t n_observations(uint32_t step) const;
+    /// \brief Gets the observer indices of a step.
+    /// \param step The index of the step.
+    /// \returns A pointer to n_observations(step) observer indices.
+    const uint32_t* observers(uint32_t step) const;
+    /// \brief Gets the observation values of a step.
+    /// \param step The index of the step.
+    /// \returns A pointer to n_observations(step) observation values.
+    const double_t* values(uint32_t step) const;
+    /// \brief Indicates if the recording has ground truth states.
+    /// \returns TRUE if every step has a ground truth state, otherwise FALSE.
+    bool has_truth() const;
+    /// \brief Gets the ground truth state of a step.
+    /// \param step The index of the step.
+    /// \returns The true state after the step.
+    Eigen::Map<const Eigen::VectorXd> truth(uint32_t step) const;
+
+private:
+    /// \brief The number of observers.
+    uint32_t n_z;
+    /// \brief The offset of each step's observations, with one extra entry for the end of the last step.
+    std::vector<uint32_t> m_offsets;
+    /// \brief The observer indices of all steps.
+    std::vector<uint32_t> m_observers;
+    /// \brief The observation values of all steps.
+    std::vector<double_t> m_values;
+    /// \brief The number of variables in each ground truth state.
+    uint32_t n_t;
+    /// \brief The ground truth states of all steps.
+    std::vector<double_t> m_truth;
+
+    // METHODS
+    /// \brief Validates and appends the observations of a step.
+    /// \param observer_indices The indices of the observers that made the observations.
+    /// \param observations The values of the observations.
+    /// \param count The number of observations in the step.
+    void store_step(const uint32_t* observer_indices, const double_t* observations, uint32_t count);
+};
+
+/// \brief A filter configuration to evaluate in a parameter sweep.
+struct sweep_configuration_t
+{
+    /// \brief The process noise covariance matrix. Left empty to keep the prototype's Q.
+    Eigen::MatrixXd Q;
+    /// \brief The observation noise covariance matrix. Left empty to keep the prototype's R.
+    Eigen::MatrixXd R;
+    /// \brief Sets any other parameters of the configuration (e.g. ukf_t::wo). May be empty.
+    /// \details Called once on the configuration's filter before replay starts.
+    std::function<void(base_t&)> configure;
+};
+
+/// \brief The metrics of a filter configuration evaluated in a parameter sweep.
+struct sweep_result_t
+{
+    /// \brief Indicates if the configuration replayed all steps without the filter throwing.
+    bool valid;
+    /// \brief The error reported by the filter if the configuration is not valid.
+    std::string error;
+    /// \brief The number of steps replayed, including the step that failed.
+    uint32_t n_steps;
+    /// \brief The number of steps with observations.
+    uint32_t n_updates;
+    /// \brief The mean normalized innovation squared over steps with observations.
+    double_t nis;
+    /// \brief The mean normalized estimation error squared against the ground truth.
+    double_t nees;
+    /// \brief The root mean square error of each state variable against the ground truth.
+    Eigen::VectorXd rms;
+    /// \brief The wall clock time of the replay in seconds.
+    double_t runtime;
+};
+
+/// \brief Replays a recording against many filter configurations in parallel.
+/// \details Each configuration runs on its own clone of a prototype filter. Configurations are distributed over
+/// a set of threads, which all read the same recording. NEES and RMS metrics are only calculated if the recording
+/// has ground truth states.
+class sweep_t
+{
+public:
+    // TYPES
+    /// \brief A function called before each step is replayed.
+    /// \details Called as step_function(filter, step), for example to set inputs or discretize a model for the step.
+    typedef std::function<void(base_t&, uint32_t)> step_function_t;
+
+    // CONSTRUCTORS
+    /// \brief Instantiates a new sweep_t object.
+    /// \param prototype The filter to clone for each configuration. The filter must implement clone().
+    /// \param n_threads The number of threads to run configurations on. DEFAULT = 0 uses the number of hardware threads.
+    sweep_t(const base_t& prototype, uint32_t n_threads = 0);
+
+    // METHODS
+    /// \brief Replays a recording against all configurations.
+    /// \param recording The recording to replay. Must have the same number of observers as the prototype.
+    /// \param configurations The configurations to evaluate.
+    /// \param results (OUTPUT) The metrics of each configuration. Existing storage is reused.
+    void run(const recording_t& recording, const std::vector<sweep_configuration_t>& configurations, std::vector<sweep_result_t>& results) const;
+
+    // PARAMETERS
+    /// \brief The function called before each step is replayed. May be empty.
+    /// \note The function is called concurrently from multiple threads and must only modify the given filter.
+    step_function_t step_function;
+
+    // ACCESS
+    /// \brief Gets the number of threads.
+    /// \returns The number of threads.
+    uint32_t n_threads() const;
+
+private:
+    /// \brief The prototype filter.
+    std::unique_ptr<base_t> m_prototype;
+    /// \brief The number of threads.
+    uint32_t m_threads;
+
+    // METHODS
+    /// \brief Replays a recording against a single configuration.
+    /// \param recording The recording to replay.
+    /// \param configuration The configuration to evaluate.
+    /// \param result (OUTPUT) The metrics of the configuration.
+    void evaluate(const recording_t& recording, const sweep_configuration_t& configuration, sweep_result_t& result) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,180 @@
+/// \file kalman_filter/tracker.hpp
+/// \brief Defines the kalman_filter::tracker_t class.
+#ifndef KALMAN_FILTER___TRACKER_H
+#define KALMAN_FILTER___TRACKER_H
+
+#include <kalman_filter/pool.hpp>
+#include <kalman_filter/assignment.hpp>
+
+#include <functional>
+#include <unordered_map>
+
+namespace kalman_filter {
+
+/// \brief The lifecycle status of a track.
+enum class track_status_t
+{
+    /// \brief The track has not yet been associated with enough detections to be confirmed.
+    TENTATIVE = 0,
+    /// \brief The track has been confirmed.
+    CONFIRMED = 1
+};
+
+/// \brief A track maintained by a tracker_t.
+struct track_t
+{
+    /// \brief The unique identifier of the track.
+    uint64_t id;
+    /// \brief The lifecycle status of the track.
+    track_status_t status;
+    /// \brief The number of detections associated with the track.
+    uint32_t hits;
+    /// \brief The number of consecutive iterations without an associated detection.
+    uint32_t misses;
+    /// \brief The index of the detection associated in the last iteration, or -1 if none.
+    int32_t detection;
+    /// \brief The filter estimating the track's state.
+    base_t* filter;
+};
+
+/// \brief A multi-target tracker built on a bank of filters.
+/// \details Each track runs its own filter, cloned from a prototype and recycled through a pool. Detections are
+/// gated against ellipsoidal gates from each track's predicted observation covariance, using a uniform grid
+/// spatial index over the leading observation dimensions, and associated by global nearest neighbour with a sparse
+/// assignment solver over the gated pairs.
+/// Unassigned detections start new tentative tracks.
+/// \note A detection is a full observation vector, with one value per observer of the prototype filter.
+class tracker_t
+{
+public:
+    // TYPES
+    /// \brief A function that initializes a new track's state from a detection.
+    /// \details Called as initializer(detection, x0, P0), where x0 and P0 are sized and must be filled.
+    typedef std::function<void(const Eigen::VectorXd&, Eigen::VectorXd&, Eigen::MatrixXd&)> initializer_t;
+
+    // CONSTRUCTORS
+    /// \brief Instantiates a new tracker_t object.
+    /// \param prototype The filter to clone for each track. The filter must implement clone().
+    /// \param initializer The function that initializes new tracks from detections.
+    tracker_t(const base_t& prototype, initializer_t initializer);
+
+    // TRACKING METHODS
+    /// \brief Predicts all tracks, associates detections, updates tracks, and manages the track lifecycle.
+    /// \param detections The detections of this iteration, one per column (n_observers x n_detections). All elements
+    /// must be finite.
+    void iterate(const Eigen::MatrixXd& detections);
+
+    // PARAMETERS
+    /// \brief The gate threshold on the squared Mahalanobis distance of a detection.
+    /// \details The default is the 99% chi-square quantile for 2 degrees of freedom.
+    double_t gate;
+    /// \brief The size of each spatial index grid cell, in observation units.
+    double_t cell_size;
+    /// \brief The number of leading observation dimensions indexed by the spatial grid (1 to 3).
+    uint32_t n_index;
+    /// \brief The number of hits required to confirm a tentative track.
+    uint32_t confirm_hits;
+    /// \brief The number of consecutive misses after which a tentative track is deleted.
+    uint32_t tentative_misses;
+    /// \brief The number of consecutive misses after which a confirmed track is deleted.
+    uint32_t confirmed_misses;
+
+    // ACCESS
+    /// \brief Gets the current tracks.
+    /// \returns A reference to the current tracks.
+    /// \note Track order changes as tracks are deleted. Use track_t::id to identify tracks.
+    const std::vector<track_t>& tracks() const;
+    /// \brief Gets the number of filters allocated by the tracker, including pooled filters.
+    /// \returns The number of allocated filters.
+    uint32_t n_filters() const;
+
+private:
+    // TYPES
+    /// \brief The gating storage of a track.
+    struct slot_t
+    {
+        /// \brief The predicted observation.
+        Eigen::VectorXd z;
+        /// \brief The predicted observation covariance.
+        Eigen::MatrixXd S;
+        /// \brief The factorization of S.
+        Eigen::LLT<Eigen::MatrixXd> llt;
+        /// \brief Indicates if S could be factorized.
+        bool valid;
+    };
+
+    // DIMENSIONS
+    /// \brief The number of variables in each filter's state vector.
+    uint32_t n_x;
+    /// \brief The number of observers in each filter.
+    uint32_t n_z;
+
+    // FILTERS
+    /// \brief The pool of track filters.
+    pool_t m_filters;
+    /// \brief The track initializer.
+    initializer_t m_initializer;
+
+    // TRACKS
+    /// \brief The current tracks.
+    std::vector<track_t> m_tracks;
+    /// \brief The gating storage of each track, by track index.
+    /// \details Grows to the largest number of tracks and is never shrunk, so gating does not allocate.
+    std::vector<slot_t> m_slots;
+    /// \brief The identifier of the next new track.
+    uint64_t m_next_id;
+
+    // STORAGE: SPATIAL INDEX
+    /// \brief The grid cell key of each detection.
+    std::vector<uint64_t> m_keys;
+    /// \brief The detection indices, sorted by grid cell key.
+    std::vector<uint32_t> m_order;
+    /// \brief The [begin, end) range in m_order of each occupied grid cell.
+    std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> m_cells;
+
+    // STORAGE: ASSOCIATION
+    /// \brief The assignment solver over gated (track, detection) pairs.
+    assignment_t m_assignment;
+    /// \brief The track assigned to each detection, or -1 if none.
+    std::vector<int32_t> m_detection_tracks;
+
+    // STORAGE: TEMPORARIES
+    /// \brief A temporary vector of size n_z.
+    Eigen::VectorXd t_z;
+    /// \brief A temporary vector of size n_x.
+    Eigen::VectorXd t_x;
+    /// \brief A temporary matrix of size n_x,n_x.
+    Eigen::MatrixXd t_xx;
+
+    // METHODS
+    /// \brief Calculates the grid cell key of a cell coordinate.
+    /// \param cell The integer cell coordinate in each indexed dimension.
+    /// \returns The grid cell key.
+    uint64_t cell_key(const int64_t* cell) const;
+    /// \brief Builds the spatial index over the detections.
+    /// \param detections The detections, one per column.
+    void index(const Eigen::MatrixXd& detections);
+    /// \brief Gates all detections near a track and stores the gated pairs.
+    /// \param track The index of the track.
+    /// \param detections The detections, one per column.
+    void gate_track(uint32_t track, const Eigen::MatrixXd& detections);
+    /// \brief Tests a detection against a track's gate and adds the pair to the assignment if it passes.
+    /// \param track The index of the track.
+    /// \param detection The index of the detection.
+    /// \param detections The detections, one per column.
+    void gate_pair(uint32_t track, uint32_t detection, const Eigen::MatrixXd& detections);
+    /// \brief Assigns detections to tracks by solving the assignment over the gated pairs.
+    /// \details Minimizes the total squared Mahalanobis distance, where leaving a track unassigned costs the gate threshold.
+    void associate();
+    /// \brief Starts a new tentative track from a detection.
+    /// \param detection The index of the detection.
+    /// \param detections The detections, one per column.
+    void start_track(uint32_t detection, const Eigen::MatrixXd& detections);
+    /// \brief Deletes a track and returns its filter to the pool.
+    /// \param track The index of the track.
+    void delete_track(uint32_t track);
+};
+
+}
+
+#endif
@@ -32,24 +32,68 @@ public:
     virtual void observation(const Eigen::VectorXd& x, Eigen::VectorXd& z) const = 0;
 
     // FILTER METHODS
-    void iterate() override;
+    using base_t::iterate;
+    /// \brief Iterates the filter, degrading gracefully if the iteration would not complete before a deadline.
+    /// \param deadline The time by which the iteration should complete.
+    /// \details Degradations are taken in order until the estimated cost fits in the time remaining:
+    /// reusing the predicted sigma points, extended by the cached factor of Q, for the update instead of factorizing P
+    /// again, skipping covariance
+    /// conditioning, using a minimal spherical simplex set of n+2 sigma points, and deferring the covariance update
+    /// to the next iteration. Costs are estimated from previous deadline-aware iterations. The degradations taken
+    /// are reported by degradations().
+    void iterate(std::chrono::steady_clock::time_point deadline);
+    void predict() override;
+    void update() override;
+    void predicted_observation(Eigen::VectorXd& z, Eigen::MatrixXd& S) const override;
+    void forecast(uint32_t horizon, std::vector<Eigen::VectorXd>& states, std::vector<Eigen::MatrixXd>& covariances) const override;
+
+    // ACCESS
+    double_t iteration_cost() const override;
 
     // PARAMETERS
     /// \brief Controls sigma point spread from the mean (-1 < wo < 1)
     /// \details wo < 0 gives points closer to the mean, wo > 0 gives points further from the mean.
     double_t wo;
 
+protected:
+    // CHECKPOINTING
+    filter_type_t filter_type() const override;
+    void checkpoint_fields(std::vector<std::pair<double_t*, uint32_t>>& fields) override;
+    void checkpoint_fields(std::vector<std::pair<const double_t*, uint32_t>>& fields) const override;
+
 private:
     // DIMENSIONS
     /// \brief The number of sigma points.
     uint32_t n_s;
+    /// \brief The number of sigma points in the minimal set.
+    uint32_t n_m;
 
     // STORAGE: WEIGHTS
     /// \brief The mean/covariance recovery weight vector.
     Eigen::VectorXd wj;
+    /// \brief The mean/covariance recovery weight vector of the minimal sigma point set.
+    Eigen::VectorXd wm;
+
+    // STORAGE: MINIMAL SIGMA
+    /// \brief The unit spherical simplex sigma points, with zero mean and identity covariance under wm.
+    /// \details Allocated on first use.
+    Eigen::MatrixXd U;
+    /// \brief The value of wo that the simplex was calculated for.
+    double_t m_simplex_wo;
+    /// \brief Indicates if the last prediction used the minimal sigma point set.
+    bool m_minimal;
+
+    // STORAGE: REUSED FACTOR
+    /// \brief The square root of Q, used to append process noise sigma points when the factor is reused.
+    Eigen::MatrixXd Xq;
+    /// \brief The process noise covariance that Xq was calculated for.
+    Eigen::MatrixXd m_factored_Q;
+    /// \brief The covariance weight vector of the update sigma points.
+    Eigen::VectorXd wc;
 
     // STORAGE: SIGMA
     /// \brief The evaluated variable sigma matrix.
+    /// \details Has 2*n_x spare columns for the process noise sigma points of a reused factor.
     Eigen::MatrixXd X;
     /// \brief The evaluated observation sigma matrix.
     Eigen::MatrixXd Z;
@@ -68,9 +112,64 @@ private:
     /// \brief A temporary working matrix of size z,s.
     Eigen::MatrixXd t_zs;
 
+    // STORAGE: QUERIES
+    // NOTE: Const queries reuse this storage, so they must not be called concurrently on the same filter.
+    /// \brief The covariance with deferred propagation applied, used by queries.
+    mutable Eigen::MatrixXd q_P;
+    /// \brief The weight vector of the full sigma point set, used by queries.
+    mutable Eigen::VectorXd q_w;
+    /// \brief The variable sigma matrix, used by queries.
+    mutable Eigen::MatrixXd q_X;
+    /// \brief The observation sigma matrix, used by queries.
+    mutable Eigen::MatrixXd q_Z;
+    /// \brief An interface to the prior state vector, used by queries.
+    mutable Eigen::VectorXd q_xp;
+    /// \brief An interface to the current state vector, used by queries.
+    mutable Eigen::VectorXd q_x;
+    /// \brief An interface to the predicted observation vector, used by queries.
+    mutable Eigen::VectorXd q_z;
+    /// \brief A temporary working matrix of size x,s, used by queries.
+    mutable Eigen::MatrixXd q_xs;
+    /// \brief A temporary working matrix of size z,s, used by queries.
+    mutable Eigen::MatrixXd q_zs;
+    /// \brief An LLT object for the Cholesky decompositions of queries.
+    mutable Eigen::LLT<Eigen::MatrixXd> q_llt;
+
     // UTILITY
     /// \brief An LLT object for storing results of Cholesky decompositions.
-    mutable Eigen::LLT<Eigen::MatrixXd> llt;
+    Eigen::LLT<Eigen::MatrixXd> llt;
+
+    // METHODS
+    /// \brief Predicts a state and covariance by passing sigma points through the state transition.
+    /// \param x_in The prior state.
+    /// \param P_in The prior covariance.
+    /// \param x_out (OUTPUT) The predicted state. May alias x_in.
+    /// \param P_out (OUTPUT) The predicted covariance. May alias P_in.
+    /// \param w The weight vector of the sigma point set.
+    /// \param minimal Indicates if the minimal sigma point set is used.
+    /// \param llt (OUTPUT) Storage for the factorization of P_in.
+    /// \param X (OUTPUT) The propagated sigma matrix, as deviations from the predicted state.
+    /// \param t_xs (OUTPUT) A temporary matrix of size x,s.
+    /// \param i_xp (OUTPUT) An interface to the prior state vector.
+    /// \param i_x (OUTPUT) An interface to the predicted state vector.
+    /// \returns TRUE if the prediction succeeded, otherwise FALSE if P_in could not be factorized.
+    /// \details Only the given storage is changed, so const methods can predict with their own storage.
+    bool predict_sigma(const Eigen::VectorXd& x_in, const Eigen::MatrixXd& P_in, Eigen::VectorXd& x_out, Eigen::MatrixXd& P_out, const Eigen::VectorXd& w, bool minimal,
+                       Eigen::LLT<Eigen::MatrixXd>& llt, Eigen::MatrixXd& X, Eigen::MatrixXd& t_xs, Eigen::VectorXd& i_xp, Eigen::VectorXd& i_x) const;
+    /// \brief Populates a sigma matrix around a mean from a factorization of the covariance.
+    /// \param x_in The mean.
+    /// \param llt The Cholesky factorization of the covariance.
+    /// \param minimal Indicates if the minimal sigma point set is used.
+    /// \param X (OUTPUT) The sigma matrix.
+    void draw_sigma(const Eigen::VectorXd& x_in, const Eigen::LLT<Eigen::MatrixXd>& llt, bool minimal, Eigen::MatrixXd& X) const;
+    /// \brief Calculates the weight vector of the full sigma point set for the current wo.
+    /// \param w (OUTPUT) The weight vector.
+    void calculate_weights(Eigen::VectorXd& w) const;
+    /// \brief Calculates the unit spherical simplex and its weights for the current wo.
+    void calculate_simplex();
+    /// \brief Calculates the square root of Q into Xq, unless Q is unchanged since the last call.
+    /// \returns TRUE if Xq is valid, otherwise FALSE if Q could not be factorized (status API only).
+    bool factor_process_noise();
 
     // Hide base class protected members.
     // NOTE: State variable and covariance access is still protected.
@@ -81,7 +180,13 @@ private:
     using base_t::C;
     using base_t::t_xx;
     using base_t::has_observations;
+    using base_t::add_observation_noise;
     using base_t::masked_kalman_update;
+    using base_t::fail;
+    using base_t::iterate_until;
+    using base_t::degrade;
+    using base_t::start_timing;
+    using base_t::stop_timing;
 };
 
 }
@@ -34,13 +34,33 @@ public:
     virtual void observation(const Eigen::VectorXd& x, const Eigen::VectorXd& r, Eigen::VectorXd& z) const = 0;
 
     // FILTER METHODS
-    void iterate() override;
+    using base_t::iterate;
+    /// \brief Iterates the filter, degrading gracefully if the iteration would not complete before a deadline.
+    /// \param deadline The time by which the iteration should complete.
+    /// \details Degradations are taken in order until the estimated cost fits in the time remaining: reusing the
+    /// previous square roots of Q and R instead of factorizing them again, skipping covariance conditioning, and
+    /// deferring the covariance update to the next iteration. Costs are estimated from previous deadline-aware
+    /// iterations. The degradations taken are reported by degradations().
+    void iterate(std::chrono::steady_clock::time_point deadline);
+    void predict() override;
+    void update() override;
+    void predicted_observation(Eigen::VectorXd& z, Eigen::MatrixXd& S) const override;
+    void forecast(uint32_t horizon, std::vector<Eigen::VectorXd>& states, std::vector<Eigen::MatrixXd>& covariances) const override;
+
+    // ACCESS
+    double_t iteration_cost() const override;
 
     // PARAMETERS
     /// \brief Controls sigma point spread from the mean (-1 < wo < 1)
     /// \details wo < 0 gives points closer to the mean, wo > 0 gives points further from the mean.
     double_t wo;
 
+protected:
+    // CHECKPOINTING
+    filter_type_t filter_type() const override;
+    void checkpoint_fields(std::vector<std::pair<double_t*, uint32_t>>& fields) override;
+    void checkpoint_fields(std::vector<std::pair<const double_t*, uint32_t>>& fields) const override;
+
 private:   
     // DIMENSIONS
     /// \brief The number of variables in the augemented state (x q z).
@@ -67,6 +87,14 @@ private:
     Eigen::MatrixXd Xr;
     /// \brief The evaluated observation sigma matrix.
     Eigen::MatrixXd Z;
+    /// \brief Indicates if Xq holds a factor that may be reused.
+    bool m_factors;
+    /// \brief The observation noise covariance that Xr was calculated for.
+    /// \details NaN if Xr does not hold a factor of R, including when it was calculated with observation specific or
+    /// averaged noise.
+    Eigen::MatrixXd m_factored_R;
+    /// \brief The value of wo that Xr was scaled for.
+    double_t m_factored_wo;
 
     // STORAGE: INTERFACES
     /// \brief An interface to the prior state vector.
@@ -86,9 +114,74 @@ private:
     /// \brief A temporary working matrix of size z,s.
     Eigen::MatrixXd t_zs;
 
+    // STORAGE: QUERIES
+    // NOTE: Const queries reuse this storage, so they must not be called concurrently on the same filter.
+    /// \brief The covariance with deferred propagation applied, used by queries.
+    mutable Eigen::MatrixXd q_P;
+    /// \brief The weight vector, used by queries.
+    mutable Eigen::VectorXd q_w;
+    /// \brief The scaled square root of Q, used by queries.
+    mutable Eigen::MatrixXd q_Xq;
+    /// \brief The scaled square root of P, used by queries.
+    mutable Eigen::MatrixXd q_Xp;
+    /// \brief The scaled square root of R, used by queries.
+    mutable Eigen::MatrixXd q_Xr;
+    /// \brief The evaluated variable sigma matrix, used by queries.
+    mutable Eigen::MatrixXd q_X;
+    /// \brief The evaluated variable sigma matrix minus its mean, used by queries.
+    mutable Eigen::MatrixXd q_dX;
+    /// \brief The evaluated observation sigma matrix, used by queries.
+    mutable Eigen::MatrixXd q_Z;
+    /// \brief An interface to the prior state vector, used by queries.
+    mutable Eigen::VectorXd q_xp;
+    /// \brief An interface to the process noise vector, used by queries.
+    mutable Eigen::VectorXd q_q;
+    /// \brief An interface to the current state vector, used by queries.
+    mutable Eigen::VectorXd q_x;
+    /// \brief An interface to the observation noise vector, used by queries.
+    mutable Eigen::VectorXd q_r;
+    /// \brief An interface to the predicted observation vector, used by queries.
+    mutable Eigen::VectorXd q_z;
+    /// \brief A temporary working matrix of size x,s, used by queries.
+    mutable Eigen::MatrixXd q_xs;
+    /// \brief A temporary working matrix of size z,s, used by queries.
+    mutable Eigen::MatrixXd q_zs;
+    /// \brief An LLT object for the Cholesky decompositions of queries.
+    mutable Eigen::LLT<Eigen::MatrixXd> q_llt;
+
     // UTILITY
     /// \brief An LLT object for storing results of Cholesky decompositions.
-    mutable Eigen::LLT<Eigen::MatrixXd> llt;
+    Eigen::LLT<Eigen::MatrixXd> llt;
+
+    // METHODS
+    /// \brief Predicts a state and covariance by passing augmented sigma points through the state transition.
+    /// \param x_in The prior state.
+    /// \param P_in The prior covariance.
+    /// \param x_out (OUTPUT) The predicted state. May alias x_in.
+    /// \param P_out (OUTPUT) The predicted covariance. May alias P_in.
+    /// \param w The weight vector.
+    /// \param Xq The scaled square root of Q.
+    /// \param llt (OUTPUT) Storage for the factorization of P_in.
+    /// \param Xp (OUTPUT) The scaled square root of P_in.
+    /// \param X (OUTPUT) The evaluated variable sigma matrix.
+    /// \param dX (OUTPUT) The evaluated variable sigma matrix minus its mean.
+    /// \param t_xs (OUTPUT) dX weighted by w.
+    /// \param i_xp (OUTPUT) An interface to the prior state vector.
+    /// \param i_q (OUTPUT) An interface to the process noise vector.
+    /// \param i_x (OUTPUT) An interface to the current state vector.
+    /// \returns TRUE if the prediction succeeded, otherwise FALSE if P_in could not be factorized.
+    /// \details Only the given storage is changed, so const methods can predict with their own storage.
+    bool predict_sigma(const Eigen::VectorXd& x_in, const Eigen::MatrixXd& P_in, Eigen::VectorXd& x_out, Eigen::MatrixXd& P_out, const Eigen::VectorXd& w, const Eigen::MatrixXd& Xq,
+                       Eigen::LLT<Eigen::MatrixXd>& llt, Eigen::MatrixXd& Xp, Eigen::MatrixXd& X, Eigen::MatrixXd& dX, Eigen::MatrixXd& t_xs,
+                       Eigen::VectorXd& i_xp, Eigen::VectorXd& i_q, Eigen::VectorXd& i_x) const;
+    /// \brief Calculates the scaled square root of Q.
+    /// \param llt (OUTPUT) Storage for the factorization of Q.
+    /// \param Xq (OUTPUT) The scaled square root of Q.
+    /// \returns TRUE if the calculation succeeded, otherwise FALSE if Q could not be factorized.
+    bool factor_process_noise(Eigen::LLT<Eigen::MatrixXd>& llt, Eigen::MatrixXd& Xq) const;
+    /// \brief Calculates the weight vector for the current wo.
+    /// \param w (OUTPUT) The weight vector.
+    void calculate_weights(Eigen::VectorXd& w) const;
 
     // Hide base class protected members.
     // NOTE: State variable and covariance access is still protected.
@@ -99,7 +192,14 @@ private:
     using base_t::C;
     using base_t::t_xx;
     using base_t::has_observations;
+    using base_t::add_observation_noise;
+    using base_t::has_observation_noise;
     using base_t::masked_kalman_update;
+    using base_t::fail;
+    using base_t::iterate_until;
+    using base_t::degrade;
+    using base_t::start_timing;
+    using base_t::stop_timing;
 };
 
 }
@@ -0,0 +1,143 @@
+#include <kalman_filter/equivalence.hpp>
+#include <kalman_filter/scenario.hpp>
+#include <kalman_filter/kf.hpp>
+
+#include <iostream>
+#include <sstream>
+
+using namespace kalman_filter;
+
+/// \brief Prints the command line usage.
+void print_usage()
+{
+    std::cerr << "usage: equivalence_check [OPTIONS]" << std::endl
+              << "  --seed N                   random seed of the scenario (default: 0)" << std::endl
+              << "  --steps N                  number of steps (default: 1000)" << std::endl
+              << "  --period N                 steps between observations, so lazy covariance defers N-1 steps (default: 10)" << std::endl
+              << "  --absolute-tolerance A     absolute tolerance of each element (default: 1e-9)" << std::endl
+              << "  --relative-tolerance R     relative tolerance of each element (default: 1e-9)" << std::endl
+              << std::endl
+              << "Replays a seeded constant velocity scenario on a reference KF and compares it against a KF with" << std::endl
+              << "lazy covariance and a KF discretized from the continuous model. Exits with 0 if both are equivalent." << std::endl;
+}
+
+/// \brief Creates a constant velocity KF with an analytically discretized model.
+/// \param config The scenario configuration.
+/// \returns The new filter.
+kf_t* create_filter(const scenario_config_t& config)
+{
+    uint32_t n_d = config.n_dimensions;
+    double_t dt = config.dt;
+    double_t q = config.process_noise * config.process_noise;
+
+    kf_t* filter = new kf_t(2 * n_d, 0, n_d);
+    filter->A.setIdentity();
+    filter->Q.setZero();
+    filter->H.setZero();
+    filter->R.setZero();
+    for(uint32_t d = 0; d < n_d; ++d)
+    {
+        // White acceleration, integrated exactly over the interval.
+        filter->A(d, n_d + d) = dt;
+        filter->Q(d, d) = q * dt * dt * dt / 3.0;
+        filter->Q(d, n_d + d) = q * dt * dt / 2.0;
+        filter->Q(n_d + d, d) = q * dt * dt / 2.0;
+        filter->Q(n_d + d, n_d + d) = q * dt;
+        filter->H(d, d) = 1.0;
+        filter->R(d, d) = config.observation_noise * config.observation_noise;
+    }
+
+    return filter;
+}
+
+/// \brief Prints an equivalence report.
+/// \param name The name of the comparison.
+/// \param report The report to print.
+void print_report(const std::string& name, const equivalence_report_t& report)
+{
+    std::cout << name << ": " << (report.equivalent ? "equivalent" : "NOT equivalent") << " over " << report.n_steps << " steps, max state error " << report.max_state_error << ", max covariance error " << report.max_covariance_error << std::endl;
+    if(!report.equivalent)
+    {
+        std::cout << "  diverged at step " << report.step << " (" << (report.phase == phase_t::PREDICT ? "predict" : "update") << "): " << report.description << std::endl;
+    }
+}
+
+int32_t main(int32_t argc, char** argv)
+{
+    // Parse arguments.
+    scenario_config_t config;
+    uint32_t period = 10;
+    equivalence_t equivalence;
+    for(int32_t i = 1; i < argc; i += 2)
+    {
+        if(i + 1 >= argc)
+        {
+            print_usage();
+            return 1;
+        }
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        bool valid = true;
+        if(key == "--seed") valid = static_cast<bool>(std::stringstream(value) >> config.seed);
+        else if(key == "--steps") valid = static_cast<bool>(std::stringstream(value) >> config.n_steps);
+        else if(key == "--period") valid = static_cast<bool>(std::stringstream(value) >> period) && period > 0;
+        else if(key == "--absolute-tolerance") valid = static_cast<bool>(std::stringstream(value) >> equivalence.absolute_tolerance);
+        else if(key == "--relative-tolerance") valid = static_cast<bool>(std::stringstream(value) >> equivalence.relative_tolerance);
+        else valid = false;
+
+        if(!valid)
+        {
+            std::cerr << "invalid argument: " << key << " " << value << std::endl;
+            print_usage();
+            return 1;
+        }
+    }
+
+    // Generate the scenario.
+    // NOTE: Observers share a period, so iterations between observations have none and lazy covariance defers them.
+    config.model = scenario_model_t::CONSTANT_VELOCITY;
+    config.periods.assign(config.n_dimensions, period);
+    scenario_t scenario(config);
+    recording_t recording(scenario.n_observers());
+    scenario.generate(recording);
+    std::cout << "generated " << recording.n_steps() << " steps (seed " << config.seed << ")" << std::endl;
+
+    bool success = true;
+    try
+    {
+        // Compare lazy covariance against the reference.
+        {
+            std::unique_ptr<kf_t> reference(create_filter(config));
+            std::unique_ptr<kf_t> candidate(create_filter(config));
+            candidate->set_lazy_covariance(true);
+            equivalence_report_t report;
+            success = equivalence.compare(*reference, *candidate, recording, report) && success;
+            print_report("kf vs lazy kf", report);
+        }
+
+        // Compare the discretized continuous model against the reference.
+        {
+            std::unique_ptr<kf_t> reference(create_filter(config));
+            std::unique_ptr<kf_t> candidate(create_filter(config));
+            uint32_t n_d = config.n_dimensions;
+            Eigen::MatrixXd F = Eigen::MatrixXd::Zero(2 * n_d, 2 * n_d);
+            Eigen::MatrixXd G = Eigen::MatrixXd::Zero(2 * n_d, 0);
+            Eigen::MatrixXd Qc = Eigen::MatrixXd::Zero(2 * n_d, 2 * n_d);
+            F.topRightCorner(n_d, n_d).setIdentity();
+            Qc.bottomRightCorner(n_d, n_d).setIdentity();
+            Qc *= config.process_noise * config.process_noise;
+            candidate->set_continuous_model(F, G, Qc);
+            candidate->discretize(config.dt);
+            equivalence_report_t report;
+            success = equivalence.compare(*reference, *candidate, recording, report) && success;
+            print_report("kf vs discretized kf", report);
+        }
+    }
+    catch(const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return success ? 0 : 2;
+}
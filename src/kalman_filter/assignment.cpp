@@ -0,0 +1,257 @@
+#include <kalman_filter/assignment.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+using namespace kalman_filter;
+
+// CONSTRUCTORS
+assignment_t::assignment_t()
+{
+    assignment_t::n_r = 0;
+    assignment_t::n_c = 0;
+    assignment_t::m_cost = 0.0;
+}
+
+// METHODS
+void assignment_t::reset(uint32_t n_rows, uint32_t n_cols)
+{
+    // Store dimension sizes.
+    assignment_t::n_r = n_rows;
+    assignment_t::n_c = n_cols;
+
+    // Clear pairs.
+    // NOTE: This does not release storage.
+    assignment_t::m_edges.clear();
+}
+void assignment_t::add(uint32_t row, uint32_t col, double_t cost)
+{
+    // Verify pair.
+    if(!(row < assignment_t::n_r) || !(col < assignment_t::n_c))
+    {
+        throw std::runtime_error("failed to add assignment pair (index out of range)");
+    }
+    if(!(cost >= 0.0))
+    {
+        throw std::runtime_error("failed to add assignment pair (cost must be non-negative)");
+    }
+
+    assignment_t::m_edges.push_back({row, col, cost});
+}
+void assignment_t::solve(double_t unassigned_cost)
+{
+    // ---------- STEP 1: PREPARATION ----------
+
+    // Group pairs by row, dropping pairs that are never better than leaving the row unassigned.
+    assignment_t::m_row_start.assign(assignment_t::n_r + 1, 0);
+    for(auto edge = assignment_t::m_edges.begin(); edge != assignment_t::m_edges.end(); ++edge)
+    {
+        if(edge->cost <= unassigned_cost)
+        {
+            ++assignment_t::m_row_start[edge->row + 1];
+        }
+    }
+    for(uint32_t r = 0; r < assignment_t::n_r; ++r)
+    {
+        assignment_t::m_row_start[r + 1] += assignment_t::m_row_start[r];
+    }
+    assignment_t::m_row_edges.resize(assignment_t::m_row_start[assignment_t::n_r]);
+    for(auto edge = assignment_t::m_edges.begin(); edge != assignment_t::m_edges.end(); ++edge)
+    {
+        if(edge->cost <= unassigned_cost)
+        {
+            // NOTE: m_row_start is used as the insertion cursor and restored afterwards.
+            assignment_t::m_row_edges[assignment_t::m_row_start[edge->row]++] = *edge;
+        }
+    }
+    for(uint32_t r = assignment_t::n_r; r > 0; --r)
+    {
+        assignment_t::m_row_start[r] = assignment_t::m_row_start[r - 1];
+    }
+    assignment_t::m_row_start[0] = 0;
+
+    // Reset solution and search storage.
+    // NOTE: Columns n_c..n_c+n_r-1 are the unassigned options of each row.
+    uint32_t n_options = assignment_t::n_c + assignment_t::n_r;
+    assignment_t::m_row_assignments.assign(assignment_t::n_r, -1);
+    assignment_t::m_col_assignments.assign(assignment_t::n_c, -1);
+    assignment_t::m_row_costs.assign(assignment_t::n_r, 0.0);
+    assignment_t::v.assign(n_options, 0.0);
+    assignment_t::d.assign(n_options, std::numeric_limits<double_t>::infinity());
+    assignment_t::m_predecessor.assign(n_options, -1);
+    assignment_t::m_predecessor_costs.assign(n_options, 0.0);
+    assignment_t::m_scanned.assign(n_options, 0);
+
+    // ---------- STEP 2: AUGMENTATION ----------
+
+    for(uint32_t r = 0; r < assignment_t::n_r; ++r)
+    {
+        // Rows without pairs are left unassigned directly.
+        if(assignment_t::m_row_start[r] == assignment_t::m_row_start[r + 1])
+        {
+            assignment_t::m_row_assignments[r] = assignment_t::n_c + r;
+            assignment_t::m_row_costs[r] = unassigned_cost;
+            continue;
+        }
+        assignment_t::augment(r, unassigned_cost);
+    }
+
+    // ---------- STEP 3: SOLUTION ----------
+
+    // Calculate total cost and mark unassigned rows.
+    assignment_t::m_cost = 0.0;
+    for(uint32_t r = 0; r < assignment_t::n_r; ++r)
+    {
+        assignment_t::m_cost += assignment_t::m_row_costs[r];
+        if(assignment_t::m_row_assignments[r] >= static_cast<int32_t>(assignment_t::n_c))
+        {
+            assignment_t::m_row_assignments[r] = -1;
+        }
+    }
+}
+void assignment_t::augment(uint32_t row, double_t unassigned_cost)
+{
+    // Search for the shortest augmenting path with Dijkstra's algorithm over reduced costs c(i,k) - v(k).
+    // NOTE: The assigned column of each row has the minimum reduced cost of that row, so all edges beyond the
+    // starting row are non-negative.
+    auto heap_order = std::greater<std::pair<double_t, uint32_t>>();
+    assignment_t::m_touched.clear();
+    assignment_t::m_heap.clear();
+
+    // Relaxes all options of a row from the distance to the row.
+    // NOTE: base is the distance to the row minus the row's own reduced cost.
+    auto relax = [&](uint32_t i, double_t base)
+    {
+        for(uint32_t e = assignment_t::m_row_start[i]; e <= assignment_t::m_row_start[i + 1]; ++e)
+        {
+            // The last option of each row is its unassigned option.
+            uint32_t k;
+            double_t cost;
+            if(e < assignment_t::m_row_start[i + 1])
+            {
+                k = assignment_t::m_row_edges[e].col;
+                cost = assignment_t::m_row_edges[e].cost;
+            }
+            else
+            {
+                k = assignment_t::n_c + i;
+                cost = unassigned_cost;
+            }
+            if(assignment_t::m_scanned[k])
+            {
+                continue;
+            }
+            double_t distance = base + cost - assignment_t::v[k];
+            if(distance < assignment_t::d[k])
+            {
+                if(assignment_t::d[k] == std::numeric_limits<double_t>::infinity())
+                {
+                    assignment_t::m_touched.push_back(k);
+                }
+                assignment_t::d[k] = distance;
+                assignment_t::m_predecessor[k] = i;
+                assignment_t::m_predecessor_costs[k] = cost;
+                assignment_t::m_heap.emplace_back(distance, k);
+                std::push_heap(assignment_t::m_heap.begin(), assignment_t::m_heap.end(), heap_order);
+            }
+        }
+    };
+
+    // Start from the unassigned row.
+    relax(row, 0.0);
+
+    // Scan columns in order of distance until a free column is reached.
+    uint32_t end = 0;
+    double_t d_end = 0.0;
+    while(!assignment_t::m_heap.empty())
+    {
+        std::pop_heap(assignment_t::m_heap.begin(), assignment_t::m_heap.end(), heap_order);
+        std::pair<double_t, uint32_t> top = assignment_t::m_heap.back();
+        assignment_t::m_heap.pop_back();
+        uint32_t j = top.second;
+        if(assignment_t::m_scanned[j] || top.first > assignment_t::d[j])
+        {
+            continue;
+        }
+        assignment_t::m_scanned[j] = 1;
+
+        // Stop at a free column.
+        int32_t i = assignment_t::owner(j);
+        if(i < 0)
+        {
+            end = j;
+            d_end = assignment_t::d[j];
+            break;
+        }
+
+        // Continue the path through the row that owns the column.
+        relax(i, assignment_t::d[j] - (assignment_t::m_row_costs[i] - assignment_t::v[j]));
+    }
+
+    // Update the potentials of the scanned columns to keep the reduced costs of all rows consistent.
+    for(auto k = assignment_t::m_touched.begin(); k != assignment_t::m_touched.end(); ++k)
+    {
+        if(assignment_t::m_scanned[*k])
+        {
+            assignment_t::v[*k] += assignment_t::d[*k] - d_end;
+        }
+    }
+
+    // Augment the assignment along the path.
+    uint32_t j = end;
+    while(true)
+    {
+        uint32_t i = assignment_t::m_predecessor[j];
+        int32_t previous = assignment_t::m_row_assignments[i];
+        assignment_t::m_row_assignments[i] = j;
+        assignment_t::m_row_costs[i] = assignment_t::m_predecessor_costs[j];
+        if(j < assignment_t::n_c)
+        {
+            assignment_t::m_col_assignments[j] = i;
+        }
+        if(i == row)
+        {
+            break;
+        }
+        j = previous;
+    }
+
+    // Reset the search storage of the touched columns.
+    for(auto k = assignment_t::m_touched.begin(); k != assignment_t::m_touched.end(); ++k)
+    {
+        assignment_t::d[*k] = std::numeric_limits<double_t>::infinity();
+        assignment_t::m_predecessor[*k] = -1;
+        assignment_t::m_scanned[*k] = 0;
+    }
+}
+int32_t assignment_t::owner(uint32_t col) const
+{
+    if(col < assignment_t::n_c)
+    {
+        return assignment_t::m_col_assignments[col];
+    }
+
+    // Unassigned options are only ever owned by their own row.
+    uint32_t row = col - assignment_t::n_c;
+    return (assignment_t::m_row_assignments[row] == static_cast<int32_t>(col)) ? row : -1;
+}
+
+// ACCESS
+uint32_t assignment_t::n_pairs() const
+{
+    return assignment_t::m_edges.size();
+}
+const std::vector<int32_t>& assignment_t::row_assignments() const
+{
+    return assignment_t::m_row_assignments;
+}
+const std::vector<int32_t>& assignment_t::col_assignments() const
+{
+    return assignment_t::m_col_assignments;
+}
+double_t assignment_t::cost() const
+{
+    return assignment_t::m_cost;
+}
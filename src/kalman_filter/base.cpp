@@ -1,323 +1,2125 @@
 #include <kalman_filter/base.hpp>
+#include <kalman_filter/shm.hpp>
 
 #include <fstream>
-#include <iomanip>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace kalman_filter;
 
-// CONSTRUCTORS
-base_t::base_t(uint32_t n_variables, uint32_t n_observers)
+// CHECKPOINT FORMAT
+// NOTE: Checkpoints are laid out as [header][field sizes][padding][field data], with field data aligned to 8 bytes.
+/// \brief The magic number identifying checkpoint files ("KFCP").
+const uint32_t checkpoint_magic = 0x5043464B;
+/// \brief The current checkpoint format version.
+const uint32_t checkpoint_version = 2;
+/// \brief The header of a checkpoint.
+struct checkpoint_header_t
 {
-    // Store dimension sizes.
-    base_t::n_x = n_variables;
-    base_t::n_z = n_observers;
-
-    // Allocate prediction components.
-    base_t::x.setZero(base_t::n_x);
-    base_t::P.setIdentity(base_t::n_x, base_t::n_x);
-    base_t::Q.setIdentity(base_t::n_x, base_t::n_x);
-
-    // Allocate update components.
-    base_t::R.setIdentity(base_t::n_z, base_t::n_z);
-    base_t::z.setZero(base_t::n_z);
-    base_t::S.setZero(base_t::n_z, base_t::n_z);
-    base_t::C.setZero(base_t::n_x, base_t::n_z);
-
-    // Allocate temporaries.
-    base_t::t_xx.setZero(base_t::n_x, base_t::n_x);
-}
-base_t::~base_t()
+    /// \brief The magic number identifying the checkpoint.
+    uint32_t magic;
+    /// \brief The checkpoint format version.
+    uint32_t version;
+    /// \brief The type of the filter that saved the checkpoint.
+    uint32_t type;
+    /// \brief The number of variables in the state vector.
+    uint32_t n_variables;
+    /// \brief The number of observers.
+    uint32_t n_observers;
+    /// \brief The number of fields stored in the checkpoint.
+    uint32_t n_fields;
+};
+/// \brief Calculates the offset of field data within a checkpoint.
+/// \param n_fields The number of fields stored in the checkpoint.
+/// \returns The offset in bytes.
+size_t checkpoint_data_offset(uint32_t n_fields)
 {
-    // Stop logging if running.
-    base_t::stop_log();
+    size_t offset = sizeof(checkpoint_header_t) + n_fields * sizeof(uint32_t);
+    return (offset + 7) & ~static_cast<size_t>(7);
 }
 
-// FILTER METHODS
-void base_t::new_observation(uint32_t observer_index, double_t observation)
-{
-    // Verify index exists.
-    if(!(observer_index < base_t::n_z))
-    {
-        throw std::runtime_error("failed to add new observation (observer_index out of range)");
-    }
-    
-    // Store observation in the observations map.
-    // NOTE: This adds or replaces the observation at the specified observer index.
-    base_t::m_observations[observer_index] = observation;
-}
-bool base_t::has_observations() const
+// OBSERVATION BUFFER
+observation_buffer_t::observation_buffer_t(uint32_t n_observers)
 {
-    return !base_t::m_observations.empty();
+    // Allocate storage for all observers.
+    observation_buffer_t::m_values.setZero(n_observers);
+    observation_buffer_t::m_flags.assign(n_observers, 0);
+    observation_buffer_t::m_indices.reserve(n_observers);
+    observation_buffer_t::m_noise_flags.assign(n_observers, 0);
+
+    // Disable averaging by default.
+    observation_buffer_t::m_averaging = false;
 }
-bool base_t::has_observation(uint32_t observer_index) const
+void observation_buffer_t::insert(uint32_t observer_index, double_t observation)
 {
-    return base_t::m_observations.count(observer_index) != 0;
+    if(observation_buffer_t::m_averaging)
+    {
+        // Accumulate the sample.
+        observation_buffer_t::start_average(observer_index);
+        observation_buffer_t::m_values(observer_index) += observation;
+        ++observation_buffer_t::m_counts[observer_index];
+    }
+    else
+    {
+        // Track the observer and remove any noise from a replaced observation.
+        observation_buffer_t::flag(observer_index);
+        observation_buffer_t::clear_noise(observer_index);
+
+        // Store the observation.
+        // NOTE: This adds or replaces the observation at the specified observer index.
+        observation_buffer_t::m_values(observer_index) = observation;
+    }
 }
-void base_t::masked_kalman_update()
+void observation_buffer_t::insert(uint32_t observer_index, double_t observation, double_t variance)
 {
-    // Get number of observations.
-    uint32_t n_o = base_t::m_observations.size();
-
-    // Using number of observations, create masked versions of S and C.
-    Eigen::MatrixXd S_m(n_o, n_o);
-    Eigen::MatrixXd C_m(base_t::n_x, n_o);
-    // Iterate over z indices.
-    uint32_t m_i = 0;
-    uint32_t m_j = 0;
-    // Iterate column first.
-    for(auto j = base_t::m_observations.begin(); j != base_t::m_observations.end(); ++j)
+    if(observation_buffer_t::m_averaging)
     {
-        // Iterate over rows to populate S_m.
-        for(auto i = base_t::m_observations.begin(); i != base_t::m_observations.end(); ++i)
+        // Accumulate the sample by inverse variance weighting.
+        observation_buffer_t::start_average(observer_index);
+        observation_buffer_t::m_weights(observer_index) += 1.0 / variance;
+        observation_buffer_t::m_weighted_values(observer_index) += observation / variance;
+    }
+    else
+    {
+        // Track the observer and remove any noise from a replaced observation.
+        observation_buffer_t::flag(observer_index);
+        observation_buffer_t::clear_noise(observer_index);
+
+        // Allocate noise storage on first use.
+        if(observation_buffer_t::m_noise.size() == 0)
         {
-            // Copy the selected S element into S_m.
-            S_m(m_i++, m_j) = base_t::S(i->first, j->first);
+            observation_buffer_t::m_noise.setZero(observation_buffer_t::m_values.size(), observation_buffer_t::m_values.size());
         }
-        m_i = 0;
 
-        // Copy the selected C column into C_m.
-        C_m.col(m_j++) = base_t::C.col(j->first);
+        // Store the observation and its noise.
+        observation_buffer_t::m_values(observer_index) = observation;
+        observation_buffer_t::m_noise_flags[observer_index] = 1;
+        observation_buffer_t::m_noise(observer_index, observer_index) = variance;
     }
-
-    // Calculate inverse of masked S.
-    Eigen::MatrixXd Si_m = S_m.inverse();
-    
-    // Calculate Kalman gain (masked by n observations).
-    Eigen::MatrixXd K_m(base_t::n_x,n_o);
-    K_m.noalias() = C_m * Si_m;
-
-    // Create masked version of za-z.
-    Eigen::VectorXd zd_m(n_o);
-    m_i = 0;
-    for(auto observation = base_t::m_observations.begin(); observation != base_t::m_observations.end(); ++observation)
+}
+void observation_buffer_t::insert(uint32_t first_observer_index, const Eigen::VectorXd& observations, const Eigen::MatrixXd& covariance)
+{
+    // Allocate noise storage on first use.
+    if(observation_buffer_t::m_noise.size() == 0)
     {
-        zd_m(m_i++) = observation->second - base_t::z(observation->first);
+        observation_buffer_t::m_noise.setZero(observation_buffer_t::m_values.size(), observation_buffer_t::m_values.size());
     }
 
-    // Update state.
-    base_t::x.noalias() += K_m * zd_m;
-
-    // Update covariance.
-    // NOTE: Just use internal temporary since it's masked size.
-    base_t::P.noalias() -= K_m * S_m * K_m.transpose();
-
-    // Protect against non-positive definite covariance matrices.
-    // Force symmetric matrix.
-    base_t::t_xx = base_t::P.transpose();
-    base_t::P += base_t::t_xx;
-    base_t::P /= 2.0;
-    // Force full rank and clean out small numbers.
-    for(uint32_t i = 0; i < base_t::n_x; ++i)
+    // Track the observers and remove any noise or samples from replaced observations.
+    uint32_t count = observations.size();
+    for(uint32_t i = first_observer_index; i < first_observer_index + count; ++i)
     {
-        double_t row_sum = 0;
-        // Force symmetry of non-diagonals.
-        for(uint32_t j = 0; j < base_t::n_x; ++j)
-        {
-            if(i!=j)
-            {
-                if(base_t::P(i,j) < 1E-3)
-                {
-                    base_t::P(i,j) = 0.0;
-                }
-                else
-                {
-                    row_sum += std::abs(base_t::P(i,j));
-                }
-            }
-        }
-        // Force PSD by controlling diagonal.
-        if(base_t::P(i,i) <= row_sum)
+        observation_buffer_t::flag(i);
+        observation_buffer_t::clear_noise(i);
+        observation_buffer_t::m_noise_flags[i] = 1;
+        if(observation_buffer_t::m_averaging)
         {
-            base_t::P(i,i) = row_sum + 1E-3;
+            observation_buffer_t::m_counts[i] = 0;
+            observation_buffer_t::m_weights(i) = 0.0;
+            observation_buffer_t::m_weighted_values(i) = 0.0;
         }
     }
 
-    // Reset observations.
-    base_t::m_observations.clear();
+    // Store the observations and their noise.
+    observation_buffer_t::m_values.segment(first_observer_index, count) = observations;
+    observation_buffer_t::m_noise.block(first_observer_index, first_observer_index, count, count) = covariance;
 }
-
-// ACCESS
-uint32_t base_t::n_variables() const
+void observation_buffer_t::clear()
 {
-    return base_t::n_x;
+    // Reset flags for only the observers with observations.
+    // NOTE: Stale noise values are zeroed when an observer is given new noise.
+    for(auto index = observation_buffer_t::m_indices.begin(); index != observation_buffer_t::m_indices.end(); ++index)
+    {
+        observation_buffer_t::m_flags[*index] = 0;
+        observation_buffer_t::m_noise_flags[*index] = 0;
+    }
+    observation_buffer_t::m_indices.clear();
 }
-uint32_t base_t::n_observers() const
+bool observation_buffer_t::valid_variance(double_t variance)
 {
-    return base_t::n_z;
+    return variance > 0.0 && std::isfinite(variance);
 }
-double_t base_t::state(uint32_t index) const
+bool observation_buffer_t::valid_covariance(const Eigen::MatrixXd& covariance)
 {
-    // Check if index is valid.
-    if(index >= base_t::n_x)
-    {
-        throw std::runtime_error("invalid state variable index");
-    }
-
-    return base_t::x(index);
+    // NOTE: Symmetry is checked to a relative tolerance, so blocks calculated in floating point are accepted.
+    return covariance.allFinite() &&
+           (covariance.diagonal().array() > 0.0).all() &&
+           covariance.isApprox(covariance.transpose());
 }
-void base_t::set_state(uint32_t index, double_t value)
+void observation_buffer_t::set_averaging(bool enabled)
 {
-    // Check if index is valid.
-    if(index >= base_t::n_x)
+    // Remove all stored observations.
+    observation_buffer_t::clear();
+
+    // Allocate averaging accumulators on first use.
+    if(enabled && observation_buffer_t::m_counts.empty())
     {
-        throw std::runtime_error("invalid state variable index");
+        uint32_t n_observers = observation_buffer_t::m_values.size();
+        observation_buffer_t::m_counts.assign(n_observers, 0);
+        observation_buffer_t::m_weights.setZero(n_observers);
+        observation_buffer_t::m_weighted_values.setZero(n_observers);
     }
 
-    base_t::x(index) = value;
-}
-Eigen::VectorXd base_t::get_state()
-{
-    return base_t::x;
+    observation_buffer_t::m_averaging = enabled;
 }
-double_t base_t::covariance(uint32_t index_a, uint32_t index_b) const
+void observation_buffer_t::flag(uint32_t observer_index)
 {
-    // Check if indices is valid.
-    if(index_a >= base_t::n_x || index_b >= base_t::n_x)
+    // Track the observer if it has no observation yet.
+    // NOTE: Indices are kept in ascending order so that filters can read them without sorting.
+    if(!observation_buffer_t::m_flags[observer_index])
     {
-        throw std::runtime_error("invalid state variable index");
+        observation_buffer_t::m_flags[observer_index] = 1;
+        observation_buffer_t::m_indices.insert(std::upper_bound(observation_buffer_t::m_indices.begin(), observation_buffer_t::m_indices.end(), observer_index), observer_index);
     }
-
-    return base_t::P(index_a, index_b);
 }
-void base_t::set_covariance(uint32_t index_a, uint32_t index_b, double_t value)
+void observation_buffer_t::clear_noise(uint32_t observer_index)
 {
-    // Check if indices is valid.
-    if(index_a >= base_t::n_x || index_b >= base_t::n_x)
+    // Reset the observer's noise flag.
+    observation_buffer_t::m_noise_flags[observer_index] = 0;
+
+    // Zero the observer's noise row and column, including correlations with other observers.
+    if(observation_buffer_t::m_noise.size() != 0)
     {
-        throw std::runtime_error("invalid state variable index");
+        observation_buffer_t::m_noise.row(observer_index).setZero();
+        observation_buffer_t::m_noise.col(observer_index).setZero();
     }
-
-    base_t::P(index_a, index_b) = value;
 }
-Eigen::MatrixXd base_t::get_covariance()
+void observation_buffer_t::start_average(uint32_t observer_index)
 {
-    return base_t::P;
+    // Reset accumulators if the observer has no samples yet, or if its samples were replaced by a block.
+    if(!observation_buffer_t::m_flags[observer_index] || observation_buffer_t::m_noise_flags[observer_index])
+    {
+        observation_buffer_t::flag(observer_index);
+        observation_buffer_t::clear_noise(observer_index);
+        observation_buffer_t::m_values(observer_index) = 0.0;
+        observation_buffer_t::m_counts[observer_index] = 0;
+        observation_buffer_t::m_weights(observer_index) = 0.0;
+        observation_buffer_t::m_weighted_values(observer_index) = 0.0;
+    }
 }
-void base_t::initialize_state(const Eigen::VectorXd& x0, const Eigen::MatrixXd& P0)
+bool observation_buffer_t::corrected(uint32_t observer_index) const
 {
-    if (x0.size() != static_cast<int>(n_x))
+    // Observers with their own noise are always corrected.
+    if(observation_buffer_t::m_noise_flags[observer_index])
     {
-        throw std::runtime_error("Initial state vector dimension does not match n_variables.");
+        return true;
     }
-    if (P0.rows() != static_cast<int>(n_x) || P0.cols() != static_cast<int>(n_x))
+    // Averaged observers are corrected if they hold weighted or multiple samples.
+    if(observation_buffer_t::m_averaging && observation_buffer_t::m_flags[observer_index])
     {
-        throw std::runtime_error("Initial covariance matrix dimension does not match n_variables.");
+        return observation_buffer_t::m_weights(observer_index) > 0.0 || observation_buffer_t::m_counts[observer_index] > 1;
     }
 
-    x = x0;
-    P = P0;
+    return false;
 }
-
-// LOGGING
-bool base_t::start_log(const std::string& log_file, uint8_t precision)
+double_t observation_buffer_t::noise(uint32_t i, uint32_t j, const Eigen::MatrixXd& R) const
 {
-    // Stop any existing log.
-    base_t::stop_log();
-
-    // Open the file for writing.
-    base_t::m_log_file.open(log_file.c_str());
-
-    // Verify that the file opened correctly.
-    if(base_t::m_log_file.fail())
+    // Check if either observer has its own (uncorrelated) noise.
+    bool weighted_i = observation_buffer_t::m_averaging && observation_buffer_t::m_flags[i] && !observation_buffer_t::m_noise_flags[i] && observation_buffer_t::m_weights(i) > 0.0;
+    bool weighted_j = observation_buffer_t::m_averaging && observation_buffer_t::m_flags[j] && !observation_buffer_t::m_noise_flags[j] && observation_buffer_t::m_weights(j) > 0.0;
+    if(observation_buffer_t::m_noise_flags[i] || observation_buffer_t::m_noise_flags[j] || weighted_i || weighted_j)
     {
-        // Close the stream and clear flags.
-        base_t::m_log_file.close();
-        base_t::m_log_file.clear();
-
-        return false;
+        // Observers within the same noise block.
+        if(observation_buffer_t::m_noise_flags[i] && observation_buffer_t::m_noise_flags[j])
+        {
+            return observation_buffer_t::m_noise(i, j);
+        }
+        // Inverse variance weighted average, with unweighted samples given the variance from R.
+        if(i == j)
+        {
+            return 1.0 / (observation_buffer_t::m_weights(i) + static_cast<double_t>(observation_buffer_t::m_counts[i]) / R(i, i));
+        }
+        return 0.0;
     }
 
-    // Set precision output for the file.
-    base_t::m_log_file << std::fixed << std::setprecision(precision);
-
-    // Write the header line.
-    for(uint32_t i = 0; i < base_t::n_x; ++i)
+    // Scale R by 1/sqrt(n) for each averaged observer.
+    double_t noise = R(i, j);
+    if(observation_buffer_t::m_averaging)
     {
-        base_t::m_log_file << "xp_" << i << ",";
+        if(observation_buffer_t::m_flags[i] && observation_buffer_t::m_counts[i] > 1)
+        {
+            noise /= std::sqrt(static_cast<double_t>(observation_buffer_t::m_counts[i]));
+        }
+        if(observation_buffer_t::m_flags[j] && observation_buffer_t::m_counts[j] > 1)
+        {
+            noise /= std::sqrt(static_cast<double_t>(observation_buffer_t::m_counts[j]));
+        }
     }
-    for(uint32_t i = 0; i < base_t::n_z; ++i)
+    return noise;
+}
+bool observation_buffer_t::empty() const
+{
+    return observation_buffer_t::m_indices.empty();
+}
+uint32_t observation_buffer_t::size() const
+{
+    return observation_buffer_t::m_indices.size();
+}
+bool observation_buffer_t::contains(uint32_t observer_index) const
+{
+    return observation_buffer_t::m_flags[observer_index] != 0;
+}
+double_t observation_buffer_t::value(uint32_t observer_index, const Eigen::MatrixXd& R) const
+{
+    // Return stored observations directly.
+    if(!observation_buffer_t::m_averaging || observation_buffer_t::m_noise_flags[observer_index])
     {
-        base_t::m_log_file << "zp_" << i << ",";
+        return observation_buffer_t::m_values(observer_index);
     }
-    for(uint32_t i = 0; i < base_t::n_z; ++i)
+
+    // Fuse averaged samples.
+    double_t count = static_cast<double_t>(observation_buffer_t::m_counts[observer_index]);
+    double_t weight = observation_buffer_t::m_weights(observer_index);
+    if(weight == 0.0)
     {
-        base_t::m_log_file << "za_" << i << ",";
+        return observation_buffer_t::m_values(observer_index) / count;
     }
-    for(uint32_t i = 0; i < base_t::n_x; ++i)
+    double_t r = R(observer_index, observer_index);
+    return (observation_buffer_t::m_weighted_values(observer_index) + observation_buffer_t::m_values(observer_index) / r) / (weight + count / r);
+}
+const std::vector<uint32_t>& observation_buffer_t::indices() const
+{
+    return observation_buffer_t::m_indices;
+}
+bool observation_buffer_t::averaging() const
+{
+    return observation_buffer_t::m_averaging;
+}
+void observation_buffer_t::add_noise(const Eigen::MatrixXd& R, Eigen::MatrixXd& S) const
+{
+    // Add the static noise covariance.
+    S += R;
+
+    // Correct the rows and columns of observers whose noise differs from R.
+    uint32_t n_z = R.rows();
+    for(auto i = observation_buffer_t::m_indices.begin(); i != observation_buffer_t::m_indices.end(); ++i)
     {
-        base_t::m_log_file << "xe_" << i;
-        if(i + 1 < base_t::n_x)
+        if(observation_buffer_t::corrected(*i))
         {
-            base_t::m_log_file << ",";
+            for(uint32_t j = 0; j < n_z; ++j)
+            {
+                // NOTE: Pairs of corrected observers are corrected once.
+                if(!observation_buffer_t::corrected(j) || j >= *i)
+                {
+                    double_t delta = observation_buffer_t::noise(*i, j, R) - R(*i, j);
+                    S(*i, j) += delta;
+                    if(j != *i)
+                    {
+                        S(j, *i) += delta;
+                    }
+                }
+            }
         }
     }
-    base_t::m_log_file << std::endl;
-
-    return true;
 }
-void base_t::stop_log()
+bool observation_buffer_t::corrected() const
 {
-    // Check if a log is running.
-    if(base_t::m_log_file.is_open())
+    for(auto i = observation_buffer_t::m_indices.begin(); i != observation_buffer_t::m_indices.end(); ++i)
     {
-        // Close the stream and reset flags.
-        base_t::m_log_file.close();
-        base_t::m_log_file.clear();
+        if(observation_buffer_t::corrected(*i))
+        {
+            return true;
+        }
     }
+    return false;
 }
-void base_t::log_predicted_state()
+
+// HEALTH MONITOR
+health_monitor_t::health_monitor_t(uint32_t n_observers, uint32_t window, double_t probability)
+{
+    // Allocate the thresholds.
+    health_monitor_t::m_thresholds.resize(n_observers + 1);
+
+    // Initialize the snapshot.
+    health_monitor_t::m_health = {0, 0, 0.0, 0.0, 0.0, 0.0};
+    health_monitor_t::m_sequence.store(0, std::memory_order_release);
+
+    // Calculate thresholds and allocate the window.
+    health_monitor_t::configure(window, probability);
+}
+void health_monitor_t::add(double_t nis, uint32_t n_observations)
 {
-    if(base_t::m_log_file.is_open())
+    uint32_t window = health_monitor_t::m_nis.size();
+    uint32_t i = health_monitor_t::m_next;
+
+    // Replace the oldest update in the window.
+    double_t ratio = nis / n_observations;
+    uint8_t exceeded = nis > health_monitor_t::m_thresholds[n_observations];
+    health_monitor_t::m_nis_sum += nis - health_monitor_t::m_nis[i];
+    health_monitor_t::m_ratio_sum += ratio - health_monitor_t::m_ratios[i];
+    health_monitor_t::m_exceeded_count += exceeded;
+    health_monitor_t::m_exceeded_count -= health_monitor_t::m_exceeded[i];
+    health_monitor_t::m_nis[i] = nis;
+    health_monitor_t::m_ratios[i] = ratio;
+    health_monitor_t::m_exceeded[i] = exceeded;
+    health_monitor_t::m_next = (i + 1 == window) ? 0 : i + 1;
+
+    // Recalculate the running sums once per window to remove accumulated rounding error.
+    if(health_monitor_t::m_next == 0)
     {
-        for(uint32_t i = 0; i < base_t::n_x; ++i)
+        health_monitor_t::m_nis_sum = 0.0;
+        health_monitor_t::m_ratio_sum = 0.0;
+        for(uint32_t j = 0; j < window; ++j)
         {
-            base_t::m_log_file << base_t::x(i) << ",";
+            health_monitor_t::m_nis_sum += health_monitor_t::m_nis[j];
+            health_monitor_t::m_ratio_sum += health_monitor_t::m_ratios[j];
         }
     }
+
+    // Mark write as in progress (odd sequence).
+    uint64_t sequence = health_monitor_t::m_sequence.load(std::memory_order_relaxed);
+    health_monitor_t::m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Write the snapshot.
+    // NOTE: The condition estimate is written separately by add_covariance().
+    health_t& health = health_monitor_t::m_health;
+    ++health.n_updates;
+    health.n_window = std::min<uint64_t>(health.n_updates, window);
+    health.nis_mean = health_monitor_t::m_nis_sum / health.n_window;
+    health.nis_ratio = health_monitor_t::m_ratio_sum / health.n_window;
+    health.exceedance_rate = static_cast<double_t>(health_monitor_t::m_exceeded_count) / health.n_window;
+
+    // Mark write as complete (even sequence).
+    health_monitor_t::m_sequence.store(sequence + 2, std::memory_order_release);
+}
+void health_monitor_t::add_covariance(const Eigen::MatrixXd& P)
+{
+    // Estimate the condition number of P from its diagonal.
+    // NOTE: A non-positive or non-finite diagonal element means P is singular or invalid, which is reported as infinite.
+    double_t condition = std::numeric_limits<double_t>::infinity();
+    double_t p_min = P.diagonal().minCoeff();
+    double_t p_max = P.diagonal().maxCoeff();
+    if(p_min > 0.0 && std::isfinite(p_max))
+    {
+        condition = p_max / p_min;
+    }
+
+    // Mark write as in progress (odd sequence).
+    uint64_t sequence = health_monitor_t::m_sequence.load(std::memory_order_relaxed);
+    health_monitor_t::m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Write the condition estimate.
+    health_monitor_t::m_health.condition = condition;
+
+    // Mark write as complete (even sequence).
+    health_monitor_t::m_sequence.store(sequence + 2, std::memory_order_release);
 }
-void base_t::log_observations(bool empty)
+void health_monitor_t::clear()
+{
+    // Empty the window.
+    std::fill(health_monitor_t::m_nis.begin(), health_monitor_t::m_nis.end(), 0.0);
+    std::fill(health_monitor_t::m_ratios.begin(), health_monitor_t::m_ratios.end(), 0.0);
+    std::fill(health_monitor_t::m_exceeded.begin(), health_monitor_t::m_exceeded.end(), 0);
+    health_monitor_t::m_next = 0;
+    health_monitor_t::m_nis_sum = 0.0;
+    health_monitor_t::m_ratio_sum = 0.0;
+    health_monitor_t::m_exceeded_count = 0;
+
+    // Mark write as in progress (odd sequence).
+    uint64_t sequence = health_monitor_t::m_sequence.load(std::memory_order_relaxed);
+    health_monitor_t::m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Write the empty snapshot.
+    health_monitor_t::m_health = {0, 0, 0.0, 0.0, 0.0, 0.0};
+
+    // Mark write as complete (even sequence).
+    health_monitor_t::m_sequence.store(sequence + 2, std::memory_order_release);
+}
+void health_monitor_t::configure(uint32_t window, double_t probability)
 {
-    if(base_t::m_log_file.is_open())
+    // Find the standard normal quantile of the probability by bisection.
+    double_t z_low = -10.0;
+    double_t z_high = 10.0;
+    for(uint32_t i = 0; i < 64; ++i)
     {
-        if(empty)
+        double_t z = 0.5 * (z_low + z_high);
+        if(0.5 * std::erfc(-z / std::sqrt(2.0)) < probability)
         {
-            for(uint32_t i = 0; i < 2*base_t::n_z; ++i)
-            {
-                base_t::m_log_file << ",";
-            }
+            z_low = z;
         }
         else
         {
-            // Predicted observations.
-            for(uint32_t i = 0; i < base_t::n_z; ++i)
-            {
-                base_t::m_log_file << base_t::z(i) << ",";
-            }
-            // Actual observations.
-            for(uint32_t i = 0; i < base_t::n_z; ++i)
-            {
-                auto observation = base_t::m_observations.find(i);
-                if(observation != base_t::m_observations.end())
-                {
-                    base_t::m_log_file << observation->second;
-                }
-                base_t::m_log_file << ",";
-            }
+            z_high = z;
         }
     }
+    double_t z = 0.5 * (z_low + z_high);
+
+    // Calculate the chi-square threshold for each number of observations.
+    // NOTE: Uses the Wilson-Hilferty approximation, which is within a few percent even for one degree of freedom.
+    health_monitor_t::m_thresholds[0] = 0.0;
+    for(uint32_t k = 1; k < health_monitor_t::m_thresholds.size(); ++k)
+    {
+        double_t a = 2.0 / (9.0 * k);
+        health_monitor_t::m_thresholds[k] = k * std::pow(1.0 - a + z * std::sqrt(a), 3.0);
+    }
+
+    // Resize the window.
+    // NOTE: Readers only access the snapshot, so the window may be reallocated while they read.
+    health_monitor_t::m_nis.resize(window);
+    health_monitor_t::m_ratios.resize(window);
+    health_monitor_t::m_exceeded.resize(window);
+
+    // Empty the window and snapshot.
+    health_monitor_t::clear();
 }
-void base_t::log_estimated_state()
+void health_monitor_t::read(health_t& health) const
 {
-    if(base_t::m_log_file.is_open())
+    while(true)
     {
-        for(uint32_t i = 0; i < base_t::n_x; ++i)
+        // Wait for any write in progress to complete.
+        uint64_t sequence = health_monitor_t::m_sequence.load(std::memory_order_acquire);
+        if(sequence & 1)
         {
-            base_t::m_log_file << base_t::x(i);
-            if(i + 1 < base_t::n_x)
-            {
-                base_t::m_log_file << ",";
-            }
+            continue;
+        }
+
+        // Copy the snapshot and verify it was not written during the copy.
+        health = health_monitor_t::m_health;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(health_monitor_t::m_sequence.load(std::memory_order_relaxed) == sequence)
+        {
+            return;
         }
-        base_t::m_log_file << std::endl;
     }
+}
+double_t health_monitor_t::threshold(uint32_t n_observations) const
+{
+    return health_monitor_t::m_thresholds[n_observations];
+}
+
+// CONSTRUCTORS
+base_t::base_t(uint32_t n_variables, uint32_t n_observers)
+    : m_observations(n_observers),
+      m_health_enabled(false)
+{
+    // Store dimension sizes.
+    base_t::n_x = n_variables;
+    base_t::n_z = n_observers;
+
+    // Allocate prediction components.
+    base_t::x.setZero(base_t::n_x);
+    base_t::P.setIdentity(base_t::n_x, base_t::n_x);
+    base_t::Q.setIdentity(base_t::n_x, base_t::n_x);
+
+    // Allocate update components.
+    base_t::R.setIdentity(base_t::n_z, base_t::n_z);
+    base_t::z.setZero(base_t::n_z);
+    base_t::S.setZero(base_t::n_z, base_t::n_z);
+    base_t::C.setZero(base_t::n_x, base_t::n_z);
+
+    // Allocate temporaries.
+    base_t::t_xx.setZero(base_t::n_x, base_t::n_x);
+
+    // Allocate the masked update workspace for S_m, C_m, K_m', zd_m, and one temporary.
+    base_t::m_workspace.setZero(base_t::n_z * base_t::n_z + 2 * base_t::n_x * base_t::n_z + 2 * base_t::n_z);
+
+    // Use internal observation storage.
+    base_t::m_observation_source = &(base_t::m_observations);
+
+    // Initialize update statistics.
+    base_t::m_nis = 0.0;
+    base_t::m_log_likelihood = 0.0;
+
+    // Initialize iteration count.
+    base_t::m_iterations = 0;
+
+    // Initialize deadline planning.
+    base_t::m_planned = 0;
+    base_t::m_taken = 0;
+    base_t::m_timing = false;
+    std::fill(base_t::m_component_costs, base_t::m_component_costs + 3, 0.0);
+    std::fill(base_t::m_component_times, base_t::m_component_times + 3, 0.0);
+    std::fill(base_t::m_base_costs, base_t::m_base_costs + 2, 0.0);
+
+    // Initialize deferred covariance update.
+    // NOTE: Deferred update storage is allocated on first use.
+    base_t::m_deferred_n = 0;
+    base_t::m_deferred_conditioning = false;
+
+    // Initialize status API.
+    // NOTE: The repair eigensolver is preallocated so that repairs do not allocate.
+    base_t::m_nothrow = false;
+    base_t::m_status = status_t::OK;
+    base_t::m_repair = Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd>(base_t::n_x);
+}
+base_t::base_t(const base_t& other)
+    : Q(other.Q),
+      R(other.R),
+      n_x(other.n_x),
+      n_z(other.n_z),
+      x(other.x),
+      P(other.P),
+      z(other.z),
+      S(other.S),
+      C(other.C),
+      t_xx(other.t_xx),
+      m_observations(*other.m_observation_source),
+      m_nis(other.m_nis),
+      m_log_likelihood(other.m_log_likelihood),
+      m_workspace(other.m_workspace),
+      m_health_enabled(false),
+      m_planned(0),
+      m_taken(other.m_taken),
+      m_timing(false),
+      m_deferred_n(0),
+      m_deferred_conditioning(false),
+      m_iterations(other.m_iterations)
+{
+    // Use internal observation storage.
+    base_t::m_observation_source = &(base_t::m_observations);
+
+    // Copy cost estimates.
+    std::copy(other.m_component_costs, other.m_component_costs + 3, base_t::m_component_costs);
+    std::fill(base_t::m_component_times, base_t::m_component_times + 3, 0.0);
+    std::copy(other.m_base_costs, other.m_base_costs + 2, base_t::m_base_costs);
+
+    // Copy the deferred covariance update.
+    if(other.m_deferred_n > 0)
+    {
+        base_t::m_deferred_n = other.m_deferred_n;
+        base_t::m_deferred_conditioning = other.m_deferred_conditioning;
+        base_t::m_deferred = other.m_deferred;
+    }
+
+    // Initialize status API.
+    base_t::m_nothrow = false;
+    base_t::m_status = status_t::OK;
+    base_t::m_repair = Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd>(base_t::n_x);
+}
+base_t::~base_t()
+{
+    // Stop logging if running.
+    base_t::stop_log();
+
+    // Stop publishing if running.
+    base_t::stop_publishing();
+}
+
+// CLONING
+std::unique_ptr<base_t> base_t::clone() const
+{
+    return nullptr;
+}
+
+// RESETTING
+void base_t::reset()
+{
+    // Remove pending observations.
+    base_t::m_observation_source->clear();
+
+    // Discard deferred covariance propagation.
+    discard_covariance();
+
+    // Clear statistics.
+    base_t::m_nis = 0.0;
+    base_t::m_log_likelihood = 0.0;
+    base_t::m_iterations = 0;
+    base_t::m_status = status_t::OK;
+    if(base_t::m_health_enabled.load(std::memory_order_relaxed))
+    {
+        base_t::m_health->clear();
+    }
+}
+
+// FILTER METHODS
+void base_t::iterate()
+{
+    // NOTE: Calls are unqualified to dispatch to the derived filter.
+    uint64_t iteration = base_t::m_iterations;
+    bool predicted = false;
+    try
+    {
+        predict();
+        predicted = true;
+        update();
+    }
+    catch(...)
+    {
+        // Complete the failed iteration unless it already was.
+        if(base_t::m_iterations == iteration)
+        {
+            base_t::complete_failed_iteration(predicted);
+        }
+        throw;
+    }
+}
+void base_t::new_observation(uint32_t observer_index, double_t observation)
+{
+    // Verify index exists.
+    if(!(observer_index < base_t::n_z))
+    {
+        throw std::runtime_error("failed to add new observation (observer_index out of range)");
+    }
+    
+    // Store observation in the observation buffer.
+    // NOTE: This adds or replaces the observation at the specified observer index.
+    base_t::m_observation_source->insert(observer_index, observation);
+}
+void base_t::new_observations(const uint32_t* observer_indices, const double_t* observations, uint32_t count)
+{
+    // Verify all indices exist before storing any observations.
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        if(!(observer_indices[i] < base_t::n_z))
+        {
+            throw std::runtime_error("failed to add new observations (observer_index out of range)");
+        }
+    }
+
+    // Store observations in the observation buffer.
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        base_t::m_observation_source->insert(observer_indices[i], observations[i]);
+    }
+}
+void base_t::new_observations(uint32_t first_observer_index, const double_t* observations, uint32_t count)
+{
+    // Verify the range of indices exists.
+    if(first_observer_index > base_t::n_z || count > base_t::n_z - first_observer_index)
+    {
+        throw std::runtime_error("failed to add new observations (observer_index out of range)");
+    }
+
+    // Store observations in the observation buffer.
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        base_t::m_observation_source->insert(first_observer_index + i, observations[i]);
+    }
+}
+void base_t::new_observation(uint32_t observer_index, double_t observation, double_t variance)
+{
+    // Verify index exists.
+    if(!(observer_index < base_t::n_z))
+    {
+        throw std::runtime_error("failed to add new observation (observer_index out of range)");
+    }
+    // Verify the variance.
+    if(!observation_buffer_t::valid_variance(variance))
+    {
+        throw std::runtime_error("failed to add new observation (variance is not positive and finite)");
+    }
+
+    // Store observation and its noise in the observation buffer.
+    base_t::m_observation_source->insert(observer_index, observation, variance);
+}
+void base_t::new_observations(uint32_t first_observer_index, const Eigen::VectorXd& observations, const Eigen::MatrixXd& covariance)
+{
+    // Verify the range of indices exists.
+    uint32_t count = observations.size();
+    if(first_observer_index > base_t::n_z || count > base_t::n_z - first_observer_index)
+    {
+        throw std::runtime_error("failed to add new observations (observer_index out of range)");
+    }
+    // Verify the covariance dimensions.
+    if(covariance.rows() != observations.size() || covariance.cols() != observations.size())
+    {
+        throw std::runtime_error("failed to add new observations (covariance dimension does not match observations)");
+    }
+    // Verify the covariance.
+    if(!observation_buffer_t::valid_covariance(covariance))
+    {
+        throw std::runtime_error("failed to add new observations (covariance is not finite and symmetric with a positive diagonal)");
+    }
+
+    // Store observations and their noise in the observation buffer.
+    base_t::m_observation_source->insert(first_observer_index, observations, covariance);
+}
+void base_t::set_observation_averaging(bool enabled)
+{
+    base_t::m_observation_source->set_averaging(enabled);
+}
+bool base_t::observation_averaging() const
+{
+    return base_t::m_observation_source->averaging();
+}
+bool base_t::has_observations() const
+{
+    return !base_t::m_observation_source->empty();
+}
+bool base_t::has_observation(uint32_t observer_index) const
+{
+    return observer_index < base_t::n_z && base_t::m_observation_source->contains(observer_index);
+}
+void base_t::add_observation_noise(Eigen::MatrixXd& S) const
+{
+    base_t::m_observation_source->add_noise(base_t::R, S);
+}
+bool base_t::has_observation_noise() const
+{
+    return base_t::m_observation_source->corrected();
+}
+bool base_t::masked_kalman_update()
+{
+    // Get the indices of the active observations in ascending order.
+    // NOTE: The observation source is only read, as IMM modes share it across threads.
+    const std::vector<uint32_t>& observers = base_t::m_observation_source->indices();
+
+    // Get number of observations.
+    uint32_t n_o = observers.size();
+
+    // Map masked versions of S, C, K', and za-z onto the preallocated workspace.
+    // NOTE: The workspace is one contiguous block sized for all observers, so updates do not allocate.
+    double_t* block = base_t::m_workspace.data();
+    Eigen::Map<Eigen::MatrixXd> S_m(block, n_o, n_o);
+    block += n_o * n_o;
+    Eigen::Map<Eigen::MatrixXd> C_m(block, base_t::n_x, n_o);
+    block += base_t::n_x * n_o;
+    Eigen::Map<Eigen::MatrixXd> Kt_m(block, n_o, base_t::n_x);
+    block += n_o * base_t::n_x;
+    Eigen::Map<Eigen::VectorXd> zd_m(block, n_o);
+    block += n_o;
+    Eigen::Map<Eigen::VectorXd> w_m(block, n_o);
+
+    // Iterate over z indices.
+    uint32_t m_i = 0;
+    uint32_t m_j = 0;
+    // Iterate column first.
+    for(auto j = observers.begin(); j != observers.end(); ++j)
+    {
+        // Iterate over rows to populate S_m.
+        for(auto i = observers.begin(); i != observers.end(); ++i)
+        {
+            // Copy the selected S element into S_m.
+            S_m(m_i++, m_j) = base_t::S(*i, *j);
+        }
+        m_i = 0;
+
+        // Copy the selected C column into C_m.
+        C_m.col(m_j++) = base_t::C.col(*j);
+    }
+
+    // Create masked version of za-z.
+    m_i = 0;
+    for(auto observer = observers.begin(); observer != observers.end(); ++observer)
+    {
+        zd_m(m_i++) = base_t::m_observation_source->value(*observer, base_t::R) - base_t::z(*observer);
+    }
+
+    // Factorize masked S in place.
+    Eigen::LLT<Eigen::Ref<Eigen::MatrixXd>> llt(S_m);
+    if(llt.info() == Eigen::ComputationInfo::Success)
+    {
+        // Calculate transposed Kalman gain (masked by n observations): K' = S^-1 * C'.
+        Kt_m = C_m.transpose();
+        llt.solveInPlace(Kt_m);
+
+        // Calculate normalized innovation squared and the log-likelihood of the observations.
+        // NOTE: NIS = |L^-1 * zd|^2 and log|S| = 2 * sum(log(diag(L))).
+        w_m = zd_m;
+        llt.matrixL().solveInPlace(w_m);
+        base_t::m_nis = w_m.squaredNorm();
+        base_t::m_log_likelihood = -0.5 * (base_t::m_nis + 2.0 * llt.matrixLLT().diagonal().array().log().sum() + static_cast<double_t>(n_o) * std::log(2.0 * M_PI));
+    }
+    else
+    {
+        // The status API reports S as not positive definite so that P can be repaired.
+        if(base_t::m_nothrow)
+        {
+            base_t::fail(status_t::NOT_POSITIVE_DEFINITE, "observation covariance matrix S is not positive definite (update)");
+            return false;
+        }
+
+        // The throwing API updates with any invertible S, as the LLT only factorizes positive definite matrices.
+        // NOTE: The failed factorization overwrote S_m, so it is copied again. This path allocates.
+        for(uint32_t j = 0; j < n_o; ++j)
+        {
+            for(uint32_t i = 0; i < n_o; ++i)
+            {
+                S_m(i, j) = base_t::S(observers[i], observers[j]);
+            }
+        }
+        Eigen::PartialPivLU<Eigen::MatrixXd> lu(S_m);
+
+        // Calculate transposed Kalman gain (masked by n observations): K' = S^-1 * C'.
+        Kt_m = lu.solve(C_m.transpose());
+
+        // Calculate normalized innovation squared and the log-likelihood of the observations.
+        // NOTE: NIS = zd' * S^-1 * zd. An indefinite S has no likelihood, so |S| is used in place of the determinant.
+        w_m = lu.solve(zd_m);
+        base_t::m_nis = zd_m.dot(w_m);
+        base_t::m_log_likelihood = -0.5 * (base_t::m_nis + std::log(std::abs(lu.determinant())) + static_cast<double_t>(n_o) * std::log(2.0 * M_PI));
+    }
+
+    // Update state.
+    base_t::x.noalias() += Kt_m.transpose() * zd_m;
+
+    // Stage the gains and innovation covariance for logging.
+    if(base_t::m_log.is_open())
+    {
+        base_t::log_update(Kt_m, observers);
+    }
+
+    // Defer the covariance update to the start of the next iteration if planned.
+    // NOTE: C_m and K_m' are copied out of the workspace, as it is reused by the next update.
+    if(base_t::degrade(degradation_t::DEFER_COVARIANCE))
+    {
+        if(base_t::m_deferred.size() == 0)
+        {
+            base_t::m_deferred.setZero(2 * base_t::n_x * base_t::n_z);
+        }
+        Eigen::Map<Eigen::MatrixXd>(base_t::m_deferred.data(), base_t::n_x, n_o) = C_m;
+        Eigen::Map<Eigen::MatrixXd>(base_t::m_deferred.data() + base_t::n_x * n_o, n_o, base_t::n_x) = Kt_m;
+        base_t::m_deferred_n = n_o;
+        base_t::m_deferred_conditioning = !base_t::degrade(degradation_t::SKIP_CONDITIONING);
+    }
+    else
+    {
+        // Update covariance.
+        // NOTE: K*S*K' = C*S^-1*C' = C*K'.
+        auto start = base_t::start_timing();
+        base_t::P.noalias() -= C_m * Kt_m;
+        base_t::stop_timing(component_t::COVARIANCE, start);
+
+        // Protect against non-positive definite covariance matrices.
+        if(!base_t::degrade(degradation_t::SKIP_CONDITIONING))
+        {
+            start = base_t::start_timing();
+            base_t::condition_covariance(base_t::P);
+            base_t::stop_timing(component_t::CONDITIONING, start);
+        }
+    }
+
+    // Add the update to the health statistics.
+    // NOTE: A deferred covariance update adds its condition estimate when it is applied.
+    if(base_t::m_health_enabled.load(std::memory_order_relaxed))
+    {
+        base_t::m_health->add(base_t::m_nis, n_o);
+        if(base_t::m_deferred_n == 0)
+        {
+            base_t::m_health->add_covariance(base_t::P);
+        }
+    }
+
+    // Reset observations.
+    // NOTE: Shared observation streams are reset by their owner.
+    if(base_t::m_observation_source == &(base_t::m_observations))
+    {
+        base_t::m_observations.clear();
+    }
+
+    return true;
+}
+
+void base_t::condition_covariance(Eigen::MatrixXd& P) const
+{
+    // Force symmetric matrix.
+    for(uint32_t i = 0; i < base_t::n_x; ++i)
+    {
+        for(uint32_t j = i + 1; j < base_t::n_x; ++j)
+        {
+            P(i,j) = (P(i,j) + P(j,i)) / 2.0;
+            P(j,i) = P(i,j);
+        }
+    }
+    // Force full rank and clean out small numbers.
+    for(uint32_t i = 0; i < base_t::n_x; ++i)
+    {
+        double_t row_sum = 0;
+        // Force symmetry of non-diagonals.
+        for(uint32_t j = 0; j < base_t::n_x; ++j)
+        {
+            if(i!=j)
+            {
+                if(P(i,j) < 1E-3)
+                {
+                    P(i,j) = 0.0;
+                }
+                else
+                {
+                    row_sum += std::abs(P(i,j));
+                }
+            }
+        }
+        // Force PSD by controlling diagonal.
+        if(P(i,i) <= row_sum)
+        {
+            P(i,i) = row_sum + 1E-3;
+        }
+    }
+}
+
+// ACCESS
+uint32_t base_t::n_variables() const
+{
+    return base_t::n_x;
+}
+uint32_t base_t::n_observers() const
+{
+    return base_t::n_z;
+}
+double_t base_t::iteration_cost() const
+{
+    // Estimate the cost of a covariance prediction and a full update.
+    double_t n_x = base_t::n_x;
+    double_t n_z = base_t::n_z;
+    return 2.0*n_x*n_x*n_x + 2.0*n_z*n_x*n_x + n_z*n_z*n_z/3.0;
+}
+uint64_t base_t::n_iterations() const
+{
+    return base_t::m_iterations;
+}
+double_t base_t::state(uint32_t index) const
+{
+    // Check if index is valid.
+    if(index >= base_t::n_x)
+    {
+        throw std::runtime_error("invalid state variable index");
+    }
+
+    return base_t::x(index);
+}
+void base_t::set_state(uint32_t index, double_t value)
+{
+    // Check if index is valid.
+    if(index >= base_t::n_x)
+    {
+        throw std::runtime_error("invalid state variable index");
+    }
+
+    base_t::x(index) = value;
+}
+Eigen::VectorXd base_t::get_state()
+{
+    return base_t::x;
+}
+double_t base_t::covariance(uint32_t index_a, uint32_t index_b) const
+{
+    // Check if indices is valid.
+    if(index_a >= base_t::n_x || index_b >= base_t::n_x)
+    {
+        throw std::runtime_error("invalid state variable index");
+    }
+
+    // Apply deferred covariance propagation.
+    // NOTE: This changes the representation of P, but not its logical value.
+    const_cast<base_t*>(this)->flush_covariance();
+
+    return base_t::P(index_a, index_b);
+}
+void base_t::set_covariance(uint32_t index_a, uint32_t index_b, double_t value)
+{
+    // Check if indices is valid.
+    if(index_a >= base_t::n_x || index_b >= base_t::n_x)
+    {
+        throw std::runtime_error("invalid state variable index");
+    }
+
+    // Apply deferred covariance propagation.
+    flush_covariance();
+
+    base_t::P(index_a, index_b) = value;
+}
+Eigen::MatrixXd base_t::get_covariance()
+{
+    // Apply deferred covariance propagation.
+    flush_covariance();
+
+    return base_t::P;
+}
+const Eigen::VectorXd& base_t::state() const
+{
+    return base_t::x;
+}
+const Eigen::MatrixXd& base_t::covariance() const
+{
+    // Apply deferred covariance propagation.
+    // NOTE: This changes the representation of P, but not its logical value.
+    const_cast<base_t*>(this)->flush_covariance();
+
+    return base_t::P;
+}
+void base_t::covariance(Eigen::MatrixXd& P) const
+{
+    // NOTE: Called virtually, so that filters apply their own deferred propagation.
+    flushed_covariance(P);
+}
+double_t base_t::nis() const
+{
+    return base_t::m_nis;
+}
+double_t base_t::log_likelihood() const
+{
+    return base_t::m_log_likelihood;
+}
+void base_t::set_health_monitoring(uint32_t window, double_t probability)
+{
+    // Disable monitoring for an empty window.
+    // NOTE: The monitor is kept, as health() may be reading it from another thread.
+    if(window == 0)
+    {
+        base_t::m_health_enabled.store(false, std::memory_order_release);
+        return;
+    }
+
+    // Verify the probability.
+    if(!(probability > 0.0 && probability < 1.0))
+    {
+        throw std::runtime_error("failed to set health monitoring (probability out of range)");
+    }
+
+    // Allocate the monitor once, and otherwise reconfigure it in place.
+    if(!base_t::m_health)
+    {
+        base_t::m_health.reset(new health_monitor_t(base_t::n_z, window, probability));
+    }
+    else
+    {
+        base_t::m_health->configure(window, probability);
+    }
+    base_t::m_health_enabled.store(true, std::memory_order_release);
+}
+bool base_t::health(health_t& health) const
+{
+    // NOTE: The acquire ensures the monitor is visible once enabled.
+    if(!base_t::m_health_enabled.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    base_t::m_health->read(health);
+    return true;
+}
+void base_t::initialize_state(const Eigen::VectorXd& x0, const Eigen::MatrixXd& P0)
+{
+    if (x0.size() != static_cast<int>(n_x))
+    {
+        throw std::runtime_error("Initial state vector dimension does not match n_variables.");
+    }
+    if (P0.rows() != static_cast<int>(n_x) || P0.cols() != static_cast<int>(n_x))
+    {
+        throw std::runtime_error("Initial covariance matrix dimension does not match n_variables.");
+    }
+
+    // Discard deferred covariance propagation, as P is replaced.
+    discard_covariance();
+
+    x = x0;
+    P = P0;
+}
+void base_t::flush_covariance()
+{
+    // Check if a covariance update was deferred.
+    if(base_t::m_deferred_n == 0)
+    {
+        return;
+    }
+
+    // Apply the deferred covariance update.
+    uint32_t n_o = base_t::m_deferred_n;
+    Eigen::Map<const Eigen::MatrixXd> C_m(base_t::m_deferred.data(), base_t::n_x, n_o);
+    Eigen::Map<const Eigen::MatrixXd> Kt_m(base_t::m_deferred.data() + base_t::n_x * n_o, n_o, base_t::n_x);
+    auto start = base_t::start_timing();
+    base_t::P.noalias() -= C_m * Kt_m;
+    base_t::stop_timing(component_t::COVARIANCE, start);
+    if(base_t::m_deferred_conditioning)
+    {
+        start = base_t::start_timing();
+        base_t::condition_covariance(base_t::P);
+        base_t::stop_timing(component_t::CONDITIONING, start);
+    }
+
+    // Add the updated covariance to the health statistics.
+    if(base_t::m_health_enabled.load(std::memory_order_relaxed))
+    {
+        base_t::m_health->add_covariance(base_t::P);
+    }
+
+    // Reset deferral.
+    base_t::m_deferred_n = 0;
+}
+void base_t::discard_covariance()
+{
+    base_t::m_deferred_n = 0;
+}
+void base_t::flushed_covariance(Eigen::MatrixXd& P_out) const
+{
+    P_out = base_t::P;
+
+    // Apply any deferred covariance update to the copy.
+    if(base_t::m_deferred_n != 0)
+    {
+        uint32_t n_o = base_t::m_deferred_n;
+        Eigen::Map<const Eigen::MatrixXd> C_m(base_t::m_deferred.data(), base_t::n_x, n_o);
+        Eigen::Map<const Eigen::MatrixXd> Kt_m(base_t::m_deferred.data() + base_t::n_x * n_o, n_o, base_t::n_x);
+        P_out.noalias() -= C_m * Kt_m;
+        if(base_t::m_deferred_conditioning)
+        {
+            base_t::condition_covariance(P_out);
+        }
+    }
+}
+bool base_t::covariance_deferred() const
+{
+    return base_t::m_deferred_n != 0;
+}
+const Eigen::MatrixXd& base_t::current_covariance(Eigen::MatrixXd& P_storage) const
+{
+    // Only copy P if there is deferred propagation to apply.
+    // NOTE: Called virtually, so that filters apply their own deferred propagation.
+    if(!covariance_deferred())
+    {
+        return base_t::P;
+    }
+    flushed_covariance(P_storage);
+    return P_storage;
+}
+
+// DEADLINE
+void base_t::iterate_until(std::chrono::steady_clock::time_point deadline, uint32_t available, double_t minimal_fraction)
+{
+    // ---------- STEP 1: PLANNING ----------
+
+    // Estimate the cost of the iteration with a set of degradations.
+    bool observations = base_t::has_observations();
+    auto estimate = [this, observations, minimal_fraction](uint32_t planned)
+    {
+        const double_t* c = base_t::m_component_costs;
+        double_t cost = base_t::m_base_costs[observations];
+        if(planned & static_cast<uint32_t>(degradation_t::MINIMAL_SIGMA))
+        {
+            cost *= minimal_fraction;
+        }
+        if(observations)
+        {
+            cost += (planned & static_cast<uint32_t>(degradation_t::REUSE_FACTOR)) ? 0.0 : c[0];
+            cost += (planned & static_cast<uint32_t>(degradation_t::DEFER_COVARIANCE)) ? 0.0 : c[1];
+            cost += (planned & static_cast<uint32_t>(degradation_t::SKIP_CONDITIONING)) ? 0.0 : c[2];
+        }
+        // NOTE: A covariance update deferred by the last iteration is applied by this one.
+        if(base_t::m_deferred_n > 0)
+        {
+            cost += c[1] + (base_t::m_deferred_conditioning ? c[2] : 0.0);
+        }
+        return cost;
+    };
+
+    // Take degradations in order until the estimated cost fits in the time remaining.
+    auto start = std::chrono::steady_clock::now();
+    double_t remaining = std::chrono::duration<double_t>(deadline - start).count();
+    uint32_t planned = 0;
+    for(uint32_t degradation = 1; degradation <= static_cast<uint32_t>(degradation_t::DEFER_COVARIANCE) && estimate(planned) > remaining; degradation <<= 1)
+    {
+        planned |= (available & degradation);
+    }
+
+    // ---------- STEP 2: ITERATION ----------
+
+    // Run the iteration with timing enabled.
+    base_t::m_planned = planned;
+    base_t::m_taken = 0;
+    base_t::m_timing = true;
+    std::fill(base_t::m_component_times, base_t::m_component_times + 3, 0.0);
+    uint64_t iteration = base_t::m_iterations;
+    bool predicted = false;
+    try
+    {
+        // NOTE: Calls are unqualified to dispatch to the derived filter.
+        predict();
+        predicted = true;
+        update();
+    }
+    catch(...)
+    {
+        base_t::m_planned = 0;
+        base_t::m_timing = false;
+
+        // Complete the failed iteration unless it already was.
+        if(base_t::m_iterations == iteration)
+        {
+            base_t::complete_failed_iteration(predicted);
+        }
+        throw;
+    }
+    base_t::m_planned = 0;
+    base_t::m_timing = false;
+
+    // ---------- STEP 3: ESTIMATION ----------
+
+    // Update the estimated cost of the work not timed by components, normalized to the full sigma point set.
+    // NOTE: Estimates are exponential moving averages, seeded by the first measurement.
+    double_t base = std::chrono::duration<double_t>(std::chrono::steady_clock::now() - start).count();
+    for(uint32_t c = 0; c < 3; ++c)
+    {
+        base -= base_t::m_component_times[c];
+    }
+    if(base_t::m_taken & static_cast<uint32_t>(degradation_t::MINIMAL_SIGMA))
+    {
+        base /= minimal_fraction;
+    }
+    double_t& estimate_base = base_t::m_base_costs[observations];
+    estimate_base = (estimate_base == 0.0) ? base : estimate_base + 0.25 * (base - estimate_base);
+}
+bool base_t::degrade(degradation_t degradation)
+{
+    uint32_t flag = static_cast<uint32_t>(degradation);
+    if(base_t::m_planned & flag)
+    {
+        base_t::m_taken |= flag;
+        return true;
+    }
+    return false;
+}
+std::chrono::steady_clock::time_point base_t::start_timing() const
+{
+    return base_t::m_timing ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+}
+void base_t::stop_timing(component_t component, std::chrono::steady_clock::time_point start)
+{
+    if(!base_t::m_timing)
+    {
+        return;
+    }
+
+    // Record the component's duration and update its estimated cost.
+    uint32_t c = static_cast<uint32_t>(component);
+    double_t duration = std::chrono::duration<double_t>(std::chrono::steady_clock::now() - start).count();
+    base_t::m_component_times[c] += duration;
+    double_t& estimate = base_t::m_component_costs[c];
+    estimate = (estimate == 0.0) ? duration : estimate + 0.25 * (duration - estimate);
+}
+uint32_t base_t::degradations() const
+{
+    return base_t::m_taken;
+}
+bool base_t::degraded(degradation_t degradation) const
+{
+    return base_t::m_taken & static_cast<uint32_t>(degradation);
+}
+
+// STATUS API
+status_t base_t::try_iterate() noexcept
+{
+    // Run each phase, repairing P if necessary.
+    uint64_t iteration = base_t::m_iterations;
+    status_t predict_status = base_t::try_phase(false);
+    bool predicted = (predict_status != status_t::NOT_POSITIVE_DEFINITE && predict_status != status_t::EXCEPTION);
+    status_t update_status = predicted ? base_t::try_phase(true) : predict_status;
+
+    // Complete a failed iteration, and discard its observations so that they do not fail the next one.
+    // NOTE: Shared observation streams are reset by their owner.
+    if(update_status == status_t::NOT_POSITIVE_DEFINITE || update_status == status_t::EXCEPTION)
+    {
+        if(base_t::m_iterations == iteration)
+        {
+            try
+            {
+                base_t::complete_failed_iteration(predicted);
+            }
+            catch(...)
+            {
+                update_status = status_t::EXCEPTION;
+            }
+        }
+        if(base_t::m_observation_source == &(base_t::m_observations))
+        {
+            base_t::m_observations.clear();
+        }
+        return update_status;
+    }
+
+    return (predict_status == status_t::REPAIRED || update_status == status_t::REPAIRED) ? status_t::REPAIRED : status_t::OK;
+}
+status_t base_t::try_phase(bool update_phase) noexcept
+{
+    base_t::m_nothrow = true;
+
+    status_t status = status_t::OK;
+    for(uint32_t attempt = 0; attempt < 2; ++attempt)
+    {
+        // Run the phase.
+        // NOTE: Calls are unqualified to dispatch to the derived filter.
+        // NOTE: Exceptions from model functions or the log writer are caught, as the status API must not throw.
+        base_t::m_status = status_t::OK;
+        try
+        {
+            if(update_phase)
+            {
+                update();
+            }
+            else
+            {
+                predict();
+            }
+        }
+        catch(...)
+        {
+            status = status_t::EXCEPTION;
+            break;
+        }
+        if(!base_t::failed())
+        {
+            break;
+        }
+
+        // Repair P and retry once.
+        // NOTE: Failed phases do not modify x or P, so the retry starts from the same point.
+        if(attempt == 0 && base_t::repair_covariance())
+        {
+            status = status_t::REPAIRED;
+        }
+        else
+        {
+            status = status_t::NOT_POSITIVE_DEFINITE;
+            break;
+        }
+    }
+
+    base_t::m_nothrow = false;
+    base_t::m_status = status_t::OK;
+    return status;
+}
+status_t base_t::try_new_observation(uint32_t observer_index, double_t observation) noexcept
+{
+    if(KALMAN_FILTER_CHECK_BOUNDS && !(observer_index < base_t::n_z))
+    {
+        return status_t::INVALID_INDEX;
+    }
+
+    base_t::m_observation_source->insert(observer_index, observation);
+    return status_t::OK;
+}
+status_t base_t::try_new_observations(const uint32_t* observer_indices, const double_t* observations, uint32_t count) noexcept
+{
+    // Verify all indices exist before storing any observations.
+    if(KALMAN_FILTER_CHECK_BOUNDS)
+    {
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            if(!(observer_indices[i] < base_t::n_z))
+            {
+                return status_t::INVALID_INDEX;
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        base_t::m_observation_source->insert(observer_indices[i], observations[i]);
+    }
+    return status_t::OK;
+}
+status_t base_t::try_state(uint32_t index, double_t& value) const noexcept
+{
+    if(KALMAN_FILTER_CHECK_BOUNDS && index >= base_t::n_x)
+    {
+        return status_t::INVALID_INDEX;
+    }
+
+    value = base_t::x(index);
+    return status_t::OK;
+}
+status_t base_t::try_set_state(uint32_t index, double_t value) noexcept
+{
+    if(KALMAN_FILTER_CHECK_BOUNDS && index >= base_t::n_x)
+    {
+        return status_t::INVALID_INDEX;
+    }
+
+    base_t::x(index) = value;
+    return status_t::OK;
+}
+status_t base_t::try_covariance(uint32_t index_a, uint32_t index_b, double_t& value) const noexcept
+{
+    if(KALMAN_FILTER_CHECK_BOUNDS && (index_a >= base_t::n_x || index_b >= base_t::n_x))
+    {
+        return status_t::INVALID_INDEX;
+    }
+
+    // Apply deferred covariance propagation.
+    // NOTE: This changes the representation of P, but not its logical value.
+    const_cast<base_t*>(this)->flush_covariance();
+
+    value = base_t::P(index_a, index_b);
+    return status_t::OK;
+}
+status_t base_t::try_set_covariance(uint32_t index_a, uint32_t index_b, double_t value) noexcept
+{
+    if(KALMAN_FILTER_CHECK_BOUNDS && (index_a >= base_t::n_x || index_b >= base_t::n_x))
+    {
+        return status_t::INVALID_INDEX;
+    }
+
+    // Apply deferred covariance propagation.
+    flush_covariance();
+
+    base_t::P(index_a, index_b) = value;
+    return status_t::OK;
+}
+void base_t::fail(status_t status, const char* message) const
+{
+    // Throw unless running under the status API.
+    if(!base_t::m_nothrow)
+    {
+        throw std::runtime_error(message);
+    }
+
+    // Record the first failure.
+    if(base_t::m_status == status_t::OK)
+    {
+        base_t::m_status = status;
+    }
+}
+bool base_t::failed() const
+{
+    return base_t::m_status != status_t::OK;
+}
+bool base_t::repair_covariance()
+{
+    // Apply deferred covariance propagation.
+    flush_covariance();
+
+    // Check if P can be repaired.
+    if(!base_t::P.allFinite())
+    {
+        return false;
+    }
+
+    // Force symmetric matrix.
+    base_t::t_xx = base_t::P.transpose();
+    base_t::P += base_t::t_xx;
+    base_t::P *= 0.5;
+
+    // Clamp eigenvalues to a small positive value relative to the largest.
+    base_t::m_repair.compute(base_t::P);
+    if(base_t::m_repair.info() != Eigen::ComputationInfo::Success)
+    {
+        return false;
+    }
+    const Eigen::VectorXd& lambda = base_t::m_repair.eigenvalues();
+    const Eigen::MatrixXd& V = base_t::m_repair.eigenvectors();
+    double_t floor = std::max(1E-9 * lambda.cwiseAbs().maxCoeff(), 1E-12);
+    base_t::t_xx.noalias() = V * lambda.cwiseMax(floor).asDiagonal();
+    base_t::P.noalias() = base_t::t_xx * V.transpose();
+
+    return true;
+}
+
+// CHECKPOINTING
+void base_t::checkpoint_fields(std::vector<std::pair<double_t*, uint32_t>>& fields)
+{
+    fields.emplace_back(base_t::x.data(), base_t::x.size());
+    fields.emplace_back(base_t::P.data(), base_t::P.size());
+    fields.emplace_back(base_t::Q.data(), base_t::Q.size());
+    fields.emplace_back(base_t::R.data(), base_t::R.size());
+}
+void base_t::checkpoint_fields(std::vector<std::pair<const double_t*, uint32_t>>& fields) const
+{
+    fields.emplace_back(base_t::x.data(), base_t::x.size());
+    fields.emplace_back(base_t::P.data(), base_t::P.size());
+    fields.emplace_back(base_t::Q.data(), base_t::Q.size());
+    fields.emplace_back(base_t::R.data(), base_t::R.size());
+}
+bool base_t::save_checkpoint(const std::string& checkpoint_file) const
+{
+    // Serialize the checkpoint.
+    std::vector<uint8_t> checkpoint;
+    base_t::save_checkpoint(checkpoint);
+
+    // Write the checkpoint to the file.
+    std::ofstream file(checkpoint_file.c_str(), std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(checkpoint.data()), checkpoint.size());
+    file.close();
+
+    return !file.fail();
+}
+void base_t::save_checkpoint(std::vector<uint8_t>& checkpoint) const
+{
+    // Collect fields.
+    std::vector<std::pair<const double_t*, uint32_t>> fields;
+    checkpoint_fields(fields);
+
+    // Save P with any deferred covariance propagation applied, without flushing the filter.
+    Eigen::MatrixXd P_flushed;
+    flushed_covariance(P_flushed);
+    for(auto field = fields.begin(); field != fields.end(); ++field)
+    {
+        if(field->first == base_t::P.data())
+        {
+            field->first = P_flushed.data();
+        }
+    }
+
+    // Calculate total size of the checkpoint.
+    size_t offset = checkpoint_data_offset(fields.size());
+    size_t size = offset;
+    for(auto field = fields.begin(); field != fields.end(); ++field)
+    {
+        size += field->second * sizeof(double_t);
+    }
+    checkpoint.assign(size, 0);
+
+    // Write header.
+    checkpoint_header_t header;
+    header.magic = checkpoint_magic;
+    header.version = checkpoint_version;
+    header.type = static_cast<uint32_t>(filter_type());
+    header.n_variables = base_t::n_x;
+    header.n_observers = base_t::n_z;
+    header.n_fields = fields.size();
+    std::memcpy(checkpoint.data(), &header, sizeof(header));
+
+    // Write field sizes and data.
+    uint8_t* field_size = checkpoint.data() + sizeof(header);
+    uint8_t* field_data = checkpoint.data() + offset;
+    for(auto field = fields.begin(); field != fields.end(); ++field)
+    {
+        std::memcpy(field_size, &field->second, sizeof(uint32_t));
+        field_size += sizeof(uint32_t);
+        if(field->second > 0)
+        {
+            std::memcpy(field_data, field->first, field->second * sizeof(double_t));
+            field_data += field->second * sizeof(double_t);
+        }
+    }
+}
+bool base_t::load_checkpoint(const std::string& checkpoint_file)
+{
+    // Open the file for reading.
+    int32_t file = open(checkpoint_file.c_str(), O_RDONLY);
+    if(file < 0)
+    {
+        return false;
+    }
+
+    // Get the size of the file.
+    struct stat file_stat;
+    if(fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+    size_t size = file_stat.st_size;
+
+    // Map the file into memory.
+    void* checkpoint = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if(checkpoint == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // Load the checkpoint from the mapped memory.
+    bool result = base_t::load_checkpoint(checkpoint, size);
+
+    // Unmap the file.
+    munmap(checkpoint, size);
+
+    return result;
+}
+bool base_t::load_checkpoint(const void* checkpoint, size_t size)
+{
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(checkpoint);
+
+    // Read and verify header.
+    checkpoint_header_t header;
+    if(size < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if(header.magic != checkpoint_magic || header.version != checkpoint_version || header.type != static_cast<uint32_t>(filter_type()) || header.n_variables != base_t::n_x || header.n_observers != base_t::n_z)
+    {
+        return false;
+    }
+
+    // Collect fields and verify that they match the checkpoint.
+    std::vector<std::pair<double_t*, uint32_t>> fields;
+    checkpoint_fields(fields);
+    size_t offset = checkpoint_data_offset(header.n_fields);
+    if(header.n_fields != fields.size() || size < offset)
+    {
+        return false;
+    }
+    size_t expected_size = offset;
+    for(uint32_t i = 0; i < header.n_fields; ++i)
+    {
+        uint32_t field_size;
+        std::memcpy(&field_size, data + sizeof(header) + i * sizeof(uint32_t), sizeof(uint32_t));
+        if(field_size != fields[i].second)
+        {
+            return false;
+        }
+        expected_size += field_size * sizeof(double_t);
+    }
+    if(size != expected_size)
+    {
+        return false;
+    }
+
+    // Discard deferred covariance propagation, as P is replaced.
+    discard_covariance();
+
+    // Read field data.
+    const uint8_t* field_data = data + offset;
+    for(auto field = fields.begin(); field != fields.end(); ++field)
+    {
+        if(field->second > 0)
+        {
+            std::memcpy(field->first, field_data, field->second * sizeof(double_t));
+            field_data += field->second * sizeof(double_t);
+        }
+    }
+
+    return true;
+}
+
+// LOGGING
+bool base_t::start_log(const std::string& log_file, uint8_t precision)
+{
+    return base_t::start_log(log_file, log_config_t(), precision);
+}
+bool base_t::start_log(const std::string& log_file, const log_config_t& config, uint8_t precision)
+{
+    // Stop any existing log.
+    base_t::stop_log();
+
+    // Verify the configuration.
+    for(auto state = config.states.begin(); state != config.states.end(); ++state)
+    {
+        if(*state >= base_t::n_x)
+        {
+            return false;
+        }
+    }
+    for(auto observer = config.observers.begin(); observer != config.observers.end(); ++observer)
+    {
+        if(*observer >= base_t::n_z)
+        {
+            return false;
+        }
+    }
+
+    // Select the logged columns.
+    // NOTE: Empty selections log all states or observers.
+    base_t::m_log_config = config;
+    base_t::m_log_config.decimation = std::max(config.decimation, 1U);
+    base_t::m_log_states = config.states;
+    if(base_t::m_log_states.empty())
+    {
+        for(uint32_t i = 0; i < base_t::n_x; ++i)
+        {
+            base_t::m_log_states.push_back(i);
+        }
+    }
+    base_t::m_log_observers = config.observers;
+    if(base_t::m_log_observers.empty())
+    {
+        for(uint32_t j = 0; j < base_t::n_z; ++j)
+        {
+            base_t::m_log_observers.push_back(j);
+        }
+    }
+    base_t::m_log_observer_columns.assign(base_t::n_z, -1);
+    for(uint32_t c = 0; c < base_t::m_log_observers.size(); ++c)
+    {
+        base_t::m_log_observer_columns[base_t::m_log_observers[c]] = c;
+    }
+
+    // Allocate staging storage.
+    uint32_t n_s = base_t::m_log_states.size();
+    uint32_t n_o = base_t::m_log_observers.size();
+    base_t::m_log_xp.setZero(n_s);
+    base_t::m_log_zp.setConstant(n_o, log_writer_t::missing());
+    base_t::m_log_za.setConstant(n_o, log_writer_t::missing());
+    bool gains = base_t::m_log_config.gains || base_t::m_log_config.gain_matrix;
+    bool matrices = base_t::m_log_config.covariance_matrix || base_t::m_log_config.innovation_covariance || base_t::m_log_config.gain_matrix;
+    base_t::m_log_gains.setConstant(gains ? n_s : 0, n_o, log_writer_t::missing());
+    base_t::m_log_S.setConstant(base_t::m_log_config.innovation_covariance ? n_o : 0, n_o, log_writer_t::missing());
+    bool covariance = base_t::m_log_config.covariance || base_t::m_log_config.covariance_matrix;
+    base_t::m_log_P.setZero(covariance ? base_t::n_x : 0, covariance ? base_t::n_x : 0);
+    base_t::m_log_updated = false;
+    base_t::m_log_count = 0;
+
+    // Name the columns.
+    std::vector<std::string> columns;
+    auto column = [&columns](const char* name, uint32_t index)
+    {
+        columns.push_back(name + std::to_string(index));
+    };
+    if(base_t::m_log_config.iteration)
+    {
+        // NOTE: The iteration column identifies each row, so readers can detect skipped iterations.
+        columns.push_back("iteration");
+    }
+    if(base_t::m_log_config.predicted_state)
+    {
+        for(uint32_t i = 0; i < n_s; ++i)
+        {
+            column("xp_", base_t::m_log_states[i]);
+        }
+    }
+    if(base_t::m_log_config.observations)
+    {
+        for(uint32_t j = 0; j < n_o; ++j)
+        {
+            column("zp_", base_t::m_log_observers[j]);
+        }
+        for(uint32_t j = 0; j < n_o; ++j)
+        {
+            column("za_", base_t::m_log_observers[j]);
+        }
+    }
+    if(base_t::m_log_config.estimated_state)
+    {
+        for(uint32_t i = 0; i < n_s; ++i)
+        {
+            column("xe_", base_t::m_log_states[i]);
+        }
+    }
+    if(base_t::m_log_config.covariance)
+    {
+        for(uint32_t i = 0; i < n_s; ++i)
+        {
+            column("Pd_", base_t::m_log_states[i]);
+        }
+    }
+    if(base_t::m_log_config.innovations)
+    {
+        for(uint32_t j = 0; j < n_o; ++j)
+        {
+            column("zd_", base_t::m_log_observers[j]);
+        }
+    }
+    if(base_t::m_log_config.gains)
+    {
+        for(uint32_t j = 0; j < n_o; ++j)
+        {
+            for(uint32_t i = 0; i < n_s; ++i)
+            {
+                column("K_", base_t::m_log_states[i]);
+                columns.back() += "_" + std::to_string(base_t::m_log_observers[j]);
+            }
+        }
+    }
+    // Open the log and write the header.
+    std::vector<bool> integer_columns(columns.size(), false);
+    if(base_t::m_log_config.iteration)
+    {
+        integer_columns.front() = true;
+    }
+    if(!base_t::m_log.open(log_file, columns, base_t::m_log_config, precision, integer_columns))
+    {
+        return false;
+    }
+
+    // Open the matrix log.
+    // NOTE: Matrices are always written in the compressed binary format.
+    if(matrices)
+    {
+        columns.clear();
+        if(base_t::m_log_config.covariance_matrix)
+        {
+            for(uint32_t c = 0; c < n_s; ++c)
+            {
+                for(uint32_t r = c; r < n_s; ++r)
+                {
+                    column("P_", base_t::m_log_states[r]);
+                    columns.back() += "_" + std::to_string(base_t::m_log_states[c]);
+                }
+            }
+        }
+        if(base_t::m_log_config.innovation_covariance)
+        {
+            for(uint32_t c = 0; c < n_o; ++c)
+            {
+                for(uint32_t r = c; r < n_o; ++r)
+                {
+                    column("S_", base_t::m_log_observers[r]);
+                    columns.back() += "_" + std::to_string(base_t::m_log_observers[c]);
+                }
+            }
+        }
+        if(base_t::m_log_config.gain_matrix)
+        {
+            for(uint32_t j = 0; j < n_o; ++j)
+            {
+                for(uint32_t i = 0; i < n_s; ++i)
+                {
+                    column("K_", base_t::m_log_states[i]);
+                    columns.back() += "_" + std::to_string(base_t::m_log_observers[j]);
+                }
+            }
+        }
+        std::string matrix_file = config.matrix_file;
+        if(matrix_file.empty())
+        {
+            size_t slash = log_file.find_last_of('/');
+            size_t dot = log_file.find_last_of('.');
+            if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            {
+                dot = log_file.size();
+            }
+            matrix_file = log_file.substr(0, dot) + ".bin";
+        }
+        log_config_t matrix_config = base_t::m_log_config;
+        matrix_config.compress = true;
+        if(!base_t::m_log_matrices.open(matrix_file, columns, matrix_config))
+        {
+            base_t::m_log.close();
+            return false;
+        }
+    }
+
+    return true;
+}
+void base_t::stop_log()
+{
+    // Flush and close the logs if running.
+    base_t::m_log.close();
+    base_t::m_log_matrices.close();
+}
+void base_t::log_predicted_state()
+{
+    if(base_t::m_log.is_open())
+    {
+        // Stage the predicted state.
+        for(uint32_t i = 0; i < base_t::m_log_states.size(); ++i)
+        {
+            base_t::m_log_xp(i) = base_t::x(base_t::m_log_states[i]);
+        }
+
+        // Reset the staged observations and gains of the previous iteration.
+        base_t::m_log_zp.fill(log_writer_t::missing());
+        base_t::m_log_za.fill(log_writer_t::missing());
+        base_t::m_log_gains.fill(log_writer_t::missing());
+        base_t::m_log_S.fill(log_writer_t::missing());
+        base_t::m_log_updated = false;
+    }
+}
+void base_t::log_observations(bool empty)
+{
+    if(base_t::m_log.is_open() && !empty)
+    {
+        // Stage predicted and actual observations.
+        for(uint32_t j = 0; j < base_t::m_log_observers.size(); ++j)
+        {
+            uint32_t observer = base_t::m_log_observers[j];
+            base_t::m_log_zp(j) = base_t::z(observer);
+            if(base_t::m_observation_source->contains(observer))
+            {
+                base_t::m_log_za(j) = base_t::m_observation_source->value(observer, base_t::R);
+            }
+        }
+        base_t::m_log_updated = true;
+    }
+}
+void base_t::log_update(const Eigen::Ref<const Eigen::MatrixXd>& Kt_m, const std::vector<uint32_t>& observers)
+{
+    for(uint32_t m = 0; m < observers.size(); ++m)
+    {
+        int32_t column = base_t::m_log_observer_columns[observers[m]];
+        if(column < 0)
+        {
+            continue;
+        }
+
+        // Stage the gains of the logged states for the observer.
+        if(base_t::m_log_gains.rows() > 0)
+        {
+            for(uint32_t i = 0; i < base_t::m_log_states.size(); ++i)
+            {
+                base_t::m_log_gains(i, column) = Kt_m(m, base_t::m_log_states[i]);
+            }
+        }
+
+        // Stage the innovation covariance between the observer and the other logged observers.
+        // NOTE: S_m is factorized in place, so S is read from the full matrix.
+        if(base_t::m_log_S.rows() > 0)
+        {
+            for(uint32_t n = 0; n < observers.size(); ++n)
+            {
+                int32_t row = base_t::m_log_observer_columns[observers[n]];
+                if(row >= 0)
+                {
+                    base_t::m_log_S(row, column) = base_t::S(observers[n], observers[m]);
+                }
+            }
+        }
+    }
+}
+void base_t::log_estimated_state()
+{
+    if(!base_t::m_log.is_open())
+    {
+        return;
+    }
+
+    // Check if the iteration is selected.
+    if(base_t::m_log_config.updates_only && !base_t::m_log_updated)
+    {
+        return;
+    }
+    if(base_t::m_log_count++ % base_t::m_log_config.decimation != 0)
+    {
+        return;
+    }
+
+    // Write the row.
+    // NOTE: Missing values are written as empty columns.
+    uint32_t n_s = base_t::m_log_states.size();
+    uint32_t n_o = base_t::m_log_observers.size();
+    if(base_t::m_log_config.covariance || base_t::m_log_config.covariance_matrix)
+    {
+        // Apply deferred covariance propagation to a copy, so lazy and deferred covariance stay deferred.
+        flushed_covariance(base_t::m_log_P);
+    }
+    if(base_t::m_log_config.iteration)
+    {
+        base_t::m_log.write(static_cast<double_t>(base_t::m_iterations));
+    }
+    if(base_t::m_log_config.predicted_state)
+    {
+        for(uint32_t i = 0; i < n_s; ++i)
+        {
+            base_t::m_log.write(base_t::m_log_xp(i));
+        }
+    }
+    if(base_t::m_log_config.observations)
+    {
+        for(uint32_t j = 0; j < n_o; ++j)
+        {
+            base_t::m_log.write(base_t::m_log_zp(j));
+        }
+        for(uint32_t j = 0; j < n_o; ++j)
+        {
+            base_t::m_log.write(base_t::m_log_za(j));
+        }
+    }
+    if(base_t::m_log_config.estimated_state)
+    {
+        for(uint32_t i = 0; i < n_s; ++i)
+        {
+            base_t::m_log.write(base_t::x(base_t::m_log_states[i]));
+        }
+    }
+    if(base_t::m_log_config.covariance)
+    {
+        for(uint32_t i = 0; i < n_s; ++i)
+        {
+            base_t::m_log.write(base_t::m_log_P(base_t::m_log_states[i], base_t::m_log_states[i]));
+        }
+    }
+    if(base_t::m_log_config.innovations)
+    {
+        // NOTE: Innovations of missing observations are missing.
+        for(uint32_t j = 0; j < n_o; ++j)
+        {
+            if(log_writer_t::is_missing(base_t::m_log_za(j)))
+            {
+                base_t::m_log.write(log_writer_t::missing());
+            }
+            else
+            {
+                base_t::m_log.write(base_t::m_log_za(j) - base_t::m_log_zp(j));
+            }
+        }
+    }
+    if(base_t::m_log_config.gains)
+    {
+        for(uint32_t j = 0; j < n_o; ++j)
+        {
+            for(uint32_t i = 0; i < n_s; ++i)
+            {
+                base_t::m_log.write(base_t::m_log_gains(i, j));
+            }
+        }
+    }
+    base_t::m_log.end_row();
+
+    // Write the matrix row.
+    if(base_t::m_log_matrices.is_open())
+    {
+        if(base_t::m_log_config.covariance_matrix)
+        {
+            for(uint32_t c = 0; c < n_s; ++c)
+            {
+                for(uint32_t r = c; r < n_s; ++r)
+                {
+                    base_t::m_log_matrices.write(base_t::m_log_P(base_t::m_log_states[r], base_t::m_log_states[c]));
+                }
+            }
+        }
+        if(base_t::m_log_config.innovation_covariance)
+        {
+            for(uint32_t c = 0; c < n_o; ++c)
+            {
+                for(uint32_t r = c; r < n_o; ++r)
+                {
+                    base_t::m_log_matrices.write(base_t::m_log_S(r, c));
+                }
+            }
+        }
+        if(base_t::m_log_config.gain_matrix)
+        {
+            for(uint32_t j = 0; j < n_o; ++j)
+            {
+                for(uint32_t i = 0; i < n_s; ++i)
+                {
+                    base_t::m_log_matrices.write(base_t::m_log_gains(i, j));
+                }
+            }
+        }
+        base_t::m_log_matrices.end_row();
+    }
+}
+void base_t::complete_iteration()
+{
+    // Update iteration count.
+    ++base_t::m_iterations;
+
+    // Publish state if running.
+    if(base_t::m_publisher)
+    {
+        // NOTE: Deferred covariance propagation is applied to a copy for consumers, so it stays deferred.
+        flushed_covariance(base_t::m_publish_P);
+        base_t::m_publisher->publish(base_t::x, base_t::m_publish_P, base_t::m_iterations);
+    }
+}
+void base_t::complete_failed_iteration(bool predicted)
+{
+    // Stage the unchanged state as the prediction if the prediction failed.
+    if(!predicted)
+    {
+        base_t::log_predicted_state();
+    }
+
+    // Log the unchanged state as the estimate, so the log has no gap.
+    base_t::log_estimated_state();
+
+    base_t::complete_iteration();
+}
+
+// PUBLISHING
+bool base_t::start_publishing(const std::string& segment_name)
+{
+    // Stop any existing publisher.
+    base_t::stop_publishing();
+
+    // Open the shared memory segment.
+    base_t::m_publisher.reset(new shm_publisher_t());
+    if(!base_t::m_publisher->open(segment_name, base_t::n_x))
+    {
+        base_t::m_publisher.reset();
+        return false;
+    }
+
+    // Allocate the published covariance.
+    base_t::m_publish_P.setZero(base_t::n_x, base_t::n_x);
+
+    return true;
+}
+void base_t::stop_publishing()
+{
+    // Closes the segment on destruction.
+    base_t::m_publisher.reset();
 }
\ No newline at end of file
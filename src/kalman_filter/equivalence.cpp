@@ -0,0 +1,148 @@
+#include <kalman_filter/equivalence.hpp>
+
+#include <cmath>
+#include <sstream>
+
+using namespace kalman_filter;
+
+// CONSTRUCTORS
+equivalence_t::equivalence_t(double_t absolute_tolerance, double_t relative_tolerance)
+{
+    equivalence_t::absolute_tolerance = absolute_tolerance;
+    equivalence_t::relative_tolerance = relative_tolerance;
+}
+
+// METHODS
+bool equivalence_t::compare(base_t& reference, base_t& candidate, const recording_t& recording, equivalence_report_t& report) const
+{
+    // Verify dimensions.
+    if(reference.n_variables() != candidate.n_variables() || reference.n_observers() != candidate.n_observers())
+    {
+        throw std::runtime_error("failed to compare filters (dimensions do not match)");
+    }
+    if(recording.n_observers() != reference.n_observers())
+    {
+        throw std::runtime_error("failed to compare filters (recording observers do not match filters)");
+    }
+
+    // Reset the report.
+    report.equivalent = true;
+    report.n_steps = 0;
+    report.step = 0;
+    report.phase = phase_t::PREDICT;
+    report.description.clear();
+    report.max_state_error = 0.0;
+    report.max_covariance_error = 0.0;
+
+    // Replay each step on both filters.
+    for(uint32_t step = 0; step < recording.n_steps(); ++step)
+    {
+        ++report.n_steps;
+        report.step = step;
+
+        // Prepare both filters for the step.
+        if(equivalence_t::step_function)
+        {
+            equivalence_t::step_function(reference, step);
+            equivalence_t::step_function(candidate, step);
+        }
+        reference.new_observations(recording.observers(step), recording.values(step), recording.n_observations(step));
+        candidate.new_observations(recording.observers(step), recording.values(step), recording.n_observations(step));
+
+        // Run and compare each phase.
+        for(uint32_t p = 0; p < 2; ++p)
+        {
+            report.phase = static_cast<phase_t>(p);
+
+            // Run the phase on both filters, capturing any errors.
+            // NOTE: Both filters must fail in the same phase to remain equivalent.
+            std::string errors[2];
+            base_t* filters[2] = {&reference, &candidate};
+            for(uint32_t f = 0; f < 2; ++f)
+            {
+                try
+                {
+                    if(report.phase == phase_t::PREDICT)
+                    {
+                        filters[f]->predict();
+                    }
+                    else
+                    {
+                        filters[f]->update();
+                    }
+                }
+                catch(const std::exception& exception)
+                {
+                    errors[f] = exception.what();
+                    if(errors[f].empty())
+                    {
+                        errors[f] = "unknown error";
+                    }
+                }
+            }
+            if(!errors[0].empty() || !errors[1].empty())
+            {
+                report.equivalent = false;
+                report.description = "reference: " + (errors[0].empty() ? std::string("ok") : errors[0]) + ", candidate: " + (errors[1].empty() ? std::string("ok") : errors[1]);
+                return false;
+            }
+
+            // Compare the trajectories.
+            if(!equivalence_t::compare_phase(reference, candidate, report))
+            {
+                report.equivalent = false;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+bool equivalence_t::compare_phase(const base_t& reference, const base_t& candidate, equivalence_report_t& report) const
+{
+    const Eigen::VectorXd& x_r = reference.state();
+    const Eigen::VectorXd& x_c = candidate.state();
+
+    // Copy the covariances without flushing deferred propagation.
+    // NOTE: Flushing would materialize P after every phase, so lazy filters would never defer across steps.
+    Eigen::MatrixXd P_r;
+    Eigen::MatrixXd P_c;
+    reference.covariance(P_r);
+    candidate.covariance(P_c);
+
+    // Track the largest differences.
+    report.max_state_error = std::max(report.max_state_error, (x_r - x_c).cwiseAbs().maxCoeff());
+    report.max_covariance_error = std::max(report.max_covariance_error, (P_r - P_c).cwiseAbs().maxCoeff());
+
+    // Find the first diverging element.
+    std::stringstream description;
+    description.precision(17);
+    for(uint32_t i = 0; i < x_r.size(); ++i)
+    {
+        if(!equivalence_t::match(x_r(i), x_c(i)))
+        {
+            description << "x(" << i << "): reference " << x_r(i) << ", candidate " << x_c(i);
+            report.description = description.str();
+            return false;
+        }
+    }
+    for(uint32_t j = 0; j < P_r.cols(); ++j)
+    {
+        for(uint32_t i = 0; i < P_r.rows(); ++i)
+        {
+            if(!equivalence_t::match(P_r(i,j), P_c(i,j)))
+            {
+                description << "P(" << i << "," << j << "): reference " << P_r(i,j) << ", candidate " << P_c(i,j);
+                report.description = description.str();
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+bool equivalence_t::match(double_t a, double_t b) const
+{
+    // NOTE: Written so that NaN never matches.
+    return std::abs(a - b) <= equivalence_t::absolute_tolerance + equivalence_t::relative_tolerance * std::max(std::abs(a), std::abs(b));
+}
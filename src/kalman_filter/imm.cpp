@@ -0,0 +1,346 @@
+#include <kalman_filter/imm.hpp>
+
+#include <cmath>
+
+using namespace kalman_filter;
+
+// CONSTRUCTORS
+imm_t::imm_t(const std::vector<base_t*>& modes)
+    : m_observations(modes.empty() ? 0 : modes.front()->n_z)
+{
+    // Verify that modes were provided.
+    if(modes.empty())
+    {
+        throw std::runtime_error("failed to create imm (no modes provided)");
+    }
+
+    // Store dimension sizes.
+    imm_t::n_m = modes.size();
+    imm_t::n_x = modes.front()->n_x;
+
+    // Verify that all modes have matching dimensions.
+    for(auto mode = modes.begin(); mode != modes.end(); ++mode)
+    {
+        if((*mode)->n_x != imm_t::n_x || (*mode)->n_z != modes.front()->n_z)
+        {
+            throw std::runtime_error("failed to create imm (mode dimensions do not match)");
+        }
+    }
+
+    // Store modes and attach them to the shared observation stream.
+    imm_t::m_modes = modes;
+    for(auto mode = imm_t::m_modes.begin(); mode != imm_t::m_modes.end(); ++mode)
+    {
+        (*mode)->m_observation_source = &(imm_t::m_observations);
+    }
+
+    // Set default parameters.
+    // NOTE: Modes are sticky by default, with uniform switching to all other modes.
+    if(imm_t::n_m > 1)
+    {
+        imm_t::M.setConstant(imm_t::n_m, imm_t::n_m, 0.05 / static_cast<double_t>(imm_t::n_m - 1));
+        imm_t::M.diagonal().setConstant(0.95);
+    }
+    else
+    {
+        imm_t::M.setOnes(1, 1);
+    }
+    imm_t::parallel = false;
+
+    // Allocate probability components.
+    imm_t::mu.setConstant(imm_t::n_m, 1.0 / static_cast<double_t>(imm_t::n_m));
+    imm_t::c.setZero(imm_t::n_m);
+    imm_t::W.setZero(imm_t::n_m, imm_t::n_m);
+    imm_t::l.setZero(imm_t::n_m);
+
+    // Allocate estimate components.
+    imm_t::x0.assign(imm_t::n_m, Eigen::VectorXd::Zero(imm_t::n_x));
+    imm_t::P0.assign(imm_t::n_m, Eigen::MatrixXd::Zero(imm_t::n_x, imm_t::n_x));
+    imm_t::x.setZero(imm_t::n_x);
+    imm_t::P.setZero(imm_t::n_x, imm_t::n_x);
+
+    // Allocate temporaries.
+    imm_t::t_x.setZero(imm_t::n_x);
+
+    // Calculate initial combined estimate.
+    imm_t::combine();
+}
+imm_t::~imm_t()
+{
+    // Detach modes from the shared observation stream.
+    for(auto mode = imm_t::m_modes.begin(); mode != imm_t::m_modes.end(); ++mode)
+    {
+        (*mode)->m_observation_source = &(*mode)->m_observations;
+    }
+}
+
+// FILTER METHODS
+void imm_t::iterate()
+{
+    // ---------- STEP 1: MIXING ----------
+
+    // Calculate predicted mode probabilities.
+    imm_t::c.noalias() = imm_t::M.transpose() * imm_t::mu;
+
+    // Calculate mixing probabilities.
+    // NOTE: A mode that no mode can transition into (c(j) = 0) is left unmixed instead of dividing by zero.
+    for(uint32_t j = 0; j < imm_t::n_m; ++j)
+    {
+        if(imm_t::c(j) > 0.0)
+        {
+            for(uint32_t i = 0; i < imm_t::n_m; ++i)
+            {
+                imm_t::W(i,j) = imm_t::M(i,j) * imm_t::mu(i) / imm_t::c(j);
+            }
+        }
+        else
+        {
+            imm_t::W.col(j).setZero();
+            imm_t::W(j,j) = 1.0;
+        }
+    }
+
+    // Apply any deferred covariance propagation in the modes.
+    for(uint32_t j = 0; j < imm_t::n_m; ++j)
+    {
+        imm_t::m_modes[j]->flush_covariance();
+    }
+
+    // Calculate mixed initial conditions for each mode.
+    // NOTE: All mixed estimates must be calculated before any mode is modified.
+    for(uint32_t j = 0; j < imm_t::n_m; ++j)
+    {
+        // Mix states.
+        imm_t::x0[j].setZero();
+        for(uint32_t i = 0; i < imm_t::n_m; ++i)
+        {
+            imm_t::x0[j].noalias() += imm_t::W(i,j) * imm_t::m_modes[i]->x;
+        }
+
+        // Mix covariances.
+        imm_t::P0[j].setZero();
+        for(uint32_t i = 0; i < imm_t::n_m; ++i)
+        {
+            imm_t::t_x = imm_t::m_modes[i]->x - imm_t::x0[j];
+            imm_t::P0[j].noalias() += imm_t::W(i,j) * imm_t::m_modes[i]->P;
+            imm_t::P0[j].noalias() += imm_t::W(i,j) * imm_t::t_x * imm_t::t_x.transpose();
+        }
+    }
+
+    // Move mixed initial conditions into each mode.
+    // NOTE: Swapping exchanges storage without copying; the old mode estimates are overwritten at the next mixing.
+    for(uint32_t j = 0; j < imm_t::n_m; ++j)
+    {
+        imm_t::x0[j].swap(imm_t::m_modes[j]->x);
+        imm_t::P0[j].swap(imm_t::m_modes[j]->P);
+    }
+
+    // ---------- STEP 2: MODE ITERATION ----------
+
+    // Check if observations are available for the mode probability update.
+    bool has_observations = !imm_t::m_observations.empty();
+
+    // Iterate each mode.
+    if(imm_t::parallel && imm_t::n_m > 1)
+    {
+        // Start one thread per mode on the first parallel iteration.
+        // NOTE: The scheduler's threads are reused, so iterations do not create threads.
+        if(!imm_t::m_scheduler)
+        {
+            imm_t::m_scheduler.reset(new scheduler_t(imm_t::n_m));
+        }
+        // Iterate all modes and wait for them to finish.
+        imm_t::m_scheduler->iterate(imm_t::m_modes);
+    }
+    else
+    {
+        for(uint32_t j = 0; j < imm_t::n_m; ++j)
+        {
+            imm_t::m_modes[j]->iterate();
+        }
+    }
+
+    // Reset shared observations.
+    imm_t::m_observations.clear();
+
+    // ---------- STEP 3: MODE PROBABILITY UPDATE ----------
+
+    if(has_observations)
+    {
+        // Capture log-likelihoods of each mode.
+        for(uint32_t j = 0; j < imm_t::n_m; ++j)
+        {
+            imm_t::l(j) = imm_t::m_modes[j]->m_log_likelihood;
+        }
+        // Update mode probabilities.
+        // NOTE: Likelihoods are normalized by the maximum to avoid underflow.
+        imm_t::l.array() -= imm_t::l.maxCoeff();
+        imm_t::mu = imm_t::c.cwiseProduct(imm_t::l.array().exp().matrix());
+        double_t mu_sum = imm_t::mu.sum();
+        if(mu_sum > 0.0)
+        {
+            imm_t::mu /= mu_sum;
+        }
+        else
+        {
+            // Keep the predicted probabilities if only modes with zero predicted probability explain the observations.
+            imm_t::mu = imm_t::c;
+        }
+    }
+    else
+    {
+        imm_t::mu = imm_t::c;
+    }
+
+    // ---------- STEP 4: COMBINATION ----------
+
+    imm_t::combine();
+}
+void imm_t::new_observation(uint32_t observer_index, double_t observation)
+{
+    // Verify index exists.
+    if(!(observer_index < imm_t::m_modes.front()->n_z))
+    {
+        throw std::runtime_error("failed to add new observation (observer_index out of range)");
+    }
+
+    // Store observation in the shared observation buffer.
+    imm_t::m_observations.insert(observer_index, observation);
+}
+void imm_t::new_observations(const uint32_t* observer_indices, const double_t* observations, uint32_t count)
+{
+    // Verify all indices exist before storing any observations.
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        if(!(observer_indices[i] < imm_t::m_modes.front()->n_z))
+        {
+            throw std::runtime_error("failed to add new observations (observer_index out of range)");
+        }
+    }
+
+    // Store observations in the shared observation buffer.
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        imm_t::m_observations.insert(observer_indices[i], observations[i]);
+    }
+}
+void imm_t::new_observations(uint32_t first_observer_index, const double_t* observations, uint32_t count)
+{
+    // Verify the range of indices exists.
+    uint32_t n_z = imm_t::m_modes.front()->n_z;
+    if(first_observer_index > n_z || count > n_z - first_observer_index)
+    {
+        throw std::runtime_error("failed to add new observations (observer_index out of range)");
+    }
+
+    // Store observations in the shared observation buffer.
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        imm_t::m_observations.insert(first_observer_index + i, observations[i]);
+    }
+}
+void imm_t::new_observation(uint32_t observer_index, double_t observation, double_t variance)
+{
+    // Verify index exists.
+    if(!(observer_index < imm_t::m_modes.front()->n_z))
+    {
+        throw std::runtime_error("failed to add new observation (observer_index out of range)");
+    }
+    // Verify the variance.
+    if(!observation_buffer_t::valid_variance(variance))
+    {
+        throw std::runtime_error("failed to add new observation (variance is not positive and finite)");
+    }
+
+    // Store observation and its noise in the shared observation buffer.
+    imm_t::m_observations.insert(observer_index, observation, variance);
+}
+void imm_t::new_observations(uint32_t first_observer_index, const Eigen::VectorXd& observations, const Eigen::MatrixXd& covariance)
+{
+    // Verify the range of indices exists.
+    uint32_t n_z = imm_t::m_modes.front()->n_z;
+    uint32_t count = observations.size();
+    if(first_observer_index > n_z || count > n_z - first_observer_index)
+    {
+        throw std::runtime_error("failed to add new observations (observer_index out of range)");
+    }
+    // Verify the covariance dimensions.
+    if(covariance.rows() != observations.size() || covariance.cols() != observations.size())
+    {
+        throw std::runtime_error("failed to add new observations (covariance dimension does not match observations)");
+    }
+    // Verify the covariance.
+    if(!observation_buffer_t::valid_covariance(covariance))
+    {
+        throw std::runtime_error("failed to add new observations (covariance is not finite and symmetric with a positive diagonal)");
+    }
+
+    // Store observations and their noise in the shared observation buffer.
+    imm_t::m_observations.insert(first_observer_index, observations, covariance);
+}
+void imm_t::set_observation_averaging(bool enabled)
+{
+    imm_t::m_observations.set_averaging(enabled);
+}
+void imm_t::combine()
+{
+    // Apply any deferred covariance propagation in the modes.
+    for(uint32_t j = 0; j < imm_t::n_m; ++j)
+    {
+        imm_t::m_modes[j]->flush_covariance();
+    }
+
+    // Combine states.
+    imm_t::x.setZero();
+    for(uint32_t j = 0; j < imm_t::n_m; ++j)
+    {
+        imm_t::x.noalias() += imm_t::mu(j) * imm_t::m_modes[j]->x;
+    }
+
+    // Combine covariances.
+    imm_t::P.setZero();
+    for(uint32_t j = 0; j < imm_t::n_m; ++j)
+    {
+        imm_t::t_x = imm_t::m_modes[j]->x - imm_t::x;
+        imm_t::P.noalias() += imm_t::mu(j) * imm_t::m_modes[j]->P;
+        imm_t::P.noalias() += imm_t::mu(j) * imm_t::t_x * imm_t::t_x.transpose();
+    }
+}
+
+// ACCESS
+uint32_t imm_t::n_modes() const
+{
+    return imm_t::n_m;
+}
+base_t& imm_t::mode(uint32_t index) const
+{
+    // Check if index is valid.
+    if(index >= imm_t::n_m)
+    {
+        throw std::runtime_error("invalid mode index");
+    }
+
+    return *imm_t::m_modes[index];
+}
+void imm_t::set_mode_probabilities(const Eigen::VectorXd& probabilities)
+{
+    if(probabilities.size() != static_cast<int>(imm_t::n_m))
+    {
+        throw std::runtime_error("Mode probability vector dimension does not match n_modes.");
+    }
+
+    imm_t::mu = probabilities;
+    imm_t::combine();
+}
+const Eigen::VectorXd& imm_t::mode_probabilities() const
+{
+    return imm_t::mu;
+}
+const Eigen::VectorXd& imm_t::state() const
+{
+    return imm_t::x;
+}
+const Eigen::MatrixXd& imm_t::covariance() const
+{
+    return imm_t::P;
+}
@@ -1,5 +1,9 @@
 #include <kalman_filter/kf.hpp>
 
+#include <eigen3/unsupported/Eigen/MatrixFunctions>
+
+#include <cmath>
+
 using namespace kalman_filter;
 
 // CONSTRUCTORS
@@ -21,13 +25,26 @@ kf_t::kf_t(uint32_t n_variables, uint32_t n_inputs, uint32_t n_observers)
     kf_t::t_x.setZero(kf_t::n_x);
     kf_t::t_xx.setZero(kf_t::n_x, kf_t::n_x);
     kf_t::t_zx.setZero(kf_t::n_z, kf_t::n_x);
+
+    // Disable lazy covariance by default.
+    // NOTE: Lazy covariance storage is allocated when enabled.
+    kf_t::m_lazy = false;
+    kf_t::m_deferred = 0;
+
+    // Initialize empty discretization cache.
+    kf_t::m_cache_count = 0;
+    kf_t::m_cache_next = 0;
 }
 
-// FILTER METHODS
-void kf_t::iterate()
+// CLONING
+std::unique_ptr<base_t> kf_t::clone() const
 {
-    // ---------- STEP 1: PREDICT ----------
+    return std::unique_ptr<base_t>(new kf_t(*this));
+}
 
+// FILTER METHODS
+void kf_t::predict()
+{
     // Predict state.
     kf_t::t_x.noalias() = kf_t::A * kf_t::x;
     kf_t::x.noalias() = kf_t::B * kf_t::u;
@@ -37,15 +54,41 @@ void kf_t::iterate()
     kf_t::log_predicted_state();
 
     // Predict covariance.
-    kf_t::t_xx.noalias() = kf_t::A * kf_t::P;
-    kf_t::P.noalias() = kf_t::t_xx * kf_t::A.transpose();
-    kf_t::P += kf_t::Q;
-
-    // ---------- STEP 2: UPDATE ----------
+    if(kf_t::m_lazy && !kf_t::has_observations())
+    {
+        // Restart deferral if the model changed since the deferred predictions began.
+        if(kf_t::m_deferred > 0 && (kf_t::A != kf_t::l_A || kf_t::Q != kf_t::l_Q))
+        {
+            kf_t::flush_covariance();
+        }
+        // Capture the model for a new deferral.
+        if(kf_t::m_deferred == 0)
+        {
+            kf_t::l_A = kf_t::A;
+            kf_t::l_Q = kf_t::Q;
+        }
+        // Defer the covariance prediction.
+        ++kf_t::m_deferred;
+    }
+    else
+    {
+        // Apply any deferred predictions before this prediction.
+        kf_t::flush_covariance();
 
+        kf_t::t_xx.noalias() = kf_t::A * kf_t::P;
+        kf_t::P.noalias() = kf_t::t_xx * kf_t::A.transpose();
+        kf_t::P += kf_t::Q;
+    }
+}
+void kf_t::update()
+{
     // Check if update is necessary.
     if(kf_t::has_observations())
     {
+        // Apply any deferred predictions.
+        // NOTE: Observations may have been added after the prediction was deferred.
+        kf_t::flush_covariance();
+
         // Calculate predicted observation.
         kf_t::z.noalias() = kf_t::H * kf_t::x;
 
@@ -55,13 +98,16 @@ void kf_t::iterate()
         // Calculate predicted observation covariance.
         kf_t::t_zx.noalias() = kf_t::H * kf_t::P;
         kf_t::S.noalias() = kf_t::t_zx * kf_t::H.transpose();
-        kf_t::S += kf_t::R;
+        kf_t::add_observation_noise(kf_t::S);
 
         // Calculate predicted state/observation cross covariance.
         kf_t::C.noalias() = kf_t::P * kf_t::H.transpose();
 
         // Perform masked kalman update.
-        kf_t::masked_kalman_update();
+        if(!kf_t::masked_kalman_update())
+        {
+            return;
+        }
     }
     else
     {
@@ -71,6 +117,49 @@ void kf_t::iterate()
 
     // Log estimated state.
     kf_t::log_estimated_state();
+
+    // Complete iteration.
+    kf_t::complete_iteration();
+}
+void kf_t::predicted_observation(Eigen::VectorXd& z, Eigen::MatrixXd& S) const
+{
+    // Calculate predicted observation.
+    z.noalias() = kf_t::H * kf_t::x;
+
+    // Calculate predicted observation covariance.
+    // NOTE: Deferred covariance predictions are applied to a copy of P, so the filter is not changed.
+    const Eigen::MatrixXd& P = kf_t::current_covariance(kf_t::q_P);
+    kf_t::q_zx.noalias() = kf_t::H * P;
+    S.noalias() = kf_t::q_zx * kf_t::H.transpose();
+    S += kf_t::R;
+}
+void kf_t::forecast(uint32_t horizon, std::vector<Eigen::VectorXd>& states, std::vector<Eigen::MatrixXd>& covariances) const
+{
+    // Size outputs.
+    // NOTE: Existing output storage is reused.
+    states.resize(horizon);
+    covariances.resize(horizon);
+
+    // Calculate the constant input contribution.
+    kf_t::q_x.noalias() = kf_t::B * kf_t::u;
+
+    // Get the current covariance.
+    // NOTE: Deferred covariance predictions are applied to a copy of P, so the filter is not changed.
+    const Eigen::MatrixXd& P = kf_t::current_covariance(kf_t::q_P);
+
+    // Predict each step from the previous step.
+    for(uint32_t k = 0; k < horizon; ++k)
+    {
+        const Eigen::VectorXd& x_k = (k == 0) ? kf_t::x : states[k-1];
+        const Eigen::MatrixXd& P_k = (k == 0) ? P : covariances[k-1];
+
+        states[k] = kf_t::q_x;
+        states[k].noalias() += kf_t::A * x_k;
+
+        kf_t::q_xx.noalias() = kf_t::A * P_k;
+        covariances[k].noalias() = kf_t::q_xx * kf_t::A.transpose();
+        covariances[k] += kf_t::Q;
+    }
 }
 void kf_t::new_input(uint32_t input_index, double_t input)
 {
@@ -83,9 +172,256 @@ void kf_t::new_input(uint32_t input_index, double_t input)
     // Store input.
     kf_t::u(input_index) = input;
 }
+status_t kf_t::try_new_input(uint32_t input_index, double_t input) noexcept
+{
+    if(KALMAN_FILTER_CHECK_BOUNDS && !(input_index < kf_t::n_u))
+    {
+        return status_t::INVALID_INDEX;
+    }
+
+    kf_t::u(input_index) = input;
+    return status_t::OK;
+}
+
+void kf_t::set_lazy_covariance(bool enabled)
+{
+    // Apply any deferred predictions.
+    kf_t::flush_covariance();
+
+    // Allocate lazy covariance storage on first use.
+    if(enabled && kf_t::l_A.size() == 0)
+    {
+        kf_t::l_A.setZero(kf_t::n_x, kf_t::n_x);
+        kf_t::l_Q.setZero(kf_t::n_x, kf_t::n_x);
+        kf_t::l_Phi.setZero(kf_t::n_x, kf_t::n_x);
+        kf_t::l_Qk.setZero(kf_t::n_x, kf_t::n_x);
+        kf_t::l_Phi_s.setZero(kf_t::n_x, kf_t::n_x);
+        kf_t::l_Q_s.setZero(kf_t::n_x, kf_t::n_x);
+    }
+
+    kf_t::m_lazy = enabled;
+}
+
+// CONTINUOUS MODEL
+void kf_t::set_continuous_model(const Eigen::MatrixXd& F, const Eigen::MatrixXd& G, const Eigen::MatrixXd& Qc, uint32_t cache_size)
+{
+    // Verify model dimensions.
+    if(F.rows() != kf_t::n_x || F.cols() != kf_t::n_x)
+    {
+        throw std::runtime_error("failed to set continuous model (F dimension does not match n_variables)");
+    }
+    if(G.rows() != kf_t::n_x || G.cols() != kf_t::n_u)
+    {
+        throw std::runtime_error("failed to set continuous model (G dimension does not match n_variables/n_inputs)");
+    }
+    if(Qc.rows() != kf_t::n_x || Qc.cols() != kf_t::n_x)
+    {
+        throw std::runtime_error("failed to set continuous model (Qc dimension does not match n_variables)");
+    }
+    if(cache_size == 0)
+    {
+        throw std::runtime_error("failed to set continuous model (cache_size must be at least 1)");
+    }
+
+    // Store model.
+    kf_t::c_F = F;
+    kf_t::c_G = G;
+    kf_t::c_Qc = Qc;
+
+    // Allocate exponential storage.
+    kf_t::c_M.setZero(2*kf_t::n_x, 2*kf_t::n_x);
+    kf_t::c_E.setZero(2*kf_t::n_x, 2*kf_t::n_x);
+    // NOTE: The bottom rows of the input block matrix remain zero.
+    kf_t::c_Mu.setZero(kf_t::n_x + kf_t::n_u, kf_t::n_x + kf_t::n_u);
+    kf_t::c_Eu.setZero(kf_t::n_x + kf_t::n_u, kf_t::n_x + kf_t::n_u);
+
+    // Allocate and reset cache.
+    kf_t::m_cache.resize(cache_size);
+    for(auto entry = kf_t::m_cache.begin(); entry != kf_t::m_cache.end(); ++entry)
+    {
+        entry->dt = 0.0;
+        entry->A.setZero(kf_t::n_x, kf_t::n_x);
+        entry->B.setZero(kf_t::n_x, kf_t::n_u);
+        entry->Q.setZero(kf_t::n_x, kf_t::n_x);
+    }
+    kf_t::m_cache_count = 0;
+    kf_t::m_cache_next = 0;
+}
+void kf_t::discretize(double_t dt)
+{
+    // Verify a continuous model exists.
+    if(kf_t::m_cache.empty())
+    {
+        throw std::runtime_error("failed to discretize (no continuous model set)");
+    }
+
+    // Search the cache for the interval.
+    for(uint32_t i = 0; i < kf_t::m_cache_count; ++i)
+    {
+        const discretization_t& entry = kf_t::m_cache[i];
+        if(std::abs(entry.dt - dt) <= 1e-9 * std::abs(dt))
+        {
+            kf_t::A = entry.A;
+            kf_t::B = entry.B;
+            kf_t::Q = entry.Q;
+            return;
+        }
+    }
+
+    // Replace the oldest cache entry.
+    discretization_t& entry = kf_t::m_cache[kf_t::m_cache_next];
+    kf_t::m_cache_next = (kf_t::m_cache_next + 1) % kf_t::m_cache.size();
+    if(kf_t::m_cache_count < kf_t::m_cache.size())
+    {
+        ++kf_t::m_cache_count;
+    }
+    entry.dt = dt;
+
+    // Calculate A and Q with Van Loan's method:
+    // exp([-F Qc; 0 F']*dt) = [. A^-1*Q; 0 A'].
+    kf_t::c_M.topLeftCorner(kf_t::n_x, kf_t::n_x) = -kf_t::c_F * dt;
+    kf_t::c_M.topRightCorner(kf_t::n_x, kf_t::n_x) = kf_t::c_Qc * dt;
+    kf_t::c_M.bottomLeftCorner(kf_t::n_x, kf_t::n_x).setZero();
+    kf_t::c_M.bottomRightCorner(kf_t::n_x, kf_t::n_x) = kf_t::c_F.transpose() * dt;
+    kf_t::c_E = kf_t::c_M.exp();
+    entry.A = kf_t::c_E.bottomRightCorner(kf_t::n_x, kf_t::n_x).transpose();
+    entry.Q.noalias() = entry.A * kf_t::c_E.topRightCorner(kf_t::n_x, kf_t::n_x);
+    // Remove asymmetry from roundoff.
+    kf_t::t_xx = entry.Q.transpose();
+    entry.Q += kf_t::t_xx;
+    entry.Q *= 0.5;
+
+    // Calculate B with the zero order hold integral:
+    // exp([F G; 0 0]*dt) = [A B; 0 I].
+    if(kf_t::n_u > 0)
+    {
+        kf_t::c_Mu.topLeftCorner(kf_t::n_x, kf_t::n_x) = kf_t::c_F * dt;
+        kf_t::c_Mu.topRightCorner(kf_t::n_x, kf_t::n_u) = kf_t::c_G * dt;
+        kf_t::c_Eu = kf_t::c_Mu.exp();
+        entry.B = kf_t::c_Eu.topRightCorner(kf_t::n_x, kf_t::n_u);
+    }
+
+    // Apply the discretization.
+    kf_t::A = entry.A;
+    kf_t::B = entry.B;
+    kf_t::Q = entry.Q;
+}
+
+// LAZY COVARIANCE
+void kf_t::flush_covariance()
+{
+    // Apply any deferred covariance update first, as it precedes the deferred predictions.
+    base_t::flush_covariance();
+
+    // Check if any predictions were deferred.
+    if(kf_t::m_deferred == 0)
+    {
+        return;
+    }
+
+    // Compose the deferred predictions.
+    kf_t::compose_predictions(kf_t::l_Phi, kf_t::l_Qk, kf_t::l_Phi_s, kf_t::l_Q_s, kf_t::t_xx);
+
+    // Apply the composed prediction to the covariance.
+    kf_t::t_xx.noalias() = kf_t::l_Phi * kf_t::P;
+    kf_t::P.noalias() = kf_t::t_xx * kf_t::l_Phi.transpose();
+    kf_t::P += kf_t::l_Qk;
+
+    // Reset deferral.
+    kf_t::m_deferred = 0;
+}
+void kf_t::flushed_covariance(Eigen::MatrixXd& P_out) const
+{
+    // Apply any deferred covariance update first, as it precedes the deferred predictions.
+    base_t::flushed_covariance(P_out);
+
+    // Check if any predictions were deferred.
+    if(kf_t::m_deferred == 0)
+    {
+        return;
+    }
+
+    // Apply the composed predictions to the copy.
+    Eigen::MatrixXd Phi, Qk, Phi_s, Q_s, t;
+    kf_t::compose_predictions(Phi, Qk, Phi_s, Q_s, t);
+    t.noalias() = Phi * P_out;
+    P_out.noalias() = t * Phi.transpose();
+    P_out += Qk;
+}
+bool kf_t::covariance_deferred() const
+{
+    return base_t::covariance_deferred() || kf_t::m_deferred != 0;
+}
+void kf_t::compose_predictions(Eigen::MatrixXd& Phi, Eigen::MatrixXd& Qk, Eigen::MatrixXd& Phi_s, Eigen::MatrixXd& Q_s, Eigen::MatrixXd& t) const
+{
+    // Compose k deferred predictions into a single transition and process covariance:
+    // Phi = A^k and Qk = sum(A^i*Q*A^i') for i = 0..k-1.
+    // This is done by repeated squaring, where two segments (Phi1,Q1) and (Phi2,Q2) combine into
+    // (Phi2*Phi1, Phi2*Q1*Phi2' + Q2). Segments of the same model commute, so order does not matter.
+    Phi.setIdentity(kf_t::n_x, kf_t::n_x);
+    Qk.setZero(kf_t::n_x, kf_t::n_x);
+    Phi_s = kf_t::l_A;
+    Q_s = kf_t::l_Q;
+    for(uint32_t k = kf_t::m_deferred; k > 0; k >>= 1)
+    {
+        if(k & 1)
+        {
+            // Append the squared segment to the accumulated segment.
+            t.noalias() = Phi_s * Qk;
+            Qk.noalias() = t * Phi_s.transpose();
+            Qk += Q_s;
+            t.noalias() = Phi_s * Phi;
+            Phi = t;
+        }
+        if(k > 1)
+        {
+            // Square the segment.
+            t.noalias() = Phi_s * Q_s;
+            Q_s.noalias() += t * Phi_s.transpose();
+            t.noalias() = Phi_s * Phi_s;
+            Phi_s = t;
+        }
+    }
+}
+void kf_t::discard_covariance()
+{
+    base_t::discard_covariance();
+
+    // Drop the deferred predictions.
+    // NOTE: l_Phi and l_Qk are recomputed from l_A and l_Q by each flush, so only the count is reset.
+    kf_t::m_deferred = 0;
+}
 
 // ACCESS
 uint32_t kf_t::n_inputs() const
 {
     return kf_t::n_u;
+}
+
+// CHECKPOINTING
+filter_type_t kf_t::filter_type() const
+{
+    return filter_type_t::KF;
+}
+void kf_t::checkpoint_fields(std::vector<std::pair<double_t*, uint32_t>>& fields)
+{
+    // Add base fields.
+    base_t::checkpoint_fields(fields);
+
+    // Add model fields.
+    fields.emplace_back(kf_t::A.data(), kf_t::A.size());
+    fields.emplace_back(kf_t::B.data(), kf_t::B.size());
+    fields.emplace_back(kf_t::H.data(), kf_t::H.size());
+    fields.emplace_back(kf_t::u.data(), kf_t::u.size());
+}
+void kf_t::checkpoint_fields(std::vector<std::pair<const double_t*, uint32_t>>& fields) const
+{
+    // Add base fields.
+    base_t::checkpoint_fields(fields);
+
+    // Add model fields.
+    fields.emplace_back(kf_t::A.data(), kf_t::A.size());
+    fields.emplace_back(kf_t::B.data(), kf_t::B.size());
+    fields.emplace_back(kf_t::H.data(), kf_t::H.size());
+    fields.emplace_back(kf_t::u.data(), kf_t::u.size());
 }
\ No newline at end of file
@@ -0,0 +1,799 @@
+#include <kalman_filter/log.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+// NOTE: Floating point std::to_chars requires C++17 library support. A locale independent formatter is used otherwise.
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+using namespace kalman_filter;
+
+// FORMATTING
+/// \brief The maximum length of a number in fixed notation: sign, 309 integer digits, point, and 255 decimals.
+const uint32_t log_number_size = 576;
+/// \brief The bit pattern of missing values: a quiet NaN with a payload that arithmetic does not produce.
+const uint64_t log_missing_bits = 0x7FF84D495353494EULL;
+/// \brief Writes an unsigned integer in decimal.
+/// \param first The first character to write.
+/// \param value The integer to write.
+/// \param digits The minimum number of digits, padded with leading zeros.
+/// \returns A pointer past the last character written.
+char* log_write_integer(char* first, uint64_t value, uint32_t digits = 1)
+{
+    // Write digits in reverse, then copy them out in order.
+    char reversed[20];
+    uint32_t n = 0;
+    do
+    {
+        reversed[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while(value != 0);
+    for(; n < digits; ++n)
+    {
+        reversed[n] = '0';
+    }
+    while(n > 0)
+    {
+        *first++ = reversed[--n];
+    }
+    return first;
+}
+/// \brief Writes a number in fixed notation.
+/// \param first The first character to write.
+/// \param last The end of the available space.
+/// \param value The number to write.
+/// \param precision The number of digits after the decimal point.
+/// \returns A pointer past the last character written.
+char* log_write_fixed(char* first, char* last, double_t value, uint8_t precision)
+{
+#if defined(__cpp_lib_to_chars)
+    return std::to_chars(first, last, value, std::chars_format::fixed, precision).ptr;
+#else
+    // Write non-finite values.
+    if(!std::isfinite(value))
+    {
+        const char* text = std::isnan(value) ? (std::signbit(value) ? "-nan" : "nan") : (value < 0.0 ? "-inf" : "inf");
+        uint32_t length = std::strlen(text);
+        std::memcpy(first, text, length);
+        return first + length;
+    }
+
+    // Use integer arithmetic when the scaled value is small and not close to a rounding tie.
+    // NOTE: Below 2^40 the scaled value is within 2^-13 of exact, so rounding away from ties matches printf.
+    static const double_t powers[16] = {1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9, 1E10, 1E11, 1E12, 1E13, 1E14, 1E15};
+    double_t magnitude = std::abs(value);
+    double_t scaled = (precision < 16) ? magnitude * powers[precision] : 0.0;
+    if(precision < 16 && scaled < 1099511627776.0 && std::abs(scaled - std::floor(scaled) - 0.5) > 1E-3)
+    {
+        uint64_t rounded = static_cast<uint64_t>(std::floor(scaled + 0.5));
+        uint64_t scale = static_cast<uint64_t>(powers[precision]);
+        if(std::signbit(value))
+        {
+            *first++ = '-';
+        }
+        first = log_write_integer(first, rounded / scale);
+        if(precision > 0)
+        {
+            *first++ = '.';
+            first = log_write_integer(first, rounded % scale, precision);
+        }
+        return first;
+    }
+
+    // Fall back to printf for large values, large precisions, and near ties.
+    int length = std::snprintf(first, last - first, "%.*f", static_cast<int>(precision), value);
+    return first + std::max(length, 0);
+#endif
+}
+
+// COMPRESSED FORMAT
+/// \brief The magic number identifying compressed logs ("KFLZ").
+const uint32_t log_magic = 0x5A4C464B;
+/// \brief The current compressed log format version.
+const uint32_t log_version = 1;
+/// \brief Appends bits to a byte buffer, most significant bit first.
+class log_bit_writer_t
+{
+public:
+    /// \brief Instantiates a new log_bit_writer_t object.
+    /// \param output The buffer to append to.
+    log_bit_writer_t(std::vector<char>& output)
+        : m_output(output),
+          m_bits(0),
+          m_count(0)
+    {}
+    /// \brief Appends bits.
+    /// \param bits The bits to append, in the least significant positions.
+    /// \param count The number of bits to append (at most 64).
+    void write(uint64_t bits, uint32_t count)
+    {
+        while(count > 0)
+        {
+            // Fill the pending byte.
+            uint32_t take = std::min(count, 8 - m_count);
+            uint64_t part = (bits >> (count - take)) & ((1ULL << take) - 1);
+            m_bits = static_cast<uint8_t>((m_bits << take) | part);
+            m_count += take;
+            count -= take;
+
+            // Append complete bytes.
+            if(m_count == 8)
+            {
+                m_output.push_back(static_cast<char>(m_bits));
+                m_bits = 0;
+                m_count = 0;
+            }
+        }
+    }
+    /// \brief Appends any pending bits, padded with zeros to a whole byte.
+    void finish()
+    {
+        if(m_count > 0)
+        {
+            m_output.push_back(static_cast<char>(m_bits << (8 - m_count)));
+            m_bits = 0;
+            m_count = 0;
+        }
+    }
+
+private:
+    /// \brief The buffer to append to.
+    std::vector<char>& m_output;
+    /// \brief The pending bits.
+    uint8_t m_bits;
+    /// \brief The number of pending bits.
+    uint32_t m_count;
+};
+/// \brief Appends a value to a byte buffer in native byte order.
+/// \param output The buffer to append to.
+/// \param value The value to append.
+void log_append(std::vector<char>& output, uint32_t value)
+{
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    output.insert(output.end(), bytes, bytes + sizeof(value));
+}
+
+// CONFIGURATION
+log_config_t::log_config_t()
+{
+    log_config_t::iteration = false;
+    log_config_t::predicted_state = true;
+    log_config_t::observations = true;
+    log_config_t::estimated_state = true;
+    log_config_t::covariance = false;
+    log_config_t::innovations = false;
+    log_config_t::gains = false;
+    log_config_t::covariance_matrix = false;
+    log_config_t::innovation_covariance = false;
+    log_config_t::gain_matrix = false;
+    log_config_t::decimation = 1;
+    log_config_t::updates_only = false;
+    log_config_t::compress = false;
+    log_config_t::background = false;
+    log_config_t::rotate_size = 0;
+    log_config_t::rotate_interval = 0.0;
+    log_config_t::rotate_files = 0;
+    log_config_t::buffer_size = 65536;
+}
+
+// WRITER: CONSTRUCTORS
+log_writer_t::log_writer_t()
+{
+    log_writer_t::m_precision = 6;
+    log_writer_t::n_c = 0;
+    log_writer_t::n_r = 0;
+    log_writer_t::m_open = false;
+    log_writer_t::m_current = nullptr;
+    log_writer_t::m_column = 0;
+    log_writer_t::m_stop = false;
+    log_writer_t::m_segment = 0;
+    log_writer_t::m_segment_size = 0;
+}
+log_writer_t::~log_writer_t()
+{
+    log_writer_t::close();
+}
+
+// WRITER: METHODS
+bool log_writer_t::open(const std::string& file, const std::vector<std::string>& columns, const log_config_t& config, uint8_t precision, const std::vector<bool>& integer_columns)
+{
+    // Close any open log.
+    log_writer_t::close();
+
+    // Store the configuration.
+    log_writer_t::m_file_name = file;
+    log_writer_t::m_config = config;
+    log_writer_t::m_precision = precision;
+    log_writer_t::n_c = std::max(static_cast<uint32_t>(columns.size()), 1U);
+    log_writer_t::m_integer_columns = integer_columns;
+    log_writer_t::m_integer_columns.resize(log_writer_t::n_c, false);
+    log_writer_t::m_header.clear();
+    for(uint32_t c = 0; c < columns.size(); ++c)
+    {
+        if(c > 0)
+        {
+            log_writer_t::m_header += ",";
+        }
+        log_writer_t::m_header += columns[c];
+    }
+
+    // Open the first file.
+    log_writer_t::m_segment = 0;
+    if(!log_writer_t::open_segment())
+    {
+        return false;
+    }
+
+    // Allocate the row buffers.
+    // NOTE: The background writer uses several buffers so that the filter can fill one while others are written.
+    log_writer_t::n_r = std::max(config.buffer_size / static_cast<uint32_t>(log_writer_t::n_c * sizeof(double_t)), 1U);
+    log_writer_t::m_chunks.resize(config.background ? 4 : 1);
+    for(auto chunk = log_writer_t::m_chunks.begin(); chunk != log_writer_t::m_chunks.end(); ++chunk)
+    {
+        chunk->values.assign(log_writer_t::n_r * log_writer_t::n_c, log_writer_t::missing());
+        chunk->n_rows = 0;
+    }
+    log_writer_t::m_current = &(log_writer_t::m_chunks.front());
+    log_writer_t::m_column = 0;
+    log_writer_t::m_full.clear();
+    log_writer_t::m_free.clear();
+    for(uint32_t i = 1; i < log_writer_t::m_chunks.size(); ++i)
+    {
+        log_writer_t::m_free.push_back(&(log_writer_t::m_chunks[i]));
+    }
+
+    // Start the background writer.
+    if(config.background)
+    {
+        log_writer_t::m_stop = false;
+        log_writer_t::m_thread = std::thread(&log_writer_t::run, this);
+    }
+
+    log_writer_t::m_open = true;
+    return true;
+}
+void log_writer_t::close()
+{
+    // Check if a log is open.
+    if(!log_writer_t::m_open)
+    {
+        return;
+    }
+
+    // Write any buffered rows.
+    log_writer_t::flush();
+
+    // Stop the background writer.
+    if(log_writer_t::m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(log_writer_t::m_mutex);
+            log_writer_t::m_stop = true;
+        }
+        log_writer_t::m_queued.notify_one();
+        log_writer_t::m_thread.join();
+    }
+
+    // Close the stream and reset flags.
+    log_writer_t::m_file.close();
+    log_writer_t::m_file.clear();
+    log_writer_t::m_chunks.clear();
+    log_writer_t::m_current = nullptr;
+    log_writer_t::m_open = false;
+}
+bool log_writer_t::is_open() const
+{
+    return log_writer_t::m_open;
+}
+void log_writer_t::flush()
+{
+    if(!log_writer_t::m_open || log_writer_t::m_current->n_rows == 0)
+    {
+        return;
+    }
+
+    // Write the complete rows of the current buffer.
+    // NOTE: Any partial row is moved to the start of the next buffer.
+    std::vector<double_t> partial(log_writer_t::m_current->values.begin() + log_writer_t::m_current->n_rows * log_writer_t::n_c, log_writer_t::m_current->values.begin() + log_writer_t::m_current->n_rows * log_writer_t::n_c + log_writer_t::m_column);
+    log_writer_t::submit();
+    std::copy(partial.begin(), partial.end(), log_writer_t::m_current->values.begin());
+
+    // Wait for the background writer to write all buffers.
+    if(log_writer_t::m_thread.joinable())
+    {
+        std::unique_lock<std::mutex> lock(log_writer_t::m_mutex);
+        log_writer_t::m_written.wait(lock, [this]{return log_writer_t::m_free.size() + 1 == log_writer_t::m_chunks.size();});
+    }
+}
+
+// WRITER: ROWS
+void log_writer_t::write(double_t value)
+{
+    if(log_writer_t::m_open && log_writer_t::m_column < log_writer_t::n_c)
+    {
+        log_writer_t::m_current->values[log_writer_t::m_current->n_rows * log_writer_t::n_c + log_writer_t::m_column++] = value;
+    }
+}
+void log_writer_t::end_row()
+{
+    if(!log_writer_t::m_open)
+    {
+        return;
+    }
+
+    // Fill missing columns.
+    double_t* row = log_writer_t::m_current->values.data() + log_writer_t::m_current->n_rows * log_writer_t::n_c;
+    std::fill(row + log_writer_t::m_column, row + log_writer_t::n_c, log_writer_t::missing());
+    log_writer_t::m_column = 0;
+
+    // Write the buffer once it is full.
+    if(++log_writer_t::m_current->n_rows == log_writer_t::n_r)
+    {
+        log_writer_t::submit();
+    }
+}
+
+// WRITER: OUTPUT
+double_t log_writer_t::missing()
+{
+    double_t value;
+    std::memcpy(&value, &log_missing_bits, sizeof(value));
+    return value;
+}
+bool log_writer_t::is_missing(double_t value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits == log_missing_bits;
+}
+void log_writer_t::submit()
+{
+    if(!log_writer_t::m_thread.joinable())
+    {
+        // Write the buffer on the calling thread.
+        log_writer_t::write_chunk(*log_writer_t::m_current);
+        log_writer_t::m_current->n_rows = 0;
+        return;
+    }
+
+    // Queue the buffer and take a free buffer, waiting if the background writer has fallen behind.
+    std::unique_lock<std::mutex> lock(log_writer_t::m_mutex);
+    log_writer_t::m_full.push_back(log_writer_t::m_current);
+    log_writer_t::m_queued.notify_one();
+    log_writer_t::m_written.wait(lock, [this]{return !log_writer_t::m_free.empty();});
+    log_writer_t::m_current = log_writer_t::m_free.front();
+    log_writer_t::m_free.pop_front();
+}
+void log_writer_t::run()
+{
+    std::unique_lock<std::mutex> lock(log_writer_t::m_mutex);
+    while(true)
+    {
+        // Wait for a full buffer.
+        log_writer_t::m_queued.wait(lock, [this]{return !log_writer_t::m_full.empty() || log_writer_t::m_stop;});
+        if(log_writer_t::m_full.empty())
+        {
+            break;
+        }
+        chunk_t* chunk = log_writer_t::m_full.front();
+        log_writer_t::m_full.pop_front();
+
+        // Write the buffer without holding the lock.
+        lock.unlock();
+        log_writer_t::write_chunk(*chunk);
+        chunk->n_rows = 0;
+        lock.lock();
+
+        // Return the buffer.
+        log_writer_t::m_free.push_back(chunk);
+        log_writer_t::m_written.notify_all();
+    }
+}
+void log_writer_t::write_chunk(chunk_t& chunk)
+{
+    // Start a new file if the current file is due for rotation.
+    // NOTE: Files are only rotated between buffers, so they may exceed rotate_size by up to one buffer.
+    bool full = log_writer_t::m_config.rotate_size > 0 && log_writer_t::m_segment_size >= log_writer_t::m_config.rotate_size;
+    bool old = log_writer_t::m_config.rotate_interval > 0.0 && std::chrono::duration<double_t>(std::chrono::steady_clock::now() - log_writer_t::m_segment_start).count() >= log_writer_t::m_config.rotate_interval;
+    if(full || old)
+    {
+        ++log_writer_t::m_segment;
+        log_writer_t::open_segment();
+    }
+
+    // Format or compress the rows.
+    if(log_writer_t::m_config.compress)
+    {
+        log_writer_t::compress(chunk);
+    }
+    else
+    {
+        log_writer_t::format(chunk);
+    }
+
+    // Write the output in one chunk.
+    // NOTE: Rows are dropped if the file could not be opened.
+    if(log_writer_t::m_file.is_open())
+    {
+        log_writer_t::m_file.write(log_writer_t::m_output.data(), log_writer_t::m_output.size());
+        log_writer_t::m_segment_size += log_writer_t::m_output.size();
+    }
+}
+void log_writer_t::format(const chunk_t& chunk)
+{
+    // Size the output for the longest possible rows.
+    uint32_t row_size = log_writer_t::n_c * (log_number_size + 1);
+    if(log_writer_t::m_output.size() < chunk.n_rows * row_size)
+    {
+        log_writer_t::m_output.resize(chunk.n_rows * row_size);
+    }
+
+    // Format each row.
+    char* first = log_writer_t::m_output.data();
+    const double_t* value = chunk.values.data();
+    for(uint32_t r = 0; r < chunk.n_rows; ++r)
+    {
+        for(uint32_t c = 0; c < log_writer_t::n_c; ++c, ++value)
+        {
+            if(c > 0)
+            {
+                *first++ = ',';
+            }
+            if(log_writer_t::is_missing(*value))
+            {
+                continue;
+            }
+            if(log_writer_t::m_integer_columns[c] && std::abs(*value) < 18446744073709551616.0)
+            {
+                if(*value < 0.0)
+                {
+                    *first++ = '-';
+                }
+                first = log_write_integer(first, static_cast<uint64_t>(std::abs(*value)));
+            }
+            else
+            {
+                first = log_write_fixed(first, first + log_number_size, *value, log_writer_t::m_precision);
+            }
+        }
+        *first++ = '\n';
+    }
+    log_writer_t::m_output.resize(first - log_writer_t::m_output.data());
+}
+void log_writer_t::compress(const chunk_t& chunk)
+{
+    // Write the block header.
+    // NOTE: The block size is filled in once the block is encoded.
+    log_writer_t::m_output.clear();
+    log_append(log_writer_t::m_output, chunk.n_rows);
+    log_append(log_writer_t::m_output, 0);
+
+    // Encode each value as the XOR against the previous value in its column.
+    // NOTE: Each block starts from zero so that blocks can be decoded independently.
+    // XOR == 0: '0'
+    // Meaningful bits fit in the previous window: '10' + bits.
+    // Otherwise: '11' + 5 bits of leading zeros + 6 bits of length + bits.
+    log_bit_writer_t bits(log_writer_t::m_output);
+    std::vector<uint64_t> previous(log_writer_t::n_c, 0);
+    std::vector<uint32_t> leading(log_writer_t::n_c, 64);
+    std::vector<uint32_t> trailing(log_writer_t::n_c, 0);
+    const double_t* value = chunk.values.data();
+    for(uint32_t r = 0; r < chunk.n_rows; ++r)
+    {
+        for(uint32_t c = 0; c < log_writer_t::n_c; ++c, ++value)
+        {
+            uint64_t current;
+            std::memcpy(&current, value, sizeof(current));
+            uint64_t x = current ^ previous[c];
+            previous[c] = current;
+            if(x == 0)
+            {
+                bits.write(0, 1);
+                continue;
+            }
+            uint32_t lead = std::min(static_cast<uint32_t>(__builtin_clzll(x)), 31U);
+            uint32_t trail = __builtin_ctzll(x);
+            if(leading[c] < 64 && lead >= leading[c] && trail >= trailing[c])
+            {
+                bits.write(2, 2);
+                bits.write(x >> trailing[c], 64 - leading[c] - trailing[c]);
+            }
+            else
+            {
+                uint32_t length = 64 - lead - trail;
+                bits.write(3, 2);
+                bits.write(lead, 5);
+                bits.write(length & 63, 6);
+                bits.write(x >> trail, length);
+                leading[c] = lead;
+                trailing[c] = trail;
+            }
+        }
+    }
+    bits.finish();
+
+    // Fill in the block size.
+    uint32_t size = log_writer_t::m_output.size() - 2 * sizeof(uint32_t);
+    std::memcpy(log_writer_t::m_output.data() + sizeof(uint32_t), &size, sizeof(size));
+}
+bool log_writer_t::open_segment()
+{
+    // Close the current file.
+    if(log_writer_t::m_file.is_open())
+    {
+        log_writer_t::m_file.close();
+        log_writer_t::m_file.clear();
+    }
+
+    // Remove the oldest file beyond the number kept.
+    if(log_writer_t::m_config.rotate_files > 0 && log_writer_t::m_segment >= log_writer_t::m_config.rotate_files)
+    {
+        std::remove(log_writer_t::segment_name(log_writer_t::m_segment - log_writer_t::m_config.rotate_files).c_str());
+    }
+
+    // Open the file for writing.
+    log_writer_t::m_file.open(log_writer_t::segment_name(log_writer_t::m_segment).c_str(), std::ios::binary);
+    if(log_writer_t::m_file.fail())
+    {
+        // Close the stream and clear flags.
+        log_writer_t::m_file.close();
+        log_writer_t::m_file.clear();
+
+        return false;
+    }
+
+    // Write the header.
+    log_writer_t::m_output.clear();
+    if(log_writer_t::m_config.compress)
+    {
+        log_append(log_writer_t::m_output, log_magic);
+        log_append(log_writer_t::m_output, log_version);
+        log_append(log_writer_t::m_output, log_writer_t::n_c);
+        log_append(log_writer_t::m_output, log_writer_t::m_header.size());
+    }
+    log_writer_t::m_output.insert(log_writer_t::m_output.end(), log_writer_t::m_header.begin(), log_writer_t::m_header.end());
+    if(!log_writer_t::m_config.compress)
+    {
+        log_writer_t::m_output.push_back('\n');
+    }
+    log_writer_t::m_file.write(log_writer_t::m_output.data(), log_writer_t::m_output.size());
+    log_writer_t::m_segment_size = log_writer_t::m_output.size();
+    log_writer_t::m_segment_start = std::chrono::steady_clock::now();
+
+    return true;
+}
+std::string log_writer_t::segment_name(uint64_t segment) const
+{
+    // Use the file name directly if not rotating.
+    if(log_writer_t::m_config.rotate_size == 0 && log_writer_t::m_config.rotate_interval <= 0.0)
+    {
+        return log_writer_t::m_file_name;
+    }
+
+    // Insert the sequence number before the extension.
+    size_t slash = log_writer_t::m_file_name.find_last_of('/');
+    size_t dot = log_writer_t::m_file_name.find_last_of('.');
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        dot = log_writer_t::m_file_name.size();
+    }
+    return log_writer_t::m_file_name.substr(0, dot) + "." + std::to_string(segment) + log_writer_t::m_file_name.substr(dot);
+}
+
+// READER: CONSTRUCTORS
+log_reader_t::log_reader_t()
+{
+    log_reader_t::m_compressed = false;
+    log_reader_t::m_rows = 0;
+    log_reader_t::m_bit = 0;
+}
+
+// READER: METHODS
+bool log_reader_t::open(const std::string& file)
+{
+    // Close any open file.
+    log_reader_t::close();
+
+    // Open the file for reading.
+    log_reader_t::m_file.open(file.c_str(), std::ios::binary);
+    if(log_reader_t::m_file.fail())
+    {
+        log_reader_t::close();
+        return false;
+    }
+
+    // Detect the format.
+    uint32_t magic = 0;
+    log_reader_t::m_file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    log_reader_t::m_compressed = log_reader_t::m_file.good() && magic == log_magic;
+    std::string header;
+    if(log_reader_t::m_compressed)
+    {
+        // Read the compressed header.
+        uint32_t version = 0, n_columns = 0, header_size = 0;
+        log_reader_t::m_file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        log_reader_t::m_file.read(reinterpret_cast<char*>(&n_columns), sizeof(n_columns));
+        log_reader_t::m_file.read(reinterpret_cast<char*>(&header_size), sizeof(header_size));
+        header.resize(header_size);
+        log_reader_t::m_file.read(&header[0], header_size);
+        if(!log_reader_t::m_file.good() || version != log_version)
+        {
+            log_reader_t::close();
+            return false;
+        }
+    }
+    else
+    {
+        // Read the CSV header line.
+        log_reader_t::m_file.clear();
+        log_reader_t::m_file.seekg(0);
+        if(!std::getline(log_reader_t::m_file, header))
+        {
+            log_reader_t::close();
+            return false;
+        }
+    }
+
+    // Split the column names.
+    size_t start = 0;
+    while(start <= header.size())
+    {
+        size_t end = header.find(',', start);
+        if(end == std::string::npos)
+        {
+            end = header.size();
+        }
+        log_reader_t::m_columns.push_back(header.substr(start, end - start));
+        start = end + 1;
+    }
+
+    return true;
+}
+bool log_reader_t::read(std::vector<double_t>& row)
+{
+    if(!log_reader_t::m_file.is_open())
+    {
+        return false;
+    }
+    uint32_t n_c = log_reader_t::m_columns.size();
+    row.resize(n_c);
+
+    if(!log_reader_t::m_compressed)
+    {
+        // Read the next non-empty line.
+        do
+        {
+            if(!std::getline(log_reader_t::m_file, log_reader_t::m_line))
+            {
+                return false;
+            }
+        } while(log_reader_t::m_line.empty());
+
+        // Parse each column.
+        // NOTE: Empty and missing columns are read as missing values.
+        const char* text = log_reader_t::m_line.c_str();
+        for(uint32_t c = 0; c < n_c; ++c)
+        {
+            if(*text == ',' || *text == '\0' || *text == '\r')
+            {
+                row[c] = log_writer_t::missing();
+            }
+            else
+            {
+                char* end;
+                row[c] = std::strtod(text, &end);
+                text = end;
+            }
+            while(*text != ',' && *text != '\0')
+            {
+                ++text;
+            }
+            if(*text == ',')
+            {
+                ++text;
+            }
+        }
+        return true;
+    }
+
+    // Read the next block.
+    if(log_reader_t::m_rows == 0)
+    {
+        uint32_t n_rows = 0, size = 0;
+        log_reader_t::m_file.read(reinterpret_cast<char*>(&n_rows), sizeof(n_rows));
+        log_reader_t::m_file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        log_reader_t::m_block.resize(size);
+        log_reader_t::m_file.read(reinterpret_cast<char*>(log_reader_t::m_block.data()), size);
+        if(!log_reader_t::m_file.good() || n_rows == 0)
+        {
+            return false;
+        }
+        log_reader_t::m_rows = n_rows;
+        log_reader_t::m_bit = 0;
+        log_reader_t::m_previous.assign(n_c, 0);
+        log_reader_t::m_leading.assign(n_c, 64);
+        log_reader_t::m_trailing.assign(n_c, 0);
+    }
+
+    // Decode each column against its previous value.
+    for(uint32_t c = 0; c < n_c; ++c)
+    {
+        if(log_reader_t::read_bits(1) == 1)
+        {
+            if(log_reader_t::read_bits(1) == 1)
+            {
+                log_reader_t::m_leading[c] = log_reader_t::read_bits(5);
+                uint32_t length = log_reader_t::read_bits(6);
+                length = (length == 0) ? 64 : length;
+                log_reader_t::m_trailing[c] = 64 - log_reader_t::m_leading[c] - length;
+            }
+            uint32_t length = 64 - log_reader_t::m_leading[c] - log_reader_t::m_trailing[c];
+            log_reader_t::m_previous[c] ^= log_reader_t::read_bits(length) << log_reader_t::m_trailing[c];
+        }
+        std::memcpy(&row[c], &log_reader_t::m_previous[c], sizeof(double_t));
+    }
+    --log_reader_t::m_rows;
+
+    return true;
+}
+void log_reader_t::close()
+{
+    if(log_reader_t::m_file.is_open())
+    {
+        log_reader_t::m_file.close();
+    }
+    log_reader_t::m_file.clear();
+    log_reader_t::m_columns.clear();
+    log_reader_t::m_rows = 0;
+}
+uint64_t log_reader_t::read_bits(uint32_t count)
+{
+    uint64_t bits = 0;
+    while(count > 0)
+    {
+        // Stop at the end of a corrupt block.
+        uint64_t byte = log_reader_t::m_bit >> 3;
+        if(byte >= log_reader_t::m_block.size())
+        {
+            return bits << count;
+        }
+
+        // Take the available bits of the current byte.
+        uint32_t available = 8 - (log_reader_t::m_bit & 7);
+        uint32_t take = std::min(count, available);
+        uint64_t part = (log_reader_t::m_block[byte] >> (available - take)) & ((1U << take) - 1);
+        bits = (bits << take) | part;
+        log_reader_t::m_bit += take;
+        count -= take;
+    }
+    return bits;
+}
+
+// READER: ACCESS
+const std::vector<std::string>& log_reader_t::columns() const
+{
+    return log_reader_t::m_columns;
+}
+int32_t log_reader_t::column(const std::string& name) const
+{
+    for(uint32_t c = 0; c < log_reader_t::m_columns.size(); ++c)
+    {
+        if(log_reader_t::m_columns[c] == name)
+        {
+            return c;
+        }
+    }
+    return -1;
+}
+bool log_reader_t::compressed() const
+{
+    return log_reader_t::m_compressed;
+}
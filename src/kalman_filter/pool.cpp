@@ -0,0 +1,72 @@
+#include <kalman_filter/pool.hpp>
+
+using namespace kalman_filter;
+
+// CONSTRUCTORS
+pool_t::pool_t(const base_t& prototype, uint32_t reserve)
+    : m_prototype(prototype.clone())
+{
+    // Verify that the prototype can be cloned.
+    if(!pool_t::m_prototype)
+    {
+        throw std::runtime_error("failed to create pool (prototype does not implement clone)");
+    }
+
+    // Capture the prototype's checkpoint for resetting recycled filters.
+    pool_t::m_prototype->save_checkpoint(pool_t::m_checkpoint);
+
+    // Allocate reserved filters.
+    pool_t::m_filters.reserve(reserve);
+    pool_t::m_available.reserve(reserve);
+    for(uint32_t i = 0; i < reserve; ++i)
+    {
+        pool_t::m_filters.push_back(pool_t::m_prototype->clone());
+        pool_t::m_available.push_back(pool_t::m_filters.back().get());
+    }
+}
+
+// METHODS
+base_t* pool_t::acquire()
+{
+    base_t* filter;
+    if(pool_t::m_available.empty())
+    {
+        // Allocate a new filter if none are available.
+        pool_t::m_filters.push_back(pool_t::m_prototype->clone());
+        filter = pool_t::m_filters.back().get();
+    }
+    else
+    {
+        // Take the most recently released filter, as its storage is most likely to still be cached.
+        filter = pool_t::m_available.back();
+        pool_t::m_available.pop_back();
+
+        // Restore the prototype's state, covariances, models, and parameters.
+        if(!filter->load_checkpoint(pool_t::m_checkpoint.data(), pool_t::m_checkpoint.size()))
+        {
+            pool_t::m_available.push_back(filter);
+            throw std::runtime_error("failed to acquire filter (checkpoint does not match filter)");
+        }
+    }
+
+    // Clear the runtime state of the previous owner and restore the prototype's observation mode.
+    // NOTE: Setting the averaging mode also removes any pending observations.
+    filter->reset();
+    filter->set_observation_averaging(pool_t::m_prototype->observation_averaging());
+
+    return filter;
+}
+void pool_t::release(base_t* filter)
+{
+    pool_t::m_available.push_back(filter);
+}
+
+// ACCESS
+uint32_t pool_t::n_allocated() const
+{
+    return pool_t::m_filters.size();
+}
+uint32_t pool_t::n_available() const
+{
+    return pool_t::m_available.size();
+}
@@ -0,0 +1,317 @@
+#include <kalman_filter/replay.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <dirent.h>
+
+using namespace kalman_filter;
+
+// LOG FILES
+/// \brief Finds the remaining numbered files of a rotated log.
+/// \param log_file The file name passed to start_log (e.g. log.csv).
+/// \param log_files (OUTPUT) The numbered files (e.g. log.N.csv), ordered by sequence number.
+/// \returns TRUE if any numbered files were found, otherwise FALSE.
+bool find_segments(const std::string& log_file, std::vector<std::string>& log_files)
+{
+    // Split the name around the sequence number, as log_writer_t inserts it before the extension.
+    size_t slash = log_file.find_last_of('/');
+    size_t dot = log_file.find_last_of('.');
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        dot = log_file.size();
+    }
+    size_t name = (slash == std::string::npos) ? 0 : slash + 1;
+    std::string directory = log_file.substr(0, name);
+    std::string prefix = log_file.substr(name, dot - name) + ".";
+    std::string extension = log_file.substr(dot);
+
+    // Collect the numbered files in the directory.
+    DIR* listing = opendir(directory.empty() ? "." : directory.c_str());
+    if(!listing)
+    {
+        return false;
+    }
+    std::vector<std::pair<uint64_t, std::string>> segments;
+    while(dirent* entry = readdir(listing))
+    {
+        std::string file = entry->d_name;
+        if(file.size() <= prefix.size() + extension.size() || file.compare(0, prefix.size(), prefix) != 0 || file.compare(file.size() - extension.size(), extension.size(), extension) != 0)
+        {
+            continue;
+        }
+        std::string number = file.substr(prefix.size(), file.size() - prefix.size() - extension.size());
+        if(number.find_first_not_of("0123456789") != std::string::npos)
+        {
+            continue;
+        }
+        segments.emplace_back(std::strtoull(number.c_str(), nullptr, 10), directory + file);
+    }
+    closedir(listing);
+
+    // Order the files by sequence number.
+    std::sort(segments.begin(), segments.end());
+    log_files.clear();
+    for(auto segment = segments.begin(); segment != segments.end(); ++segment)
+    {
+        log_files.push_back(segment->second);
+    }
+
+    return !log_files.empty();
+}
+
+// CONSTRUCTORS
+replay_t::replay_t(double_t absolute_tolerance, double_t relative_tolerance)
+    : m_recording(0)
+{
+    replay_t::absolute_tolerance = absolute_tolerance;
+    replay_t::relative_tolerance = relative_tolerance;
+    replay_t::m_first_iteration = 0;
+}
+
+// METHODS
+bool replay_t::load(const std::string& log_file)
+{
+    // Load the file directly, or its numbered files if the log was rotated.
+    std::vector<std::string> log_files;
+    if(std::ifstream(log_file.c_str()).good())
+    {
+        log_files.push_back(log_file);
+    }
+    else if(!find_segments(log_file, log_files))
+    {
+        return false;
+    }
+
+    return replay_t::load(log_files);
+}
+bool replay_t::load(const std::vector<std::string>& log_files)
+{
+    // Verify that there is a file to load.
+    if(log_files.empty())
+    {
+        return false;
+    }
+
+    // Load into temporaries, so that the loaded log is unchanged if loading fails.
+    std::vector<std::string> columns;
+    int32_t iteration_column = -1;
+    std::vector<uint32_t> observation_columns;
+    std::vector<uint32_t> observers;
+    std::vector<uint32_t> state_columns;
+    std::vector<uint32_t> states;
+    recording_t recording(0);
+    std::vector<double_t> estimates;
+    uint64_t first_iteration = 0;
+    uint64_t next_iteration = 0;
+
+    std::vector<double_t> row;
+    std::vector<uint32_t> step_observers;
+    std::vector<double_t> step_values;
+    for(auto log_file = log_files.begin(); log_file != log_files.end(); ++log_file)
+    {
+        // Open the file.
+        log_reader_t reader;
+        if(!reader.open(*log_file))
+        {
+            return false;
+        }
+
+        // Verify that later files have the same columns as the first.
+        if(log_file != log_files.begin())
+        {
+            if(reader.columns() != columns)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            // Find the iteration, observation, and estimated state columns.
+            // NOTE: Column names end with the observer or state index (e.g. za_3).
+            columns = reader.columns();
+            uint32_t n_observers = 0;
+            for(uint32_t c = 0; c < columns.size(); ++c)
+            {
+                if(columns[c] == "iteration")
+                {
+                    iteration_column = c;
+                    continue;
+                }
+                bool observation = columns[c].compare(0, 3, "za_") == 0;
+                bool state = columns[c].compare(0, 3, "xe_") == 0;
+                if(!observation && !state)
+                {
+                    continue;
+                }
+                char* end;
+                uint32_t index = std::strtoul(columns[c].c_str() + 3, &end, 10);
+                if(*end != '\0' || end == columns[c].c_str() + 3)
+                {
+                    continue;
+                }
+                if(observation)
+                {
+                    observation_columns.push_back(c);
+                    observers.push_back(index);
+                    n_observers = std::max(n_observers, index + 1);
+                }
+                else
+                {
+                    state_columns.push_back(c);
+                    states.push_back(index);
+                }
+            }
+
+            // Verify that every iteration can be identified and every observer was logged.
+            // NOTE: Each observer has one za_j column, so any missing observer leaves fewer columns than observers.
+            if(iteration_column < 0 || observation_columns.empty() || observation_columns.size() != n_observers)
+            {
+                return false;
+            }
+            recording = recording_t(n_observers);
+        }
+
+        // Load each row as a step.
+        // NOTE: Observations that are missing in a row (NaN) were not made in that iteration.
+        while(reader.read(row))
+        {
+            // Verify that no iteration was skipped by decimation, updates_only, or a missing file.
+            // NOTE: Iterations are exact in a double up to 2^53.
+            double_t iteration = row[iteration_column];
+            if(!(iteration >= 0.0 && iteration <= 9007199254740992.0) || iteration != std::floor(iteration))
+            {
+                return false;
+            }
+            if(recording.n_steps() == 0)
+            {
+                first_iteration = static_cast<uint64_t>(iteration);
+            }
+            else if(static_cast<uint64_t>(iteration) != next_iteration)
+            {
+                return false;
+            }
+            next_iteration = static_cast<uint64_t>(iteration) + 1;
+
+            step_observers.clear();
+            step_values.clear();
+            for(uint32_t j = 0; j < observation_columns.size(); ++j)
+            {
+                double_t value = row[observation_columns[j]];
+                if(!std::isnan(value))
+                {
+                    step_observers.push_back(observers[j]);
+                    step_values.push_back(value);
+                }
+            }
+            recording.add_step(step_observers.data(), step_values.data(), step_observers.size());
+            for(uint32_t i = 0; i < state_columns.size(); ++i)
+            {
+                estimates.push_back(row[state_columns[i]]);
+            }
+        }
+    }
+
+    // Store the loaded log.
+    replay_t::m_recording = std::move(recording);
+    replay_t::m_states.swap(states);
+    replay_t::m_estimates.swap(estimates);
+    replay_t::m_first_iteration = first_iteration;
+
+    return true;
+}
+bool replay_t::run(base_t& filter, replay_report_t& report) const
+{
+    // Verify dimensions.
+    // NOTE: The log must include every observer, so that no observation the filter made is missing from the replay.
+    if(replay_t::m_recording.n_observers() != filter.n_observers())
+    {
+        throw std::runtime_error("failed to replay log (log observers do not match filter)");
+    }
+    for(auto state = replay_t::m_states.begin(); state != replay_t::m_states.end(); ++state)
+    {
+        if(*state >= filter.n_variables())
+        {
+            throw std::runtime_error("failed to replay log (log states do not match filter)");
+        }
+    }
+
+    // Reset the report.
+    report.valid = true;
+    report.error.clear();
+    report.matched = true;
+    report.n_steps = 0;
+    report.step = 0;
+    report.description.clear();
+    report.max_state_error = 0.0;
+    report.runtime = 0.0;
+    report.rate = 0.0;
+
+    // Replay each step without waiting.
+    uint32_t n_s = replay_t::m_states.size();
+    const double_t* estimate = replay_t::m_estimates.data();
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        for(uint32_t step = 0; step < replay_t::m_recording.n_steps(); ++step, estimate += n_s)
+        {
+            ++report.n_steps;
+
+            // Iterate the filter on the step's observations.
+            if(replay_t::step_function)
+            {
+                replay_t::step_function(filter, step);
+            }
+            filter.new_observations(replay_t::m_recording.observers(step), replay_t::m_recording.values(step), replay_t::m_recording.n_observations(step));
+            filter.iterate();
+
+            // Compare the estimated state against the log.
+            // NOTE: The replay continues after a mismatch so that the throughput covers the whole log.
+            const Eigen::VectorXd& x = filter.state();
+            for(uint32_t i = 0; i < n_s; ++i)
+            {
+                double_t error = std::abs(x(replay_t::m_states[i]) - estimate[i]);
+                report.max_state_error = std::max(report.max_state_error, error);
+                if(report.matched && !(error <= replay_t::absolute_tolerance + replay_t::relative_tolerance * std::abs(estimate[i])))
+                {
+                    report.matched = false;
+                    report.step = step;
+                    std::stringstream description;
+                    description.precision(17);
+                    description << "x(" << replay_t::m_states[i] << "): logged " << estimate[i] << ", replayed " << x(replay_t::m_states[i]);
+                    report.description = description.str();
+                }
+            }
+        }
+    }
+    catch(const std::exception& exception)
+    {
+        report.valid = false;
+        report.error = exception.what();
+    }
+    report.runtime = std::chrono::duration<double_t>(std::chrono::steady_clock::now() - start).count();
+    if(report.runtime > 0.0)
+    {
+        report.rate = report.n_steps / report.runtime;
+    }
+
+    return report.valid && report.matched;
+}
+
+// ACCESS
+const recording_t& replay_t::recording() const
+{
+    return replay_t::m_recording;
+}
+const std::vector<uint32_t>& replay_t::states() const
+{
+    return replay_t::m_states;
+}
+uint64_t replay_t::first_iteration() const
+{
+    return replay_t::m_first_iteration;
+}
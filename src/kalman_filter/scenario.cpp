@@ -0,0 +1,498 @@
+#include <kalman_filter/scenario.hpp>
+
+#include <cmath>
+
+using namespace kalman_filter;
+
+// STREAM FORMAT
+/// \brief The magic number identifying scenario files ("KFSC").
+const uint32_t scenario_magic = 0x4353464B;
+/// \brief The current scenario file format version.
+const uint32_t scenario_version = 1;
+/// \brief The header of a scenario file.
+struct scenario_header_t
+{
+    /// \brief The magic number identifying the file.
+    uint32_t magic;
+    /// \brief The file format version.
+    uint32_t version;
+    /// \brief The number of variables in the true state.
+    uint32_t n_variables;
+    /// \brief The number of observers.
+    uint32_t n_observers;
+    /// \brief The time between steps.
+    double_t dt;
+};
+
+// CONFIGURATION
+scenario_config_t::scenario_config_t()
+{
+    scenario_config_t::model = scenario_model_t::CONSTANT_VELOCITY;
+    scenario_config_t::n_dimensions = 2;
+    scenario_config_t::n_steps = 1000;
+    scenario_config_t::dt = 0.01;
+    scenario_config_t::seed = 0;
+    scenario_config_t::process_noise = 1.0;
+    scenario_config_t::turn_rate_noise = 0.01;
+    scenario_config_t::observation_noise = 1.0;
+    scenario_config_t::sensor_spacing = 100.0;
+    scenario_config_t::length = 1.0;
+}
+
+// WRITER
+scenario_writer_t::scenario_writer_t()
+{
+    scenario_writer_t::n_x = 0;
+}
+bool scenario_writer_t::open(const std::string& file, uint32_t n_variables, uint32_t n_observers, double_t dt)
+{
+    // Close any existing file.
+    scenario_writer_t::close();
+
+    // Open the file for writing.
+    scenario_writer_t::m_file.open(file.c_str(), std::ios::binary | std::ios::trunc);
+    if(scenario_writer_t::m_file.fail())
+    {
+        scenario_writer_t::m_file.close();
+        scenario_writer_t::m_file.clear();
+        return false;
+    }
+
+    // Write the header.
+    scenario_header_t header = {scenario_magic, scenario_version, n_variables, n_observers, dt};
+    scenario_writer_t::m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    scenario_writer_t::n_x = n_variables;
+
+    return true;
+}
+void scenario_writer_t::write(const uint32_t* observer_indices, const double_t* observations, uint32_t count, const Eigen::VectorXd& truth)
+{
+    // Verify the true state dimension.
+    if(truth.size() != scenario_writer_t::n_x)
+    {
+        throw std::runtime_error("failed to write scenario step (truth dimension does not match file)");
+    }
+
+    // Write the record.
+    scenario_writer_t::m_file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    scenario_writer_t::m_file.write(reinterpret_cast<const char*>(observer_indices), count * sizeof(uint32_t));
+    scenario_writer_t::m_file.write(reinterpret_cast<const char*>(observations), count * sizeof(double_t));
+    scenario_writer_t::m_file.write(reinterpret_cast<const char*>(truth.data()), scenario_writer_t::n_x * sizeof(double_t));
+}
+bool scenario_writer_t::close()
+{
+    // Check if a file is open.
+    if(!scenario_writer_t::m_file.is_open())
+    {
+        return true;
+    }
+
+    // Flush and close the stream, and reset flags.
+    scenario_writer_t::m_file.close();
+    bool success = !scenario_writer_t::m_file.fail();
+    scenario_writer_t::m_file.clear();
+
+    return success;
+}
+
+// READER
+scenario_reader_t::scenario_reader_t()
+{
+    scenario_reader_t::n_x = 0;
+    scenario_reader_t::n_z = 0;
+    scenario_reader_t::m_dt = 0.0;
+}
+bool scenario_reader_t::open(const std::string& file)
+{
+    // Close any existing file.
+    scenario_reader_t::close();
+
+    // Open the file for reading.
+    scenario_reader_t::m_file.open(file.c_str(), std::ios::binary);
+
+    // Read and verify the header.
+    scenario_header_t header;
+    scenario_reader_t::m_file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if(scenario_reader_t::m_file.fail() || header.magic != scenario_magic || header.version != scenario_version)
+    {
+        scenario_reader_t::close();
+        return false;
+    }
+
+    // Store dimensions.
+    scenario_reader_t::n_x = header.n_variables;
+    scenario_reader_t::n_z = header.n_observers;
+    scenario_reader_t::m_dt = header.dt;
+
+    return true;
+}
+bool scenario_reader_t::read(std::vector<uint32_t>& observer_indices, std::vector<double_t>& observations, Eigen::VectorXd& truth)
+{
+    // Read the observation count.
+    uint32_t count;
+    if(!scenario_reader_t::m_file.read(reinterpret_cast<char*>(&count), sizeof(count)))
+    {
+        return false;
+    }
+    if(count > scenario_reader_t::n_z)
+    {
+        throw std::runtime_error("failed to read scenario step (observation count out of range)");
+    }
+
+    // Read the record.
+    observer_indices.resize(count);
+    observations.resize(count);
+    truth.resize(scenario_reader_t::n_x);
+    scenario_reader_t::m_file.read(reinterpret_cast<char*>(observer_indices.data()), count * sizeof(uint32_t));
+    scenario_reader_t::m_file.read(reinterpret_cast<char*>(observations.data()), count * sizeof(double_t));
+    scenario_reader_t::m_file.read(reinterpret_cast<char*>(truth.data()), scenario_reader_t::n_x * sizeof(double_t));
+    if(scenario_reader_t::m_file.fail())
+    {
+        throw std::runtime_error("failed to read scenario step (truncated record)");
+    }
+
+    return true;
+}
+uint32_t scenario_reader_t::read(recording_t& recording)
+{
+    // Verify recording dimensions.
+    if(recording.n_observers() != scenario_reader_t::n_z)
+    {
+        throw std::runtime_error("failed to read scenario (recording observers do not match file)");
+    }
+
+    // Append each step.
+    std::vector<uint32_t> observer_indices;
+    std::vector<double_t> observations;
+    Eigen::VectorXd truth;
+    uint32_t n_steps = 0;
+    while(scenario_reader_t::read(observer_indices, observations, truth))
+    {
+        recording.add_step(observer_indices.data(), observations.data(), observations.size(), truth);
+        ++n_steps;
+    }
+
+    return n_steps;
+}
+void scenario_reader_t::close()
+{
+    // Close the stream and reset flags.
+    scenario_reader_t::m_file.close();
+    scenario_reader_t::m_file.clear();
+}
+uint32_t scenario_reader_t::n_variables() const
+{
+    return scenario_reader_t::n_x;
+}
+uint32_t scenario_reader_t::n_observers() const
+{
+    return scenario_reader_t::n_z;
+}
+double_t scenario_reader_t::dt() const
+{
+    return scenario_reader_t::m_dt;
+}
+
+// CONSTRUCTORS
+scenario_t::scenario_t(const scenario_config_t& config)
+    : m_config(config),
+      m_engine(config.seed)
+{
+    // Set up dimensions and the default initial state of the model.
+    uint32_t n_d = config.n_dimensions;
+    switch(config.model)
+    {
+        case scenario_model_t::CONSTANT_VELOCITY:
+        {
+            scenario_t::n_x = 2 * n_d;
+            scenario_t::n_z = n_d;
+            scenario_t::x.setZero(scenario_t::n_x);
+            scenario_t::x.tail(n_d).setOnes();
+            break;
+        }
+        case scenario_model_t::CONSTANT_ACCELERATION:
+        {
+            scenario_t::n_x = 3 * n_d;
+            scenario_t::n_z = n_d;
+            scenario_t::x.setZero(scenario_t::n_x);
+            scenario_t::x.segment(n_d, n_d).setOnes();
+            break;
+        }
+        case scenario_model_t::COORDINATED_TURN:
+        {
+            scenario_t::n_x = 5;
+            scenario_t::n_z = 2;
+            scenario_t::x.resize(5);
+            scenario_t::x << 0.0, 0.0, 10.0, 0.0, 0.1;
+            break;
+        }
+        case scenario_model_t::BEARING_ONLY:
+        {
+            scenario_t::n_x = 4;
+            scenario_t::n_z = n_d;
+            scenario_t::x.resize(4);
+            scenario_t::x << 500.0, 1000.0, -5.0, 0.0;
+            break;
+        }
+        case scenario_model_t::PENDULUM:
+        {
+            scenario_t::n_x = 2;
+            scenario_t::n_z = 2;
+            scenario_t::x.resize(2);
+            scenario_t::x << 0.5, 0.0;
+            break;
+        }
+        default:
+        {
+            throw std::runtime_error("invalid scenario model");
+        }
+    }
+    if(scenario_t::n_z == 0)
+    {
+        throw std::runtime_error("invalid scenario configuration (n_dimensions must be at least one)");
+    }
+
+    // Verify the configuration.
+    if(config.x0.size() > 0)
+    {
+        if(config.x0.size() != scenario_t::n_x)
+        {
+            throw std::runtime_error("invalid scenario configuration (x0 dimension does not match model)");
+        }
+        scenario_t::x = config.x0;
+    }
+    if(!config.periods.empty() && config.periods.size() != scenario_t::n_z)
+    {
+        throw std::runtime_error("invalid scenario configuration (periods dimension does not match model)");
+    }
+    for(auto period = config.periods.begin(); period != config.periods.end(); ++period)
+    {
+        if(*period == 0)
+        {
+            throw std::runtime_error("invalid scenario configuration (periods must be at least one)");
+        }
+    }
+    if(!config.dropouts.empty() && config.dropouts.size() != scenario_t::n_z)
+    {
+        throw std::runtime_error("invalid scenario configuration (dropouts dimension does not match model)");
+    }
+
+    // Allocate observation storage.
+    scenario_t::z.setZero(scenario_t::n_z);
+
+    // Initialize state.
+    scenario_t::m_step = 0;
+    scenario_t::m_normal = 0.0;
+    scenario_t::m_has_normal = false;
+}
+
+// METHODS
+bool scenario_t::step(std::vector<uint32_t>& observer_indices, std::vector<double_t>& observations)
+{
+    // Check if the scenario is complete.
+    if(scenario_t::m_step == scenario_t::m_config.n_steps)
+    {
+        return false;
+    }
+    ++scenario_t::m_step;
+
+    // Propagate and observe the true state.
+    scenario_t::propagate();
+    scenario_t::observe();
+
+    // Make noisy observations from the observers that are due and not dropped.
+    // NOTE: Random samples are drawn for every observer every step, so changing rates does not change the noise sequence.
+    observer_indices.clear();
+    observations.clear();
+    for(uint32_t i = 0; i < scenario_t::n_z; ++i)
+    {
+        double_t noise = scenario_t::m_config.observation_noise * scenario_t::normal();
+        double_t drop = scenario_t::uniform();
+
+        bool due = scenario_t::m_config.periods.empty() || scenario_t::m_step % scenario_t::m_config.periods[i] == 0;
+        bool dropped = !scenario_t::m_config.dropouts.empty() && drop < scenario_t::m_config.dropouts[i];
+        if(due && !dropped)
+        {
+            observer_indices.push_back(i);
+            observations.push_back(scenario_t::z(i) + noise);
+        }
+    }
+
+    return true;
+}
+void scenario_t::generate(scenario_writer_t& writer)
+{
+    std::vector<uint32_t> observer_indices;
+    std::vector<double_t> observations;
+    while(scenario_t::step(observer_indices, observations))
+    {
+        writer.write(observer_indices.data(), observations.data(), observations.size(), scenario_t::x);
+    }
+}
+void scenario_t::generate(recording_t& recording)
+{
+    // Verify recording dimensions.
+    if(recording.n_observers() != scenario_t::n_z)
+    {
+        throw std::runtime_error("failed to generate scenario (recording observers do not match scenario)");
+    }
+
+    std::vector<uint32_t> observer_indices;
+    std::vector<double_t> observations;
+    while(scenario_t::step(observer_indices, observations))
+    {
+        recording.add_step(observer_indices.data(), observations.data(), observations.size(), scenario_t::x);
+    }
+}
+double_t scenario_t::uniform()
+{
+    // Use the top 53 bits of the engine output.
+    return static_cast<double_t>(scenario_t::m_engine() >> 11) * (1.0 / 9007199254740992.0);
+}
+double_t scenario_t::normal()
+{
+    // Return the cached sample if available.
+    if(scenario_t::m_has_normal)
+    {
+        scenario_t::m_has_normal = false;
+        return scenario_t::m_normal;
+    }
+
+    // Draw two samples with the Box-Muller transform.
+    double_t u1 = 1.0 - scenario_t::uniform();
+    double_t u2 = scenario_t::uniform();
+    double_t r = std::sqrt(-2.0 * std::log(u1));
+    scenario_t::m_normal = r * std::sin(2.0 * M_PI * u2);
+    scenario_t::m_has_normal = true;
+    return r * std::cos(2.0 * M_PI * u2);
+}
+void scenario_t::propagate()
+{
+    double_t dt = scenario_t::m_config.dt;
+    double_t q = scenario_t::m_config.process_noise;
+    uint32_t n_d = scenario_t::m_config.n_dimensions;
+
+    switch(scenario_t::m_config.model)
+    {
+        case scenario_model_t::CONSTANT_VELOCITY:
+        {
+            for(uint32_t d = 0; d < n_d; ++d)
+            {
+                double_t a = q * scenario_t::normal();
+                scenario_t::x(d) += scenario_t::x(n_d + d) * dt + 0.5 * a * dt * dt;
+                scenario_t::x(n_d + d) += a * dt;
+            }
+            break;
+        }
+        case scenario_model_t::CONSTANT_ACCELERATION:
+        {
+            for(uint32_t d = 0; d < n_d; ++d)
+            {
+                double_t j = q * scenario_t::normal();
+                double_t v = scenario_t::x(n_d + d);
+                double_t a = scenario_t::x(2 * n_d + d);
+                scenario_t::x(d) += v * dt + 0.5 * a * dt * dt + j * dt * dt * dt / 6.0;
+                scenario_t::x(n_d + d) += a * dt + 0.5 * j * dt * dt;
+                scenario_t::x(2 * n_d + d) += j * dt;
+            }
+            break;
+        }
+        case scenario_model_t::COORDINATED_TURN:
+        {
+            double_t vx = scenario_t::x(2);
+            double_t vy = scenario_t::x(3);
+            double_t w = scenario_t::x(4);
+
+            // Rotate the velocity through the turn, using the straight line limit for small turn rates.
+            double_t s = std::sin(w * dt);
+            double_t c = std::cos(w * dt);
+            if(std::abs(w) > 1E-9)
+            {
+                scenario_t::x(0) += (s * vx - (1.0 - c) * vy) / w;
+                scenario_t::x(1) += ((1.0 - c) * vx + s * vy) / w;
+            }
+            else
+            {
+                scenario_t::x(0) += vx * dt;
+                scenario_t::x(1) += vy * dt;
+            }
+            scenario_t::x(2) = c * vx - s * vy;
+            scenario_t::x(3) = s * vx + c * vy;
+
+            // Add acceleration and turn rate noise.
+            for(uint32_t d = 0; d < 2; ++d)
+            {
+                double_t a = q * scenario_t::normal();
+                scenario_t::x(d) += 0.5 * a * dt * dt;
+                scenario_t::x(2 + d) += a * dt;
+            }
+            scenario_t::x(4) += scenario_t::m_config.turn_rate_noise * std::sqrt(dt) * scenario_t::normal();
+            break;
+        }
+        case scenario_model_t::BEARING_ONLY:
+        {
+            for(uint32_t d = 0; d < 2; ++d)
+            {
+                double_t a = q * scenario_t::normal();
+                scenario_t::x(d) += scenario_t::x(2 + d) * dt + 0.5 * a * dt * dt;
+                scenario_t::x(2 + d) += a * dt;
+            }
+            break;
+        }
+        case scenario_model_t::PENDULUM:
+        {
+            // Integrate with semi-implicit Euler, which keeps the energy bounded.
+            double_t g = 9.80665;
+            double_t alpha = -g / scenario_t::m_config.length * std::sin(scenario_t::x(0)) + q * scenario_t::normal();
+            scenario_t::x(1) += alpha * dt;
+            scenario_t::x(0) += scenario_t::x(1) * dt;
+            break;
+        }
+    }
+}
+void scenario_t::observe()
+{
+    switch(scenario_t::m_config.model)
+    {
+        case scenario_model_t::CONSTANT_VELOCITY:
+        case scenario_model_t::CONSTANT_ACCELERATION:
+        case scenario_model_t::COORDINATED_TURN:
+        {
+            scenario_t::z = scenario_t::x.head(scenario_t::n_z);
+            break;
+        }
+        case scenario_model_t::BEARING_ONLY:
+        {
+            for(uint32_t i = 0; i < scenario_t::n_z; ++i)
+            {
+                double_t sensor_x = i * scenario_t::m_config.sensor_spacing;
+                scenario_t::z(i) = std::atan2(scenario_t::x(1), scenario_t::x(0) - sensor_x);
+            }
+            break;
+        }
+        case scenario_model_t::PENDULUM:
+        {
+            scenario_t::z(0) = scenario_t::m_config.length * std::sin(scenario_t::x(0));
+            scenario_t::z(1) = -scenario_t::m_config.length * std::cos(scenario_t::x(0));
+            break;
+        }
+    }
+}
+
+// ACCESS
+uint32_t scenario_t::n_variables() const
+{
+    return scenario_t::n_x;
+}
+uint32_t scenario_t::n_observers() const
+{
+    return scenario_t::n_z;
+}
+const Eigen::VectorXd& scenario_t::truth() const
+{
+    return scenario_t::x;
+}
+const scenario_config_t& scenario_t::config() const
+{
+    return scenario_t::m_config;
+}
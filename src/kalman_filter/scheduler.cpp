@@ -0,0 +1,210 @@
+#include <kalman_filter/scheduler.hpp>
+
+#include <algorithm>
+
+using namespace kalman_filter;
+
+// CONSTRUCTORS
+scheduler_t::scheduler_t(uint32_t n_threads)
+{
+    // Use all hardware threads by default.
+    if(n_threads == 0)
+    {
+        n_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    // Initialize synchronization.
+    scheduler_t::m_batch = 0;
+    scheduler_t::m_stop = false;
+    scheduler_t::m_active = 0;
+    scheduler_t::m_filters = nullptr;
+
+    // Allocate a queue for each thread.
+    for(uint32_t i = 0; i < n_threads; ++i)
+    {
+        scheduler_t::m_queues.emplace_back(new queue_t);
+        scheduler_t::m_queues.back()->begin = 0;
+        scheduler_t::m_queues.back()->end = 0;
+        scheduler_t::m_queues.back()->load = 0.0;
+    }
+
+    // Start background threads.
+    // NOTE: Queue 0 belongs to the calling thread.
+    for(uint32_t i = 1; i < n_threads; ++i)
+    {
+        scheduler_t::m_threads.emplace_back(&scheduler_t::worker, this, i);
+    }
+}
+scheduler_t::~scheduler_t()
+{
+    // Signal background threads to stop.
+    {
+        std::lock_guard<std::mutex> lock(scheduler_t::m_mutex);
+        scheduler_t::m_stop = true;
+    }
+    scheduler_t::m_start.notify_all();
+
+    // Wait for background threads to exit.
+    for(auto thread = scheduler_t::m_threads.begin(); thread != scheduler_t::m_threads.end(); ++thread)
+    {
+        thread->join();
+    }
+}
+
+// METHODS
+void scheduler_t::iterate(const std::vector<base_t*>& filters)
+{
+    uint32_t n_f = filters.size();
+    uint32_t n_q = scheduler_t::m_queues.size();
+
+    // ---------- STEP 1: SEEDING ----------
+
+    // Estimate the cost of each filter and order filters by decreasing cost.
+    scheduler_t::m_costs.resize(n_f);
+    scheduler_t::m_order.resize(n_f);
+    for(uint32_t f = 0; f < n_f; ++f)
+    {
+        scheduler_t::m_costs[f] = filters[f]->iteration_cost();
+        scheduler_t::m_order[f] = f;
+    }
+    std::sort(scheduler_t::m_order.begin(), scheduler_t::m_order.end(), [this](uint32_t a, uint32_t b) { return scheduler_t::m_costs[a] > scheduler_t::m_costs[b]; });
+
+    // Place each filter onto the least loaded queue (longest processing time first).
+    for(auto queue = scheduler_t::m_queues.begin(); queue != scheduler_t::m_queues.end(); ++queue)
+    {
+        (*queue)->tasks.clear();
+        (*queue)->load = 0.0;
+    }
+    for(auto f = scheduler_t::m_order.begin(); f != scheduler_t::m_order.end(); ++f)
+    {
+        queue_t* least = scheduler_t::m_queues.front().get();
+        for(uint32_t q = 1; q < n_q; ++q)
+        {
+            if(scheduler_t::m_queues[q]->load < least->load)
+            {
+                least = scheduler_t::m_queues[q].get();
+            }
+        }
+        least->tasks.push_back(*f);
+        least->load += scheduler_t::m_costs[*f];
+    }
+    for(auto queue = scheduler_t::m_queues.begin(); queue != scheduler_t::m_queues.end(); ++queue)
+    {
+        (*queue)->begin = 0;
+        (*queue)->end = (*queue)->tasks.size();
+    }
+
+    // ---------- STEP 2: EXECUTION ----------
+
+    // Start the batch on the background threads.
+    {
+        std::lock_guard<std::mutex> lock(scheduler_t::m_mutex);
+        scheduler_t::m_filters = &filters;
+        scheduler_t::m_exception = nullptr;
+        scheduler_t::m_active = n_q;
+        ++scheduler_t::m_batch;
+    }
+    scheduler_t::m_start.notify_all();
+
+    // Run tasks on the calling thread.
+    scheduler_t::run(0);
+
+    // ---------- STEP 3: BARRIER ----------
+
+    // Wait for all threads to finish.
+    {
+        std::unique_lock<std::mutex> lock(scheduler_t::m_mutex);
+        scheduler_t::m_done.wait(lock, [this]{ return scheduler_t::m_active == 0; });
+        scheduler_t::m_filters = nullptr;
+    }
+
+    // Rethrow the first filter exception.
+    if(scheduler_t::m_exception)
+    {
+        std::exception_ptr exception = scheduler_t::m_exception;
+        scheduler_t::m_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+void scheduler_t::worker(uint32_t index)
+{
+    uint64_t batch = 0;
+    while(true)
+    {
+        // Wait for a new batch or a stop signal.
+        {
+            std::unique_lock<std::mutex> lock(scheduler_t::m_mutex);
+            scheduler_t::m_start.wait(lock, [this, batch]{ return scheduler_t::m_stop || scheduler_t::m_batch != batch; });
+            if(scheduler_t::m_stop)
+            {
+                return;
+            }
+            batch = scheduler_t::m_batch;
+        }
+
+        scheduler_t::run(index);
+    }
+}
+void scheduler_t::run(uint32_t index)
+{
+    // Iterate filters until all queues are empty.
+    uint32_t task;
+    while(scheduler_t::take(index, task))
+    {
+        try
+        {
+            (*scheduler_t::m_filters)[task]->iterate();
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(scheduler_t::m_mutex);
+            if(!scheduler_t::m_exception)
+            {
+                scheduler_t::m_exception = std::current_exception();
+            }
+        }
+    }
+
+    // Signal completion if this is the last thread working on the batch.
+    if(--scheduler_t::m_active == 0)
+    {
+        std::lock_guard<std::mutex> lock(scheduler_t::m_mutex);
+        scheduler_t::m_done.notify_all();
+    }
+}
+bool scheduler_t::take(uint32_t index, uint32_t& task)
+{
+    uint32_t n_q = scheduler_t::m_queues.size();
+
+    // Take the most expensive remaining task from the thread's own queue.
+    {
+        queue_t& own = *scheduler_t::m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if(own.begin < own.end)
+        {
+            task = own.tasks[own.begin++];
+            return true;
+        }
+    }
+
+    // Steal the cheapest remaining task from another queue.
+    // NOTE: Queues are never refilled during a batch, so an empty sweep means all tasks are taken.
+    for(uint32_t i = 1; i < n_q; ++i)
+    {
+        queue_t& victim = *scheduler_t::m_queues[(index + i) % n_q];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(victim.begin < victim.end)
+        {
+            task = victim.tasks[--victim.end];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// ACCESS
+uint32_t scheduler_t::n_threads() const
+{
+    return scheduler_t::m_queues.size();
+}
@@ -0,0 +1,265 @@
+#include <kalman_filter/shm.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace kalman_filter;
+
+// SEGMENT FORMAT
+/// \brief The magic number identifying shared memory state segments ("KFSM").
+const uint32_t shm_magic = 0x4D53464B;
+/// \brief The current shared memory segment format version.
+const uint32_t shm_version = 1;
+/// \brief The number of attempts a subscriber makes to read a consistent snapshot.
+const uint32_t shm_read_attempts = 10000;
+/// \brief Calculates the size of a shared memory segment.
+/// \param n_variables The number of variables in the state vector.
+/// \returns The size in bytes.
+size_t shm_size(uint32_t n_variables)
+{
+    return sizeof(shm_header_t) + (n_variables + n_variables * n_variables) * sizeof(double_t);
+}
+
+// PUBLISHER
+shm_publisher_t::shm_publisher_t()
+{
+    shm_publisher_t::m_size = 0;
+    shm_publisher_t::m_header = nullptr;
+    shm_publisher_t::m_device = 0;
+    shm_publisher_t::m_inode = 0;
+}
+shm_publisher_t::~shm_publisher_t()
+{
+    shm_publisher_t::close();
+}
+bool shm_publisher_t::open(const std::string& name, uint32_t n_variables)
+{
+    // Close any existing segment.
+    shm_publisher_t::close();
+
+    // Create the segment.
+    // NOTE: The segment must not exist, so that one publisher never takes over or removes another's segment.
+    int32_t segment = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(segment < 0)
+    {
+        return false;
+    }
+
+    // Size and map the segment.
+    size_t size = shm_size(n_variables);
+    void* memory = MAP_FAILED;
+    struct stat segment_stat;
+    if(fstat(segment, &segment_stat) == 0 && ftruncate(segment, size) == 0)
+    {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment, 0);
+    }
+    ::close(segment);
+    if(memory == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // Initialize the header.
+    shm_publisher_t::m_header = new (memory) shm_header_t;
+    shm_publisher_t::m_header->magic = shm_magic;
+    shm_publisher_t::m_header->version = shm_version;
+    shm_publisher_t::m_header->n_variables = n_variables;
+    shm_publisher_t::m_header->reserved = 0;
+    shm_publisher_t::m_header->iteration = 0;
+    shm_publisher_t::m_header->timestamp = 0;
+    shm_publisher_t::m_header->sequence.store(0, std::memory_order_release);
+
+    // Store segment information.
+    shm_publisher_t::m_name = name;
+    shm_publisher_t::m_size = size;
+    shm_publisher_t::m_device = segment_stat.st_dev;
+    shm_publisher_t::m_inode = segment_stat.st_ino;
+
+    return true;
+}
+void shm_publisher_t::close()
+{
+    // Check if a segment is open.
+    if(shm_publisher_t::m_header)
+    {
+        // Unmap the segment.
+        munmap(shm_publisher_t::m_header, shm_publisher_t::m_size);
+
+        // Remove the segment only if the name still refers to the segment this publisher created.
+        // NOTE: The segment may have been removed externally and the name reused by another publisher.
+        int32_t segment = shm_open(shm_publisher_t::m_name.c_str(), O_RDONLY, 0);
+        if(segment >= 0)
+        {
+            struct stat segment_stat;
+            bool owned = fstat(segment, &segment_stat) == 0 && segment_stat.st_dev == shm_publisher_t::m_device && segment_stat.st_ino == shm_publisher_t::m_inode;
+            ::close(segment);
+            if(owned)
+            {
+                shm_unlink(shm_publisher_t::m_name.c_str());
+            }
+        }
+
+        // Reset segment information.
+        shm_publisher_t::m_header = nullptr;
+        shm_publisher_t::m_size = 0;
+        shm_publisher_t::m_name.clear();
+        shm_publisher_t::m_device = 0;
+        shm_publisher_t::m_inode = 0;
+    }
+}
+void shm_publisher_t::publish(const Eigen::VectorXd& x, const Eigen::MatrixXd& P, uint64_t iteration)
+{
+    // Check if a segment is open.
+    if(!shm_publisher_t::m_header)
+    {
+        return;
+    }
+
+    // Get data pointer.
+    double_t* data = reinterpret_cast<double_t*>(shm_publisher_t::m_header + 1);
+    uint32_t n_x = shm_publisher_t::m_header->n_variables;
+
+    // Mark write as in progress (odd sequence).
+    uint64_t sequence = shm_publisher_t::m_header->sequence.load(std::memory_order_relaxed);
+    shm_publisher_t::m_header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Write snapshot.
+    shm_publisher_t::m_header->iteration = iteration;
+    shm_publisher_t::m_header->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::memcpy(data, x.data(), n_x * sizeof(double_t));
+    std::memcpy(data + n_x, P.data(), n_x * n_x * sizeof(double_t));
+
+    // Mark write as complete (even sequence).
+    shm_publisher_t::m_header->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// SUBSCRIBER
+shm_subscriber_t::shm_subscriber_t()
+{
+    shm_subscriber_t::m_size = 0;
+    shm_subscriber_t::m_header = nullptr;
+}
+shm_subscriber_t::~shm_subscriber_t()
+{
+    shm_subscriber_t::close();
+}
+bool shm_subscriber_t::open(const std::string& name)
+{
+    // Close any existing segment.
+    shm_subscriber_t::close();
+
+    // Open the segment as read-only.
+    int32_t segment = shm_open(name.c_str(), O_RDONLY, 0);
+    if(segment < 0)
+    {
+        return false;
+    }
+
+    // Get the size of the segment and map it.
+    struct stat segment_stat;
+    void* memory = MAP_FAILED;
+    if(fstat(segment, &segment_stat) == 0 && static_cast<size_t>(segment_stat.st_size) >= sizeof(shm_header_t))
+    {
+        memory = mmap(nullptr, segment_stat.st_size, PROT_READ, MAP_SHARED, segment, 0);
+    }
+    ::close(segment);
+    if(memory == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // Verify the header.
+    const shm_header_t* header = reinterpret_cast<const shm_header_t*>(memory);
+    if(header->magic != shm_magic || header->version != shm_version || static_cast<size_t>(segment_stat.st_size) != shm_size(header->n_variables))
+    {
+        munmap(memory, segment_stat.st_size);
+        return false;
+    }
+
+    // Store segment information.
+    shm_subscriber_t::m_header = header;
+    shm_subscriber_t::m_size = segment_stat.st_size;
+
+    return true;
+}
+void shm_subscriber_t::close()
+{
+    // Check if a segment is open.
+    if(shm_subscriber_t::m_header)
+    {
+        // Unmap the segment.
+        munmap(const_cast<shm_header_t*>(shm_subscriber_t::m_header), shm_subscriber_t::m_size);
+
+        // Reset segment information.
+        shm_subscriber_t::m_header = nullptr;
+        shm_subscriber_t::m_size = 0;
+    }
+}
+bool shm_subscriber_t::read(Eigen::VectorXd& x, Eigen::MatrixXd& P, uint64_t& iteration, int64_t& timestamp) const
+{
+    // Check if a segment is open.
+    if(!shm_subscriber_t::m_header)
+    {
+        return false;
+    }
+
+    // Get data pointer.
+    const double_t* data = reinterpret_cast<const double_t*>(shm_subscriber_t::m_header + 1);
+    uint32_t n_x = shm_subscriber_t::m_header->n_variables;
+
+    // Size outputs.
+    // NOTE: This does not reallocate if the outputs are already sized.
+    x.resize(n_x);
+    P.resize(n_x, n_x);
+
+    // Read until a consistent snapshot is captured.
+    // NOTE: Attempts are bounded, as a publisher that stopped mid-write leaves the sequence odd forever.
+    for(uint32_t attempt = 0; attempt < shm_read_attempts; ++attempt)
+    {
+        // Wait for any in progress write to complete.
+        uint64_t sequence = shm_subscriber_t::m_header->sequence.load(std::memory_order_acquire);
+        if(sequence & 1)
+        {
+            continue;
+        }
+        // Check if anything has been published.
+        if(sequence == 0)
+        {
+            return false;
+        }
+
+        // Read snapshot.
+        iteration = shm_subscriber_t::m_header->iteration;
+        timestamp = shm_subscriber_t::m_header->timestamp;
+        std::memcpy(x.data(), data, n_x * sizeof(double_t));
+        std::memcpy(P.data(), data + n_x, n_x * n_x * sizeof(double_t));
+
+        // Verify that no write occurred during the read.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(shm_subscriber_t::m_header->sequence.load(std::memory_order_relaxed) == sequence)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// ACCESS
+uint32_t shm_subscriber_t::n_variables() const
+{
+    if(!shm_subscriber_t::m_header)
+    {
+        return 0;
+    }
+
+    return shm_subscriber_t::m_header->n_variables;
+}
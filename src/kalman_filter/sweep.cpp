@@ -0,0 +1,254 @@
+#include <kalman_filter/sweep.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace kalman_filter;
+
+// RECORDING
+recording_t::recording_t(uint32_t n_observers)
+{
+    recording_t::n_z = n_observers;
+    recording_t::n_t = 0;
+    recording_t::m_offsets.push_back(0);
+}
+void recording_t::add_step(const uint32_t* observer_indices, const double_t* observations, uint32_t count)
+{
+    // Verify ground truth consistency.
+    if(!recording_t::m_truth.empty())
+    {
+        throw std::runtime_error("failed to add step (recording requires ground truth)");
+    }
+
+    recording_t::store_step(observer_indices, observations, count);
+}
+void recording_t::add_step(const uint32_t* observer_indices, const double_t* observations, uint32_t count, const Eigen::VectorXd& truth)
+{
+    // Verify ground truth consistency.
+    if(recording_t::n_steps() > 0 && (recording_t::m_truth.empty() || truth.size() != recording_t::n_t))
+    {
+        throw std::runtime_error("failed to add step (ground truth does not match recording)");
+    }
+
+    recording_t::store_step(observer_indices, observations, count);
+
+    // Store ground truth.
+    recording_t::n_t = truth.size();
+    recording_t::m_truth.insert(recording_t::m_truth.end(), truth.data(), truth.data() + truth.size());
+}
+void recording_t::store_step(const uint32_t* observer_indices, const double_t* observations, uint32_t count)
+{
+    // Verify all indices exist before storing any observations.
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        if(!(observer_indices[i] < recording_t::n_z))
+        {
+            throw std::runtime_error("failed to add step (observer_index out of range)");
+        }
+    }
+
+    // Store observations.
+    recording_t::m_observers.insert(recording_t::m_observers.end(), observer_indices, observer_indices + count);
+    recording_t::m_values.insert(recording_t::m_values.end(), observations, observations + count);
+    recording_t::m_offsets.push_back(recording_t::m_observers.size());
+}
+void recording_t::clear()
+{
+    recording_t::m_offsets.resize(1);
+    recording_t::m_observers.clear();
+    recording_t::m_values.clear();
+    recording_t::m_truth.clear();
+    recording_t::n_t = 0;
+}
+uint32_t recording_t::n_observers() const
+{
+    return recording_t::n_z;
+}
+uint32_t recording_t::n_steps() const
+{
+    return recording_t::m_offsets.size() - 1;
+}
+uint32_t recording_t::n_observations(uint32_t step) const
+{
+    return recording_t::m_offsets[step + 1] - recording_t::m_offsets[step];
+}
+const uint32_t* recording_t::observers(uint32_t step) const
+{
+    return recording_t::m_observers.data() + recording_t::m_offsets[step];
+}
+const double_t* recording_t::values(uint32_t step) const
+{
+    return recording_t::m_values.data() + recording_t::m_offsets[step];
+}
+bool recording_t::has_truth() const
+{
+    return recording_t::n_steps() > 0 && !recording_t::m_truth.empty();
+}
+Eigen::Map<const Eigen::VectorXd> recording_t::truth(uint32_t step) const
+{
+    return Eigen::Map<const Eigen::VectorXd>(recording_t::m_truth.data() + step * recording_t::n_t, recording_t::n_t);
+}
+
+// CONSTRUCTORS
+sweep_t::sweep_t(const base_t& prototype, uint32_t n_threads)
+    : m_prototype(prototype.clone())
+{
+    // Verify that the prototype can be cloned.
+    if(!sweep_t::m_prototype)
+    {
+        throw std::runtime_error("failed to create sweep (prototype does not implement clone)");
+    }
+
+    // Use all hardware threads by default.
+    if(n_threads == 0)
+    {
+        n_threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    sweep_t::m_threads = n_threads;
+}
+
+// METHODS
+void sweep_t::run(const recording_t& recording, const std::vector<sweep_configuration_t>& configurations, std::vector<sweep_result_t>& results) const
+{
+    // Verify recording dimensions.
+    if(recording.n_observers() != sweep_t::m_prototype->n_observers())
+    {
+        throw std::runtime_error("failed to run sweep (recording observers do not match prototype)");
+    }
+    if(recording.has_truth() && recording.truth(0).size() != sweep_t::m_prototype->n_variables())
+    {
+        throw std::runtime_error("failed to run sweep (recording ground truth does not match prototype)");
+    }
+
+    // Size outputs.
+    // NOTE: Existing output storage is reused.
+    results.resize(configurations.size());
+
+    // Evaluate configurations on all threads.
+    // NOTE: Threads take the next configuration as they finish, balancing configurations of different cost.
+    std::atomic<uint32_t> next(0);
+    auto worker = [this, &recording, &configurations, &results, &next]()
+    {
+        for(uint32_t c = next++; c < configurations.size(); c = next++)
+        {
+            sweep_t::evaluate(recording, configurations[c], results[c]);
+        }
+    };
+    uint32_t n_workers = std::min<uint32_t>(sweep_t::m_threads, configurations.size());
+    std::vector<std::thread> threads;
+    for(uint32_t t = 1; t < n_workers; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for(auto thread = threads.begin(); thread != threads.end(); ++thread)
+    {
+        thread->join();
+    }
+}
+void sweep_t::evaluate(const recording_t& recording, const sweep_configuration_t& configuration, sweep_result_t& result) const
+{
+    uint32_t n_x = sweep_t::m_prototype->n_variables();
+    bool truth = recording.has_truth();
+
+    // Reset the result.
+    result.valid = true;
+    result.error.clear();
+    result.n_steps = 0;
+    result.n_updates = 0;
+    result.nis = 0.0;
+    result.nees = 0.0;
+    result.rms.setZero(truth ? n_x : 0);
+    result.runtime = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        // Set up the configuration's filter.
+        std::unique_ptr<base_t> filter = sweep_t::m_prototype->clone();
+        uint32_t n_z = filter->n_observers();
+        if(configuration.Q.size() > 0)
+        {
+            if(configuration.Q.rows() != n_x || configuration.Q.cols() != n_x)
+            {
+                throw std::runtime_error("failed to configure filter (Q dimensions do not match the state)");
+            }
+            filter->Q = configuration.Q;
+        }
+        if(configuration.R.size() > 0)
+        {
+            if(configuration.R.rows() != n_z || configuration.R.cols() != n_z)
+            {
+                throw std::runtime_error("failed to configure filter (R dimensions do not match the observers)");
+            }
+            filter->R = configuration.R;
+        }
+        if(configuration.configure)
+        {
+            configuration.configure(*filter);
+        }
+
+        // Replay each step.
+        Eigen::VectorXd error(n_x);
+        Eigen::LLT<Eigen::MatrixXd> llt(n_x);
+        for(uint32_t step = 0; step < recording.n_steps(); ++step)
+        {
+            ++result.n_steps;
+
+            // Iterate the filter on the step's observations.
+            if(sweep_t::step_function)
+            {
+                sweep_t::step_function(*filter, step);
+            }
+            uint32_t n_o = recording.n_observations(step);
+            filter->new_observations(recording.observers(step), recording.values(step), n_o);
+            filter->iterate();
+
+            // Accumulate innovation consistency.
+            if(n_o > 0)
+            {
+                ++result.n_updates;
+                result.nis += filter->nis();
+            }
+
+            // Accumulate estimation error and its consistency.
+            if(truth)
+            {
+                error = filter->state() - recording.truth(step);
+                result.rms += error.cwiseAbs2();
+                llt.compute(filter->covariance());
+                if(llt.info() != Eigen::ComputationInfo::Success)
+                {
+                    throw std::runtime_error("covariance matrix P is not positive definite (nees)");
+                }
+                llt.matrixL().solveInPlace(error);
+                result.nees += error.squaredNorm();
+            }
+        }
+    }
+    catch(const std::exception& exception)
+    {
+        result.valid = false;
+        result.error = exception.what();
+    }
+    result.runtime = std::chrono::duration<double_t>(std::chrono::steady_clock::now() - start).count();
+
+    // Average the accumulated metrics.
+    if(result.n_updates > 0)
+    {
+        result.nis /= result.n_updates;
+    }
+    if(truth && result.n_steps > 0)
+    {
+        result.nees /= result.n_steps;
+        result.rms = (result.rms / result.n_steps).cwiseSqrt();
+    }
+}
+
+// ACCESS
+uint32_t sweep_t::n_threads() const
+{
+    return sweep_t::m_threads;
+}
@@ -0,0 +1,349 @@
+#include <kalman_filter/tracker.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace kalman_filter;
+
+// SPATIAL INDEX
+/// \brief The number of key bits used for each indexed dimension.
+const uint32_t cell_bits = 21;
+/// \brief The largest cell coordinate magnitude that can be stored in a key.
+const int64_t cell_limit = (int64_t(1) << (cell_bits - 1)) - 1;
+
+// CONSTRUCTORS
+tracker_t::tracker_t(const base_t& prototype, initializer_t initializer)
+    : m_filters(prototype),
+      m_initializer(initializer)
+{
+    // Verify that an initializer was provided.
+    if(!tracker_t::m_initializer)
+    {
+        throw std::runtime_error("failed to create tracker (no initializer provided)");
+    }
+
+    // Store dimension sizes.
+    tracker_t::n_x = prototype.n_variables();
+    tracker_t::n_z = prototype.n_observers();
+
+    // Set default parameters.
+    tracker_t::gate = 9.21;
+    tracker_t::cell_size = 1.0;
+    tracker_t::n_index = std::min<uint32_t>(2, tracker_t::n_z);
+    tracker_t::confirm_hits = 3;
+    tracker_t::tentative_misses = 1;
+    tracker_t::confirmed_misses = 5;
+
+    // Initialize tracks.
+    tracker_t::m_next_id = 0;
+
+    // Allocate temporaries.
+    tracker_t::t_z.setZero(tracker_t::n_z);
+    tracker_t::t_x.setZero(tracker_t::n_x);
+    tracker_t::t_xx.setZero(tracker_t::n_x, tracker_t::n_x);
+}
+
+// TRACKING METHODS
+void tracker_t::iterate(const Eigen::MatrixXd& detections)
+{
+    // Verify parameters and detection dimensions.
+    if(detections.rows() != tracker_t::n_z && detections.cols() > 0)
+    {
+        throw std::runtime_error("failed to iterate tracker (detection dimension does not match n_observers)");
+    }
+    if(tracker_t::n_index == 0 || tracker_t::n_index > 3 || tracker_t::n_index > tracker_t::n_z)
+    {
+        throw std::runtime_error("failed to iterate tracker (n_index must be between 1 and min(3, n_observers))");
+    }
+    if(!(tracker_t::cell_size > 0.0))
+    {
+        throw std::runtime_error("failed to iterate tracker (cell_size must be positive)");
+    }
+    if(!detections.allFinite())
+    {
+        throw std::runtime_error("failed to iterate tracker (detections must be finite)");
+    }
+    uint32_t n_d = detections.cols();
+
+    // ---------- STEP 1: PREDICT ----------
+
+    // Predict each track and calculate its gate.
+    for(uint32_t t = 0; t < tracker_t::m_tracks.size(); ++t)
+    {
+        slot_t* slot = &(tracker_t::m_slots[t]);
+        tracker_t::m_tracks[t].filter->predict();
+        tracker_t::m_tracks[t].filter->predicted_observation(slot->z, slot->S);
+        slot->llt.compute(slot->S);
+        slot->valid = (slot->llt.info() == Eigen::ComputationInfo::Success) && slot->z.allFinite();
+    }
+
+    // ---------- STEP 2: GATING ----------
+
+    // Index detections.
+    tracker_t::index(detections);
+
+    // Collect gated pairs for each track.
+    tracker_t::m_assignment.reset(tracker_t::m_tracks.size(), n_d);
+    for(uint32_t t = 0; t < tracker_t::m_tracks.size(); ++t)
+    {
+        tracker_t::gate_track(t, detections);
+    }
+
+    // ---------- STEP 3: ASSOCIATION ----------
+
+    tracker_t::m_detection_tracks.assign(n_d, -1);
+    for(auto track = tracker_t::m_tracks.begin(); track != tracker_t::m_tracks.end(); ++track)
+    {
+        track->detection = -1;
+    }
+    tracker_t::associate();
+
+    // ---------- STEP 4: UPDATE ----------
+
+    for(uint32_t t = 0; t < tracker_t::m_tracks.size(); ++t)
+    {
+        track_t& track = tracker_t::m_tracks[t];
+        if(track.detection >= 0)
+        {
+            // Pass the associated detection to the filter.
+            track.filter->new_observations(static_cast<uint32_t>(0), detections.col(track.detection).data(), tracker_t::n_z);
+            ++track.hits;
+            track.misses = 0;
+            if(track.status == track_status_t::TENTATIVE && track.hits >= tracker_t::confirm_hits)
+            {
+                track.status = track_status_t::CONFIRMED;
+            }
+        }
+        else
+        {
+            ++track.misses;
+        }
+        track.filter->update();
+    }
+
+    // ---------- STEP 5: LIFECYCLE ----------
+
+    // Delete tracks that have missed too many detections.
+    // NOTE: Deletion moves the last track into the deleted index, so iterate backwards.
+    for(uint32_t t = tracker_t::m_tracks.size(); t > 0; --t)
+    {
+        const track_t& track = tracker_t::m_tracks[t-1];
+        uint32_t limit = (track.status == track_status_t::TENTATIVE) ? tracker_t::tentative_misses : tracker_t::confirmed_misses;
+        if(track.misses >= limit)
+        {
+            tracker_t::delete_track(t-1);
+        }
+    }
+
+    // Start new tracks from unassigned detections.
+    for(uint32_t d = 0; d < n_d; ++d)
+    {
+        if(tracker_t::m_detection_tracks[d] < 0)
+        {
+            tracker_t::start_track(d, detections);
+        }
+    }
+}
+
+// SPATIAL INDEX
+uint64_t tracker_t::cell_key(const int64_t* cell) const
+{
+    // Pack each clamped coordinate into its own bit field.
+    uint64_t key = 0;
+    for(uint32_t i = 0; i < tracker_t::n_index; ++i)
+    {
+        int64_t coordinate = std::max(-cell_limit, std::min(cell_limit, cell[i]));
+        key |= (static_cast<uint64_t>(coordinate + cell_limit) & ((uint64_t(1) << cell_bits) - 1)) << (i * cell_bits);
+    }
+    return key;
+}
+void tracker_t::index(const Eigen::MatrixXd& detections)
+{
+    uint32_t n_d = detections.cols();
+
+    // Calculate the cell key of each detection.
+    // NOTE: Coordinates are clamped before the cast, as casting values outside the range of int64_t is undefined.
+    int64_t cell[3];
+    tracker_t::m_keys.resize(n_d);
+    for(uint32_t d = 0; d < n_d; ++d)
+    {
+        for(uint32_t i = 0; i < tracker_t::n_index; ++i)
+        {
+            double_t coordinate = std::floor(detections(i,d) / tracker_t::cell_size);
+            cell[i] = static_cast<int64_t>(std::max(std::min(coordinate, static_cast<double_t>(cell_limit)), -static_cast<double_t>(cell_limit)));
+        }
+        tracker_t::m_keys[d] = tracker_t::cell_key(cell);
+    }
+
+    // Sort detections by cell key.
+    tracker_t::m_order.resize(n_d);
+    for(uint32_t d = 0; d < n_d; ++d)
+    {
+        tracker_t::m_order[d] = d;
+    }
+    std::sort(tracker_t::m_order.begin(), tracker_t::m_order.end(), [this](uint32_t a, uint32_t b) { return tracker_t::m_keys[a] < tracker_t::m_keys[b]; });
+
+    // Store the range of detections in each occupied cell.
+    // NOTE: Clearing the map keeps its buckets allocated.
+    tracker_t::m_cells.clear();
+    for(uint32_t begin = 0; begin < n_d;)
+    {
+        uint64_t key = tracker_t::m_keys[tracker_t::m_order[begin]];
+        uint32_t end = begin + 1;
+        while(end < n_d && tracker_t::m_keys[tracker_t::m_order[end]] == key)
+        {
+            ++end;
+        }
+        tracker_t::m_cells[key] = std::make_pair(begin, end);
+        begin = end;
+    }
+}
+void tracker_t::gate_track(uint32_t track, const Eigen::MatrixXd& detections)
+{
+    const slot_t* slot = &(tracker_t::m_slots[track]);
+
+    // Skip tracks without a valid gate.
+    if(!slot->valid)
+    {
+        return;
+    }
+
+    // Calculate the range of cells overlapped by the gate's bounding box.
+    // NOTE: The ellipsoid d'*S^-1*d <= gate extends sqrt(gate*S(i,i)) along each axis.
+    int64_t lower[3] = {0, 0, 0};
+    int64_t upper[3] = {0, 0, 0};
+    double_t n_cells = 1.0;
+    for(uint32_t i = 0; i < tracker_t::n_index; ++i)
+    {
+        double_t half_width = std::sqrt(tracker_t::gate * slot->S(i,i));
+        lower[i] = static_cast<int64_t>(std::max(std::floor((slot->z(i) - half_width) / tracker_t::cell_size), -static_cast<double_t>(cell_limit)));
+        upper[i] = static_cast<int64_t>(std::min(std::floor((slot->z(i) + half_width) / tracker_t::cell_size), static_cast<double_t>(cell_limit)));
+        n_cells *= static_cast<double_t>(upper[i] - lower[i] + 1);
+    }
+
+    // Test all detections directly if the gate covers more cells than there are occupied cells.
+    if(n_cells > static_cast<double_t>(tracker_t::m_cells.size()))
+    {
+        for(uint32_t d = 0; d < detections.cols(); ++d)
+        {
+            tracker_t::gate_pair(track, d, detections);
+        }
+        return;
+    }
+
+    // Test the detections in each overlapped cell.
+    int64_t cell[3] = {lower[0], lower[1], lower[2]};
+    while(true)
+    {
+        auto occupied = tracker_t::m_cells.find(tracker_t::cell_key(cell));
+        if(occupied != tracker_t::m_cells.end())
+        {
+            for(uint32_t j = occupied->second.first; j < occupied->second.second; ++j)
+            {
+                tracker_t::gate_pair(track, tracker_t::m_order[j], detections);
+            }
+        }
+
+        // Advance to the next cell.
+        uint32_t i = 0;
+        for(; i < tracker_t::n_index; ++i)
+        {
+            if(++cell[i] <= upper[i])
+            {
+                break;
+            }
+            cell[i] = lower[i];
+        }
+        if(i == tracker_t::n_index)
+        {
+            break;
+        }
+    }
+}
+void tracker_t::gate_pair(uint32_t track, uint32_t detection, const Eigen::MatrixXd& detections)
+{
+    const slot_t* slot = &(tracker_t::m_slots[track]);
+
+    // Calculate the squared Mahalanobis distance with the factorization of S.
+    tracker_t::t_z = detections.col(detection) - slot->z;
+    slot->llt.matrixL().solveInPlace(tracker_t::t_z);
+    double_t cost = tracker_t::t_z.squaredNorm();
+
+    // Add the pair if it is inside the gate.
+    if(cost <= tracker_t::gate)
+    {
+        tracker_t::m_assignment.add(track, detection, cost);
+    }
+}
+
+// ASSOCIATION
+void tracker_t::associate()
+{
+    // Solve the assignment over the gated pairs.
+    tracker_t::m_assignment.solve(tracker_t::gate);
+
+    // Store the assignments.
+    const std::vector<int32_t>& assignments = tracker_t::m_assignment.row_assignments();
+    for(uint32_t t = 0; t < tracker_t::m_tracks.size(); ++t)
+    {
+        tracker_t::m_tracks[t].detection = assignments[t];
+        if(assignments[t] >= 0)
+        {
+            tracker_t::m_detection_tracks[assignments[t]] = t;
+        }
+    }
+}
+
+// LIFECYCLE
+void tracker_t::start_track(uint32_t detection, const Eigen::MatrixXd& detections)
+{
+    // Take a filter from the pool.
+    base_t* filter = tracker_t::m_filters.acquire();
+
+    // Allocate gating storage if this is the largest number of tracks so far.
+    if(tracker_t::m_slots.size() <= tracker_t::m_tracks.size())
+    {
+        tracker_t::m_slots.emplace_back();
+        slot_t& slot = tracker_t::m_slots.back();
+        slot.z.setZero(tracker_t::n_z);
+        slot.S.setZero(tracker_t::n_z, tracker_t::n_z);
+        slot.valid = false;
+    }
+
+    // Initialize the filter from the detection.
+    tracker_t::t_z = detections.col(detection);
+    tracker_t::t_x.setZero();
+    tracker_t::t_xx.setZero();
+    tracker_t::m_initializer(tracker_t::t_z, tracker_t::t_x, tracker_t::t_xx);
+    filter->initialize_state(tracker_t::t_x, tracker_t::t_xx);
+
+    // Add the track.
+    track_t track;
+    track.id = tracker_t::m_next_id++;
+    track.status = (tracker_t::confirm_hits <= 1) ? track_status_t::CONFIRMED : track_status_t::TENTATIVE;
+    track.hits = 1;
+    track.misses = 0;
+    track.detection = detection;
+    track.filter = filter;
+    tracker_t::m_tracks.push_back(track);
+}
+void tracker_t::delete_track(uint32_t track)
+{
+    // Return the filter to the pool.
+    tracker_t::m_filters.release(tracker_t::m_tracks[track].filter);
+
+    // Move the last track into the deleted track's index.
+    // NOTE: Gating storage is recalculated for every track each iteration, so it is not moved.
+    tracker_t::m_tracks[track] = tracker_t::m_tracks.back();
+    tracker_t::m_tracks.pop_back();
+}
+
+// ACCESS
+const std::vector<track_t>& tracker_t::tracks() const
+{
+    return tracker_t::m_tracks;
+}
+uint32_t tracker_t::n_filters() const
+{
+    return tracker_t::m_filters.n_allocated();
+}
@@ -1,5 +1,7 @@
 #include <kalman_filter/ukf.hpp>
 
+#include <limits>
+
 using namespace kalman_filter;
 
 // CONSTRUCTORS
@@ -8,13 +10,22 @@ ukf_t::ukf_t(uint32_t n_variables, uint32_t n_observers)
 {
     // Calculate number of sigma points.
     ukf_t::n_s = 1 + 2*ukf_t::n_x;
+    ukf_t::n_m = ukf_t::n_x + 2;
 
-    // Allocate weight vector.
+    // Allocate weight vectors.
     ukf_t::wj.setZero(ukf_t::n_s);
+    ukf_t::wm.setZero(ukf_t::n_m);
 
     // Allocate sigma matrices
-    ukf_t::X.setZero(ukf_t::n_x, ukf_t::n_s);
-    ukf_t::Z.setZero(ukf_t::n_z, ukf_t::n_s);
+    // NOTE: The spare columns hold process noise sigma points when the factor is reused.
+    ukf_t::X.setZero(ukf_t::n_x, ukf_t::n_s + 2*ukf_t::n_x);
+    ukf_t::Z.setZero(ukf_t::n_z, ukf_t::n_s + 2*ukf_t::n_x);
+
+    // Allocate reused factor components.
+    // NOTE: Q is factorized on first reuse.
+    ukf_t::Xq.setZero(ukf_t::n_x, ukf_t::n_x);
+    ukf_t::m_factored_Q.setConstant(ukf_t::n_x, ukf_t::n_x, std::numeric_limits<double_t>::quiet_NaN());
+    ukf_t::wc.setZero(ukf_t::n_s + 2*ukf_t::n_x);
 
     // Allocate interface components.
     ukf_t::i_xp.setZero(ukf_t::n_x);
@@ -22,93 +33,109 @@ ukf_t::ukf_t(uint32_t n_variables, uint32_t n_observers)
     ukf_t::i_z.setZero(ukf_t::n_z);
 
     // Allocate temporaries.
-    ukf_t::t_xs.setZero(ukf_t::n_x, ukf_t::n_s);
-    ukf_t::t_zs.setZero(ukf_t::n_z, ukf_t::n_s);
+    ukf_t::t_xs.setZero(ukf_t::n_x, ukf_t::n_s + 2*ukf_t::n_x);
+    ukf_t::t_zs.setZero(ukf_t::n_z, ukf_t::n_s + 2*ukf_t::n_x);
 
     // Set default parameters.
     ukf_t::wo = 0.1;
+
+    // Mark the minimal sigma point set as not calculated.
+    // NOTE: The simplex is allocated on first use.
+    ukf_t::m_simplex_wo = std::numeric_limits<double_t>::quiet_NaN();
+    ukf_t::m_minimal = false;
 }
 
 // FILTER METHODS
-void ukf_t::iterate()
+void ukf_t::iterate(std::chrono::steady_clock::time_point deadline)
+{
+    // Allow all degradations.
+    uint32_t available = static_cast<uint32_t>(degradation_t::REUSE_FACTOR) |
+                         static_cast<uint32_t>(degradation_t::SKIP_CONDITIONING) |
+                         static_cast<uint32_t>(degradation_t::MINIMAL_SIGMA) |
+                         static_cast<uint32_t>(degradation_t::DEFER_COVARIANCE);
+
+    // NOTE: Sigma point work scales with the number of sigma points.
+    ukf_t::iterate_until(deadline, available, static_cast<double_t>(ukf_t::n_m) / static_cast<double_t>(ukf_t::n_s));
+}
+void ukf_t::predict()
 {
     // ---------- STEP 1: PREPARATION ----------
 
-    // Calculate weight vector for mean and covariance averaging.
-    ukf_t::wj.fill((1.0 - ukf_t::wo)/(2.0 * static_cast<double>(ukf_t::n_x)));
-    ukf_t::wj[0] = ukf_t::wo;
+    // Apply any deferred covariance update.
+    ukf_t::flush_covariance();
 
-    // ---------- STEP 2: PREDICT ----------
+    // Calculate weight vector for mean and covariance averaging.
+    ukf_t::calculate_weights(ukf_t::wj);
 
-    // Populate previous state sigma matrix
-    // Calculate square root of P using Cholseky Decomposition
-    ukf_t::llt.compute(ukf_t::P);
-    // Check if calculation succeeded (positive semi definite)
-    if(ukf_t::llt.info() != Eigen::ComputationInfo::Success)
+    // Select the sigma point set.
+    ukf_t::m_minimal = ukf_t::degrade(degradation_t::MINIMAL_SIGMA);
+    if(ukf_t::m_minimal)
     {
-        throw std::runtime_error("covariance matrix P is not positive semi definite (predict)");
+        ukf_t::calculate_simplex();
     }
-    // Reset first column of X.
-    ukf_t::X.col(0).setZero();
-    // Fill X with +sqrt(P)
-    ukf_t::X.block(0,1,ukf_t::n_x,ukf_t::n_x) = ukf_t::llt.matrixL();
-    // Fill X with -sqrt(P)
-    ukf_t::X.block(0,1+ukf_t::n_x,ukf_t::n_x,ukf_t::n_x) = -1.0 * ukf_t::X.block(0,1,ukf_t::n_x,ukf_t::n_x);
-    // Apply sqrt(n+lambda) to entire matrix.
-    ukf_t::X *= std::sqrt(static_cast<double>(ukf_t::n_x) / (1.0 - ukf_t::wo));
-    // Add mean to entire matrix.
-    ukf_t::X += ukf_t::x.replicate(1,ukf_t::n_s);
 
-    // Pass previous X through state transition function.
-    for(uint32_t s = 0; s < ukf_t::n_s; ++s)
+    // ---------- STEP 2: PREDICT ----------
+
+    // Predict state and covariance.
+    const Eigen::VectorXd& w = ukf_t::m_minimal ? ukf_t::wm : ukf_t::wj;
+    if(!ukf_t::predict_sigma(ukf_t::x, ukf_t::P, ukf_t::x, ukf_t::P, w, ukf_t::m_minimal, ukf_t::llt, ukf_t::X, ukf_t::t_xs, ukf_t::i_xp, ukf_t::i_x))
     {
-        // Populate interface vector.
-        ukf_t::i_xp = ukf_t::X.col(s);
-        ukf_t::i_x.setZero();
-        // Evaluate state transition.
-        state_transition(ukf_t::i_xp, ukf_t::i_x);
-        // Store result back in X.
-        ukf_t::X.col(s) = ukf_t::i_x;
+        ukf_t::fail(status_t::NOT_POSITIVE_DEFINITE, "covariance matrix P is not positive semi definite (predict)");
+        return;
     }
 
-    // Calculate predicted state mean.
-    ukf_t::x.noalias() = ukf_t::X * ukf_t::wj;
-
-    // Calculate predicted state covariance.
-    ukf_t::X -= ukf_t::x.replicate(1, ukf_t::n_s);
-    ukf_t::t_xs.noalias() = ukf_t::X * ukf_t::wj.asDiagonal();
-    ukf_t::P.noalias() = ukf_t::t_xs * ukf_t::X.transpose();
-    ukf_t::P += ukf_t::Q;
-
     // Log predicted state.
     ukf_t::log_predicted_state();
-
-    // ---------- STEP 3: UPDATE ----------
-
+}
+void ukf_t::update()
+{
     // Check if update is necessary.
     if(ukf_t::has_observations())
     {
+        // Use the same sigma point set as the prediction.
+        uint32_t n = ukf_t::m_minimal ? ukf_t::n_m : ukf_t::n_s;
+        const Eigen::VectorXd& w = ukf_t::m_minimal ? ukf_t::wm : ukf_t::wj;
+        // NOTE: The total number of sigma points includes any process noise sigma points.
+        uint32_t n_t = n;
+        ukf_t::wc.head(n) = w;
+
         // Populate predicted state sigma matrix.
-        // Calculate square root of P using Cholseky Decomposition
-        ukf_t::llt.compute(ukf_t::P);
-        // Check if calculation succeeded (positive semi definite)
-        if(ukf_t::llt.info() != Eigen::ComputationInfo::Success)
+        if(ukf_t::degrade(degradation_t::REUSE_FACTOR))
         {
-            throw std::runtime_error("covariance matrix P is not positive semi definite (update)");
+            // Reuse the sigma points propagated by the prediction.
+            // NOTE: X holds their deviations from the predicted mean, which only recover P-Q.
+            if(!ukf_t::factor_process_noise())
+            {
+                return;
+            }
+            ukf_t::X.leftCols(n) += ukf_t::x.replicate(1,n);
+            // Append +/-sqrt(Q) sigma points around the predicted mean so that the set recovers P.
+            double_t scale = std::sqrt(static_cast<double>(ukf_t::n_x) / (1.0 - ukf_t::wo));
+            ukf_t::X.middleCols(n,ukf_t::n_x) = scale * ukf_t::Xq;
+            ukf_t::X.middleCols(n+ukf_t::n_x,ukf_t::n_x) = -scale * ukf_t::Xq;
+            ukf_t::X.middleCols(n,2*ukf_t::n_x) += ukf_t::x.replicate(1,2*ukf_t::n_x);
+            // NOTE: The process noise sigma points only contribute to the covariances, not the mean.
+            ukf_t::wc.segment(n,2*ukf_t::n_x).fill((1.0 - ukf_t::wo)/(2.0 * static_cast<double>(ukf_t::n_x)));
+            n_t += 2*ukf_t::n_x;
+        }
+        else
+        {
+            auto start = ukf_t::start_timing();
+            // Calculate square root of P using Cholseky Decomposition
+            ukf_t::llt.compute(ukf_t::P);
+            // Check if calculation succeeded (positive semi definite)
+            if(ukf_t::llt.info() != Eigen::ComputationInfo::Success)
+            {
+                ukf_t::fail(status_t::NOT_POSITIVE_DEFINITE, "covariance matrix P is not positive semi definite (update)");
+                return;
+            }
+            // Spread sigma points around the predicted mean.
+            ukf_t::draw_sigma(ukf_t::x, ukf_t::llt, ukf_t::m_minimal, ukf_t::X);
+            ukf_t::stop_timing(component_t::FACTOR, start);
         }
-        // Reset first column of X.
-        ukf_t::X.col(0).setZero();
-        // Fill X with +sqrt(P)
-        ukf_t::X.block(0,1,ukf_t::n_x,ukf_t::n_x) = ukf_t::llt.matrixL();
-        // Fill X with -sqrt(P)
-        ukf_t::X.block(0,1+ukf_t::n_x,ukf_t::n_x,ukf_t::n_x) = -1.0 * ukf_t::X.block(0,1,ukf_t::n_x,ukf_t::n_x);
-        // Apply sqrt(n+lambda) to entire matrix.
-        ukf_t::X *= std::sqrt(static_cast<double>(ukf_t::n_x) / (1.0 - ukf_t::wo));
-        // Add mean to entire matrix.
-        ukf_t::X += ukf_t::x.replicate(1,ukf_t::n_s);
 
         // Pass predicted X through state transition function.
-        for(uint32_t s = 0; s < ukf_t::n_s; ++s)
+        for(uint32_t s = 0; s < n_t; ++s)
         {
             // Populate interface vector.
             ukf_t::i_x = ukf_t::X.col(s);
@@ -120,24 +147,27 @@ void ukf_t::iterate()
         }
 
         // Calculate predicted observation mean.
-        ukf_t::z.noalias() = ukf_t::Z * ukf_t::wj;
+        ukf_t::z.noalias() = ukf_t::Z.leftCols(n) * w;
 
         // Log predicted observation.
         ukf_t::log_observations();
 
         // Calculate predicted observation covariance.
-        ukf_t::Z -= ukf_t::z.replicate(1, ukf_t::n_s);
-        ukf_t::t_zs.noalias() = ukf_t::Z * ukf_t::wj.asDiagonal();
-        ukf_t::S.noalias() = ukf_t::t_zs * ukf_t::Z.transpose();
-        ukf_t::S += ukf_t::R;
+        ukf_t::Z.leftCols(n_t) -= ukf_t::z.replicate(1, n_t);
+        ukf_t::t_zs.leftCols(n_t).noalias() = ukf_t::Z.leftCols(n_t) * ukf_t::wc.head(n_t).asDiagonal();
+        ukf_t::S.noalias() = ukf_t::t_zs.leftCols(n_t) * ukf_t::Z.leftCols(n_t).transpose();
+        ukf_t::add_observation_noise(ukf_t::S);
 
         // Calculate predicted state/observation covariance.
-        ukf_t::X -= ukf_t::x.replicate(1, ukf_t::n_s);
-        ukf_t::t_xs.noalias() = ukf_t::X * ukf_t::wj.asDiagonal();
-        ukf_t::C.noalias() = ukf_t::t_xs * ukf_t::Z.transpose();
+        ukf_t::X.leftCols(n_t) -= ukf_t::x.replicate(1, n_t);
+        ukf_t::t_xs.leftCols(n_t).noalias() = ukf_t::X.leftCols(n_t) * ukf_t::wc.head(n_t).asDiagonal();
+        ukf_t::C.noalias() = ukf_t::t_xs.leftCols(n_t) * ukf_t::Z.leftCols(n_t).transpose();
 
         // Run masked Kalman update.
-        ukf_t::masked_kalman_update();
+        if(!ukf_t::masked_kalman_update())
+        {
+            return;
+        }
     }
     else
     {
@@ -147,4 +177,236 @@ void ukf_t::iterate()
 
     // Log estimated state.
     ukf_t::log_estimated_state();
+
+    // Complete iteration.
+    ukf_t::complete_iteration();
+}
+
+void ukf_t::predicted_observation(Eigen::VectorXd& z, Eigen::MatrixXd& S) const
+{
+    // NOTE: Query storage is used throughout so that the filter's sigma matrices and deferred covariance are not changed.
+
+    // Size query storage.
+    // NOTE: Storage is only allocated by the first query.
+    ukf_t::q_X.resize(ukf_t::n_x, ukf_t::n_s);
+    ukf_t::q_Z.resize(ukf_t::n_z, ukf_t::n_s);
+    ukf_t::q_x.resize(ukf_t::n_x);
+    ukf_t::q_z.resize(ukf_t::n_z);
+
+    // Calculate weight vector for mean and covariance averaging.
+    ukf_t::calculate_weights(ukf_t::q_w);
+
+    // Populate predicted state sigma matrix from the covariance with any deferred update applied.
+    ukf_t::q_llt.compute(ukf_t::current_covariance(ukf_t::q_P));
+    if(ukf_t::q_llt.info() != Eigen::ComputationInfo::Success)
+    {
+        throw std::runtime_error("covariance matrix P is not positive semi definite (observation)");
+    }
+    ukf_t::draw_sigma(ukf_t::x, ukf_t::q_llt, false, ukf_t::q_X);
+
+    // Pass predicted X through observation function.
+    for(uint32_t s = 0; s < ukf_t::n_s; ++s)
+    {
+        ukf_t::q_x = ukf_t::q_X.col(s);
+        ukf_t::q_z.setZero();
+        observation(ukf_t::q_x, ukf_t::q_z);
+        ukf_t::q_Z.col(s) = ukf_t::q_z;
+    }
+
+    // Calculate predicted observation mean and covariance.
+    z.noalias() = ukf_t::q_Z * ukf_t::q_w;
+    ukf_t::q_Z -= z.replicate(1, ukf_t::n_s);
+    ukf_t::q_zs.noalias() = ukf_t::q_Z * ukf_t::q_w.asDiagonal();
+    S.noalias() = ukf_t::q_zs * ukf_t::q_Z.transpose();
+    S += ukf_t::R;
+}
+void ukf_t::forecast(uint32_t horizon, std::vector<Eigen::VectorXd>& states, std::vector<Eigen::MatrixXd>& covariances) const
+{
+    // NOTE: Query storage is used throughout so that the filter's sigma matrices and deferred covariance are not changed.
+
+    // Size outputs.
+    // NOTE: Existing output storage is reused.
+    states.resize(horizon);
+    covariances.resize(horizon);
+
+    // Size query storage.
+    // NOTE: Storage is only allocated by the first query.
+    ukf_t::q_X.resize(ukf_t::n_x, ukf_t::n_s);
+    ukf_t::q_xs.resize(ukf_t::n_x, ukf_t::n_s);
+    ukf_t::q_xp.resize(ukf_t::n_x);
+    ukf_t::q_x.resize(ukf_t::n_x);
+
+    // Calculate weight vector for mean and covariance averaging.
+    ukf_t::calculate_weights(ukf_t::q_w);
+
+    // Get the covariance with any deferred update applied.
+    const Eigen::MatrixXd& P = ukf_t::current_covariance(ukf_t::q_P);
+
+    // Predict each step from the previous step.
+    for(uint32_t k = 0; k < horizon; ++k)
+    {
+        if(!ukf_t::predict_sigma((k == 0) ? ukf_t::x : states[k-1], (k == 0) ? P : covariances[k-1], states[k], covariances[k], ukf_t::q_w, false,
+                                 ukf_t::q_llt, ukf_t::q_X, ukf_t::q_xs, ukf_t::q_xp, ukf_t::q_x))
+        {
+            throw std::runtime_error("failed to forecast (covariance matrix P is not positive semi definite)");
+        }
+    }
+}
+
+// PREDICTION
+bool ukf_t::predict_sigma(const Eigen::VectorXd& x_in, const Eigen::MatrixXd& P_in, Eigen::VectorXd& x_out, Eigen::MatrixXd& P_out, const Eigen::VectorXd& w, bool minimal,
+                          Eigen::LLT<Eigen::MatrixXd>& llt, Eigen::MatrixXd& X, Eigen::MatrixXd& t_xs, Eigen::VectorXd& i_xp, Eigen::VectorXd& i_x) const
+{
+    // NOTE: x_in/P_in may alias x_out/P_out, as the inputs are not read after the outputs are written.
+
+    // Select the sigma point set.
+    uint32_t n = minimal ? ukf_t::n_m : ukf_t::n_s;
+
+    // Populate previous state sigma matrix
+    // Calculate square root of P using Cholseky Decomposition
+    llt.compute(P_in);
+    // Check if calculation succeeded (positive semi definite)
+    if(llt.info() != Eigen::ComputationInfo::Success)
+    {
+        return false;
+    }
+    // Spread sigma points around the prior mean.
+    ukf_t::draw_sigma(x_in, llt, minimal, X);
+
+    // Pass previous X through state transition function.
+    for(uint32_t s = 0; s < n; ++s)
+    {
+        // Populate interface vector.
+        i_xp = X.col(s);
+        i_x.setZero();
+        // Evaluate state transition.
+        state_transition(i_xp, i_x);
+        // Store result back in X.
+        X.col(s) = i_x;
+    }
+
+    // Calculate predicted state mean.
+    x_out.noalias() = X.leftCols(n) * w;
+
+    // Calculate predicted state covariance.
+    X.leftCols(n) -= x_out.replicate(1, n);
+    t_xs.leftCols(n).noalias() = X.leftCols(n) * w.asDiagonal();
+    P_out.noalias() = t_xs.leftCols(n) * X.leftCols(n).transpose();
+    P_out += ukf_t::Q;
+
+    return true;
+}
+void ukf_t::draw_sigma(const Eigen::VectorXd& x_in, const Eigen::LLT<Eigen::MatrixXd>& llt, bool minimal, Eigen::MatrixXd& X) const
+{
+    if(minimal)
+    {
+        // Transform the unit simplex by sqrt(P).
+        X.leftCols(ukf_t::n_m).noalias() = llt.matrixL() * ukf_t::U;
+        // Add mean to entire matrix.
+        X.leftCols(ukf_t::n_m) += x_in.replicate(1,ukf_t::n_m);
+    }
+    else
+    {
+        // Reset first column of X.
+        X.col(0).setZero();
+        // Fill X with +sqrt(P)
+        X.block(0,1,ukf_t::n_x,ukf_t::n_x) = llt.matrixL();
+        // Fill X with -sqrt(P)
+        X.block(0,1+ukf_t::n_x,ukf_t::n_x,ukf_t::n_x) = -1.0 * X.block(0,1,ukf_t::n_x,ukf_t::n_x);
+        // Apply sqrt(n+lambda) to entire matrix.
+        X.leftCols(ukf_t::n_s) *= std::sqrt(static_cast<double>(ukf_t::n_x) / (1.0 - ukf_t::wo));
+        // Add mean to entire matrix.
+        X.leftCols(ukf_t::n_s) += x_in.replicate(1,ukf_t::n_s);
+    }
+}
+void ukf_t::calculate_weights(Eigen::VectorXd& w) const
+{
+    w.setConstant(ukf_t::n_s, (1.0 - ukf_t::wo)/(2.0 * static_cast<double>(ukf_t::n_x)));
+    w[0] = ukf_t::wo;
+}
+void ukf_t::calculate_simplex()
+{
+    // Check if the simplex is up to date.
+    if(ukf_t::wo == ukf_t::m_simplex_wo)
+    {
+        return;
+    }
+
+    // Calculate weights.
+    // NOTE: The simplex requires a non-negative center weight.
+    double_t w0 = std::max(ukf_t::wo, 0.0);
+    double_t w1 = (1.0 - w0) / static_cast<double_t>(ukf_t::n_x + 1);
+    ukf_t::wm.fill(w1);
+    ukf_t::wm[0] = w0;
+
+    // Build the spherical simplex one dimension at a time (Julier, 2003).
+    // NOTE: Column 0 is the center point, and dimension j adds point j+1 while offsetting points 1..j.
+    ukf_t::U.setZero(ukf_t::n_x, ukf_t::n_m);
+    ukf_t::U(0,1) = -1.0 / std::sqrt(2.0 * w1);
+    ukf_t::U(0,2) = 1.0 / std::sqrt(2.0 * w1);
+    for(uint32_t j = 2; j <= ukf_t::n_x; ++j)
+    {
+        double_t scale = 1.0 / std::sqrt(static_cast<double_t>(j * (j + 1)) * w1);
+        for(uint32_t i = 1; i <= j; ++i)
+        {
+            ukf_t::U(j-1,i) = -scale;
+        }
+        ukf_t::U(j-1,j+1) = static_cast<double_t>(j) * scale;
+    }
+
+    ukf_t::m_simplex_wo = ukf_t::wo;
+}
+bool ukf_t::factor_process_noise()
+{
+    // Check if the factor is up to date.
+    if(ukf_t::Q == ukf_t::m_factored_Q)
+    {
+        return true;
+    }
+
+    // Calculate square root of Q using Cholseky Decomposition.
+    ukf_t::llt.compute(ukf_t::Q);
+    // Check if calculation succeeded (positive semi definite)
+    if(ukf_t::llt.info() != Eigen::ComputationInfo::Success)
+    {
+        ukf_t::fail(status_t::NOT_POSITIVE_DEFINITE, "covariance matrix Q is not positive semi definite");
+        return false;
+    }
+    ukf_t::Xq = ukf_t::llt.matrixL();
+    ukf_t::m_factored_Q = ukf_t::Q;
+
+    return true;
+}
+
+// ACCESS
+double_t ukf_t::iteration_cost() const
+{
+    // Estimate the cost of the sigma point prediction and a full update.
+    // NOTE: Model function evaluations are assumed to cost O(n_x^2) each.
+    double_t n_x = ukf_t::n_x;
+    double_t n_z = ukf_t::n_z;
+    double_t n_s = ukf_t::n_s;
+    return 2.0*n_x*n_x*n_x/3.0 + n_s*(n_x*n_x + n_x*n_x + n_z*n_z + n_x*n_z) + 2.0*n_z*n_x*n_x + n_z*n_z*n_z/3.0;
+}
+
+// CHECKPOINTING
+filter_type_t ukf_t::filter_type() const
+{
+    return filter_type_t::UKF;
+}
+void ukf_t::checkpoint_fields(std::vector<std::pair<double_t*, uint32_t>>& fields)
+{
+    // Add base fields.
+    base_t::checkpoint_fields(fields);
+
+    // Add parameter fields.
+    fields.emplace_back(&(ukf_t::wo), 1);
+}
+void ukf_t::checkpoint_fields(std::vector<std::pair<const double_t*, uint32_t>>& fields) const
+{
+    // Add base fields.
+    base_t::checkpoint_fields(fields);
+
+    // Add parameter fields.
+    fields.emplace_back(&(ukf_t::wo), 1);
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include <kalman_filter/ukfa.hpp>
 
+#include <limits>
+
 using namespace kalman_filter;
 
 // CONSTRUCTORS
@@ -22,6 +24,9 @@ ukfa_t::ukfa_t(uint32_t n_variables, uint32_t n_observers)
     // Allocate update components.
     ukfa_t::Xr.setZero(ukfa_t::n_z, ukfa_t::n_z);
     ukfa_t::Z.setZero(ukfa_t::n_z, ukfa_t::n_s);
+    ukfa_t::m_factors = false;
+    ukfa_t::m_factored_R.setConstant(ukfa_t::n_z, ukfa_t::n_z, std::numeric_limits<double_t>::quiet_NaN());
+    ukfa_t::m_factored_wo = std::numeric_limits<double_t>::quiet_NaN();
 
     // Allocate interface components.
     ukfa_t::i_xp.setZero(ukfa_t::n_x);
@@ -39,161 +44,107 @@ ukfa_t::ukfa_t(uint32_t n_variables, uint32_t n_observers)
 }
 
 // FILTER METHODS
-void ukfa_t::iterate()
+void ukfa_t::iterate(std::chrono::steady_clock::time_point deadline)
+{
+    // Allow all degradations except minimal sigma points.
+    // NOTE: The augmented sigma points are structured around the separate P, Q, and R factors.
+    uint32_t available = static_cast<uint32_t>(degradation_t::REUSE_FACTOR) |
+                         static_cast<uint32_t>(degradation_t::SKIP_CONDITIONING) |
+                         static_cast<uint32_t>(degradation_t::DEFER_COVARIANCE);
+
+    ukfa_t::iterate_until(deadline, available, 1.0);
+}
+void ukfa_t::predict()
 {
     // ---------- STEP 1: PREPARATION ----------
 
+    // Apply any deferred covariance update.
+    ukfa_t::flush_covariance();
+
     // Calculate weight vector for mean and covariance averaging.
-    ukfa_t::wj.fill((1.0 - ukfa_t::wo)/(2.0 * static_cast<double>(ukfa_t::n_x)));
-    ukfa_t::wj[0] = ukfa_t::wo;
+    ukfa_t::calculate_weights(ukfa_t::wj);
 
     // ---------- STEP 2: PREDICT ----------
 
-    // Calculate sigma matrix.
-    // NOTE: This implementation segments out the input sigma matrix for efficiency:
-    // [u u+y*sqrt(P) u-y*sqrt(P) 0           0           0           0          ]
-    // [0 0           0           u+y(sqrt(Q) u-y*sqrt(Q) 0           0          ]
-    // [0 0           0           0           0           u+y*sqrt(R) u-y*sqrt(R)]
-    // u is stored in x
-    // y*sqrt(P) stored in Xp
-    // y*sqrt(Q) stored in Xq
-    // y*sqrt(R) stored in Xr.
-
-    // Calculate square root of P using Cholseky Decomposition
-    ukfa_t::llt.compute(ukfa_t::P);
-    // Check if calculation succeeded (positive semi definite)
-    if(ukfa_t::llt.info() != Eigen::ComputationInfo::Success)
-    {
-        throw std::runtime_error("covariance matrix P is not positive semi definite");
-    }
-    // Fill +sqrt(P) block of Xp.
-    ukfa_t::Xp = ukfa_t::llt.matrixL();
-    // Apply sqrt(n+lambda) to entire matrix.
-    ukfa_t::Xp *= std::sqrt(static_cast<double>(ukfa_t::n_x) / (1.0 - ukfa_t::wo));
-
-    // Calculate square root of Q using Cholseky Decomposition.
-    ukfa_t::llt.compute(ukfa_t::Q);
-    // Check if calculation succeeded (positive semi definite)
-    if(ukfa_t::llt.info() != Eigen::ComputationInfo::Success)
-    {
-        throw std::runtime_error("covariance matrix Q is not positive semi definite");
-    }
-    // Fill +sqrt(Q) block of Xq.
-    ukfa_t::Xq = ukfa_t::llt.matrixL();
-    // Apply sqrt(n+lambda) to entire matrix.
-    ukfa_t::Xq *= std::sqrt(static_cast<double>(ukfa_t::n_x) / (1.0 - ukfa_t::wo));
-
-    // Calculate square root of R using Cholseky Decomposition.
-    ukfa_t::llt.compute(ukfa_t::R);
-    // Check if calculation succeeded (positive semi definite)
-    if(ukfa_t::llt.info() != Eigen::ComputationInfo::Success)
-    {
-        throw std::runtime_error("covariance matrix R is not positive semi definite");
-    }
-    // Fill +sqrt(R) block of Xr.
-    ukfa_t::Xr = ukfa_t::llt.matrixL();
-    // Apply sqrt(n+lambda) to entire matrix.
-    ukfa_t::Xr *= std::sqrt(static_cast<double>(ukfa_t::n_x) / (1.0 - ukfa_t::wo));
-
-    // Calculate X by passing sigma points through the transition function.
-
-    // Create sigma column index.
-    uint32_t s = 0;
-
-    // Pass first set of sigma points, which is just the mean.
-    // Populate interface vectors.
-    ukfa_t::i_xp = ukfa_t::x;
-    ukfa_t::i_q.setZero(ukfa_t::n_x);
-    ukfa_t::i_x.setZero(ukfa_t::n_x);
-    // Run transition function.
-    state_transition(ukfa_t::i_xp, ukfa_t::i_q, ukfa_t::i_x);
-    // Capture output into X.
-    ukfa_t::X.col(s++) = ukfa_t::i_x;
-
-    // Pass second set of sigma points, which injects Xp.
-    for(uint32_t j = 0; j < ukfa_t::n_x; ++j)
-    {
-        // mean PLUS y*sqrt(P)
-        // Populate interface vectors.
-        ukfa_t::i_xp = ukfa_t::x + ukfa_t::Xp.col(j);
-        ukfa_t::i_q.setZero(ukfa_t::n_x);
-        ukfa_t::i_x.setZero(ukfa_t::n_x);
-        // Run transition function.
-        state_transition(ukfa_t::i_xp, ukfa_t::i_q, ukfa_t::i_x);
-        // Capture output into X.
-        ukfa_t::X.col(s++) = ukfa_t::i_x;
-    }
-    for(uint32_t j = 0; j < ukfa_t::n_x; ++j)
-    {
-        // mean MINUS y*sqrt(P)
-        // Populate interface vectors.
-        ukfa_t::i_xp = ukfa_t::x - ukfa_t::Xp.col(j);
-        ukfa_t::i_q.setZero(ukfa_t::n_x);
-        ukfa_t::i_x.setZero(ukfa_t::n_x);
-        // Run transition function.
-        state_transition(ukfa_t::i_xp, ukfa_t::i_q, ukfa_t::i_x);
-        // Capture output into X.
-        ukfa_t::X.col(s++) = ukfa_t::i_x;
-    }
-
-    // Pass third set of sigma points, which injects Xq.
-    for(uint32_t j = 0; j < ukfa_t::n_x; ++j)
+    // Calculate square root of Q unless the previous one is reused.
+    // NOTE: The previous square root can only be reused once it has been calculated.
+    if(!(ukfa_t::m_factors && ukfa_t::degrade(degradation_t::REUSE_FACTOR)))
     {
-        // mean PLUS y*sqrt(Q)
-        // Populate interface vectors.
-        ukfa_t::i_xp = ukfa_t::x;
-        ukfa_t::i_q = ukfa_t::Xq.col(j);
-        ukfa_t::i_x.setZero(ukfa_t::n_x);
-        // Run transition function.
-        state_transition(ukfa_t::i_xp, ukfa_t::i_q, ukfa_t::i_x);
-        // Capture output into X.
-        ukfa_t::X.col(s++) = ukfa_t::i_x;
-    }
-    for(uint32_t j = 0; j < ukfa_t::n_x; ++j)
-    {  
-        // mean MINUS y*sqrt(Q)
-        // Populate interface vectors.
-        ukfa_t::i_xp = ukfa_t::x;
-        ukfa_t::i_q = -ukfa_t::Xq.col(j);
-        ukfa_t::i_x.setZero(ukfa_t::n_x);
-        // Run transition function.
-        state_transition(ukfa_t::i_xp, ukfa_t::i_q, ukfa_t::i_x);
-        // Capture output into X.
-        ukfa_t::X.col(s++) = ukfa_t::i_x;
+        auto start = ukfa_t::start_timing();
+        if(!ukfa_t::factor_process_noise(ukfa_t::llt, ukfa_t::Xq))
+        {
+            ukfa_t::m_factors = false;
+            ukfa_t::fail(status_t::NOT_POSITIVE_DEFINITE, "covariance matrix Q is not positive semi definite");
+            return;
+        }
+        ukfa_t::stop_timing(component_t::FACTOR, start);
+        ukfa_t::m_factors = true;
     }
 
-    // Pass fourth set of sigma points, which injects Xr.
-    // R has no effect on the transition function, so the output sigma matrix
-    // just has extra copies of the mean at the end.
-    for(;s < ukfa_t::n_s; ++s)
+    // Predict state and covariance.
+    if(!ukfa_t::predict_sigma(ukfa_t::x, ukfa_t::P, ukfa_t::x, ukfa_t::P, ukfa_t::wj, ukfa_t::Xq,
+                              ukfa_t::llt, ukfa_t::Xp, ukfa_t::X, ukfa_t::dX, ukfa_t::t_xs, ukfa_t::i_xp, ukfa_t::i_q, ukfa_t::i_x))
     {
-        ukfa_t::X.col(s) = ukfa_t::X.col(0);
+        ukfa_t::fail(status_t::NOT_POSITIVE_DEFINITE, "covariance matrix P is not positive semi definite");
+        return;
     }
 
-    // Calculate predicted state mean and covariance.
-    
-    // Predicted state mean is a weighted average: sum(wm.*X) over all sigma points.
-    // Can be calculated via matrix multiplication with wm vector.
-    ukfa_t::x.noalias() = ukfa_t::X * ukfa_t::wj;
-
-    // Predicted state covariance is a weighted average: sum(wc.*(X-x)(X-x)') over all sigma points.
-    // This can be done more efficiently (speed & code) using (X-x)*wc*(X-x)', where wc is formed into a diagonal matrix.
-    ukfa_t::dX = ukfa_t::X - ukfa_t::x.replicate(1, ukfa_t::n_s);
-    ukfa_t::t_xs.noalias() = ukfa_t::dX * ukfa_t::wj.asDiagonal();
-    ukfa_t::P.noalias() = ukfa_t::t_xs * ukfa_t::dX.transpose();
-
     // Log predicted state.
     ukfa_t::log_predicted_state();
-
-    // ---------- STEP 3: UPDATE ----------
-    
+}
+void ukfa_t::update()
+{
     // Check if update is necessary.
     if(ukfa_t::has_observations())
     {
+        // Calculate square root of R, unless it is unchanged since it was last calculated or the previous one is
+        // reused if planned.
+        // NOTE: A factor can only be reused if both it and the current observations use R without observation
+        // specific or averaged noise, as otherwise it is the square root of a different covariance.
+        bool corrected = ukfa_t::has_observation_noise();
+        bool factored = !corrected && ukfa_t::m_factored_R.allFinite();
+        bool unchanged = ukfa_t::R == ukfa_t::m_factored_R && ukfa_t::wo == ukfa_t::m_factored_wo;
+        if(!(factored && (unchanged || ukfa_t::degrade(degradation_t::REUSE_FACTOR))))
+        {
+            auto start = ukfa_t::start_timing();
+            // Calculate square root of R using Cholseky Decomposition.
+            // NOTE: Xr temporarily holds R with any observation specific noise applied.
+            ukfa_t::Xr.setZero();
+            ukfa_t::add_observation_noise(ukfa_t::Xr);
+            ukfa_t::llt.compute(ukfa_t::Xr);
+            // Check if calculation succeeded (positive semi definite)
+            if(ukfa_t::llt.info() != Eigen::ComputationInfo::Success)
+            {
+                ukfa_t::m_factored_R.fill(std::numeric_limits<double_t>::quiet_NaN());
+                ukfa_t::fail(status_t::NOT_POSITIVE_DEFINITE, "covariance matrix R is not positive semi definite");
+                return;
+            }
+            // Fill +sqrt(R) block of Xr.
+            ukfa_t::Xr = ukfa_t::llt.matrixL();
+            // Apply sqrt(n+lambda) to entire matrix.
+            ukfa_t::Xr *= std::sqrt(static_cast<double>(ukfa_t::n_x) / (1.0 - ukfa_t::wo));
+            ukfa_t::stop_timing(component_t::FACTOR, start);
+
+            // Record the covariance the factor was calculated for.
+            // NOTE: A factor with observation specific or averaged noise is not sqrt(R), so it is not recorded.
+            if(corrected)
+            {
+                ukfa_t::m_factored_R.fill(std::numeric_limits<double_t>::quiet_NaN());
+            }
+            else
+            {
+                ukfa_t::m_factored_R = ukfa_t::R;
+            }
+            ukfa_t::m_factored_wo = ukfa_t::wo;
+        }
+
         // Calculate Z by passing calculated X and Sr.
 
+        // Create sigma column index.
+        uint32_t s = 0;
+
         // Pass the x/Xp/Xq portion of X through.
-        for(s = 0; s < 1 + 4 * ukfa_t::n_x; ++s)
+        for(; s < 1 + 4 * ukfa_t::n_x; ++s)
         {
             // Populate interface vectors.
             ukfa_t::i_x = ukfa_t::X.col(s);
@@ -253,7 +204,10 @@ void ukfa_t::iterate()
         ukfa_t::C.noalias() = ukfa_t::t_xs * ukfa_t::Z.transpose();
 
         // Run masked Kalman update.
-        ukfa_t::masked_kalman_update();
+        if(!ukfa_t::masked_kalman_update())
+        {
+            return;
+        }
     }
     else
     {
@@ -262,5 +216,279 @@ void ukfa_t::iterate()
     }
 
     // Log estimated state.
-    ukfa_t::log_estimated_state();    
+    ukfa_t::log_estimated_state();
+
+    // Complete iteration.
+    ukfa_t::complete_iteration();
+}
+
+void ukfa_t::predicted_observation(Eigen::VectorXd& z, Eigen::MatrixXd& S) const
+{
+    // NOTE: This uses the predicted state sigma matrix X and weights from predict(), which are only read.
+    // Query storage is used for the observation sigma points so that the update's storage is not changed.
+
+    // Size query storage.
+    // NOTE: Storage is only allocated by the first query.
+    ukfa_t::q_Z.resize(ukfa_t::n_z, ukfa_t::n_s);
+    ukfa_t::q_x.resize(ukfa_t::n_x);
+    ukfa_t::q_r.resize(ukfa_t::n_z);
+    ukfa_t::q_z.resize(ukfa_t::n_z);
+
+    // Calculate square root of R using Cholseky Decomposition.
+    ukfa_t::q_llt.compute(ukfa_t::R);
+    if(ukfa_t::q_llt.info() != Eigen::ComputationInfo::Success)
+    {
+        throw std::runtime_error("covariance matrix R is not positive semi definite");
+    }
+    ukfa_t::q_Xr = ukfa_t::q_llt.matrixL();
+    ukfa_t::q_Xr *= std::sqrt(static_cast<double>(ukfa_t::n_x) / (1.0 - ukfa_t::wo));
+
+    // Pass the x/Xp/Xq portion of X through.
+    uint32_t s = 0;
+    for(; s < 1 + 4 * ukfa_t::n_x; ++s)
+    {
+        ukfa_t::q_x = ukfa_t::X.col(s);
+        ukfa_t::q_r.setZero();
+        ukfa_t::q_z.setZero();
+        observation(ukfa_t::q_x, ukfa_t::q_r, ukfa_t::q_z);
+        ukfa_t::q_Z.col(s) = ukfa_t::q_z;
+    }
+    // Pass Xr through on top of the back of X.
+    for(uint32_t j = 0; j < ukfa_t::n_z; ++j)
+    {
+        ukfa_t::q_x = ukfa_t::X.col(s);
+        ukfa_t::q_r = ukfa_t::q_Xr.col(j);
+        ukfa_t::q_z.setZero();
+        observation(ukfa_t::q_x, ukfa_t::q_r, ukfa_t::q_z);
+        ukfa_t::q_Z.col(s++) = ukfa_t::q_z;
+    }
+    for(uint32_t j = 0; j < ukfa_t::n_z; ++j)
+    {
+        ukfa_t::q_x = ukfa_t::X.col(s);
+        ukfa_t::q_r = -ukfa_t::q_Xr.col(j);
+        ukfa_t::q_z.setZero();
+        observation(ukfa_t::q_x, ukfa_t::q_r, ukfa_t::q_z);
+        ukfa_t::q_Z.col(s++) = ukfa_t::q_z;
+    }
+
+    // Calculate predicted observation mean and covariance.
+    z.noalias() = ukfa_t::q_Z * ukfa_t::wj;
+    ukfa_t::q_Z -= z.replicate(1, ukfa_t::n_s);
+    ukfa_t::q_zs.noalias() = ukfa_t::q_Z * ukfa_t::wj.asDiagonal();
+    S.noalias() = ukfa_t::q_zs * ukfa_t::q_Z.transpose();
+}
+void ukfa_t::forecast(uint32_t horizon, std::vector<Eigen::VectorXd>& states, std::vector<Eigen::MatrixXd>& covariances) const
+{
+    // NOTE: Query storage is used throughout so that the filter's sigma matrices and deferred covariance are not changed.
+
+    // Size outputs.
+    // NOTE: Existing output storage is reused.
+    states.resize(horizon);
+    covariances.resize(horizon);
+
+    // Size query storage.
+    // NOTE: Storage is only allocated by the first query.
+    ukfa_t::q_Xp.resize(ukfa_t::n_x, ukfa_t::n_x);
+    ukfa_t::q_X.resize(ukfa_t::n_x, ukfa_t::n_s);
+    ukfa_t::q_dX.resize(ukfa_t::n_x, ukfa_t::n_s);
+    ukfa_t::q_xs.resize(ukfa_t::n_x, ukfa_t::n_s);
+    ukfa_t::q_xp.resize(ukfa_t::n_x);
+    ukfa_t::q_q.resize(ukfa_t::n_x);
+    ukfa_t::q_x.resize(ukfa_t::n_x);
+
+    // Calculate weight vector for mean and covariance averaging.
+    ukfa_t::calculate_weights(ukfa_t::q_w);
+
+    // Calculate square root of Q.
+    if(!ukfa_t::factor_process_noise(ukfa_t::q_llt, ukfa_t::q_Xq))
+    {
+        throw std::runtime_error("failed to forecast (covariance matrix Q is not positive semi definite)");
+    }
+
+    // Get the covariance with any deferred update applied.
+    const Eigen::MatrixXd& P = ukfa_t::current_covariance(ukfa_t::q_P);
+
+    // Predict each step from the previous step.
+    for(uint32_t k = 0; k < horizon; ++k)
+    {
+        if(!ukfa_t::predict_sigma((k == 0) ? ukfa_t::x : states[k-1], (k == 0) ? P : covariances[k-1], states[k], covariances[k], ukfa_t::q_w, ukfa_t::q_Xq,
+                                  ukfa_t::q_llt, ukfa_t::q_Xp, ukfa_t::q_X, ukfa_t::q_dX, ukfa_t::q_xs, ukfa_t::q_xp, ukfa_t::q_q, ukfa_t::q_x))
+        {
+            throw std::runtime_error("failed to forecast (covariance matrix P is not positive semi definite)");
+        }
+    }
+}
+
+// PREDICTION
+bool ukfa_t::predict_sigma(const Eigen::VectorXd& x_in, const Eigen::MatrixXd& P_in, Eigen::VectorXd& x_out, Eigen::MatrixXd& P_out, const Eigen::VectorXd& w, const Eigen::MatrixXd& Xq,
+                           Eigen::LLT<Eigen::MatrixXd>& llt, Eigen::MatrixXd& Xp, Eigen::MatrixXd& X, Eigen::MatrixXd& dX, Eigen::MatrixXd& t_xs,
+                           Eigen::VectorXd& i_xp, Eigen::VectorXd& i_q, Eigen::VectorXd& i_x) const
+{
+    // NOTE: x_in/P_in may alias x_out/P_out, as the inputs are not read after the outputs are written.
+
+    // Calculate sigma matrix.
+    // NOTE: This implementation segments out the input sigma matrix for efficiency:
+    // [u u+y*sqrt(P) u-y*sqrt(P) 0           0           0           0          ]
+    // [0 0           0           u+y(sqrt(Q) u-y*sqrt(Q) 0           0          ]
+    // [0 0           0           0           0           u+y*sqrt(R) u-y*sqrt(R)]
+    // u is stored in x_in
+    // y*sqrt(P) stored in Xp
+    // y*sqrt(Q) stored in Xq
+    // y*sqrt(R) stored in Xr.
+
+    // Calculate square root of P using Cholseky Decomposition
+    llt.compute(P_in);
+    // Check if calculation succeeded (positive semi definite)
+    if(llt.info() != Eigen::ComputationInfo::Success)
+    {
+        return false;
+    }
+    // Fill +sqrt(P) block of Xp.
+    Xp = llt.matrixL();
+    // Apply sqrt(n+lambda) to entire matrix.
+    Xp *= std::sqrt(static_cast<double>(ukfa_t::n_x) / (1.0 - ukfa_t::wo));
+
+    // Calculate X by passing sigma points through the transition function.
+
+    // Create sigma column index.
+    uint32_t s = 0;
+
+    // Pass first set of sigma points, which is just the mean.
+    // Populate interface vectors.
+    i_xp = x_in;
+    i_q.setZero(ukfa_t::n_x);
+    i_x.setZero(ukfa_t::n_x);
+    // Run transition function.
+    state_transition(i_xp, i_q, i_x);
+    // Capture output into X.
+    X.col(s++) = i_x;
+
+    // Pass second set of sigma points, which injects Xp.
+    for(uint32_t j = 0; j < ukfa_t::n_x; ++j)
+    {
+        // mean PLUS y*sqrt(P)
+        // Populate interface vectors.
+        i_xp = x_in + Xp.col(j);
+        i_q.setZero(ukfa_t::n_x);
+        i_x.setZero(ukfa_t::n_x);
+        // Run transition function.
+        state_transition(i_xp, i_q, i_x);
+        // Capture output into X.
+        X.col(s++) = i_x;
+    }
+    for(uint32_t j = 0; j < ukfa_t::n_x; ++j)
+    {
+        // mean MINUS y*sqrt(P)
+        // Populate interface vectors.
+        i_xp = x_in - Xp.col(j);
+        i_q.setZero(ukfa_t::n_x);
+        i_x.setZero(ukfa_t::n_x);
+        // Run transition function.
+        state_transition(i_xp, i_q, i_x);
+        // Capture output into X.
+        X.col(s++) = i_x;
+    }
+
+    // Pass third set of sigma points, which injects Xq.
+    for(uint32_t j = 0; j < ukfa_t::n_x; ++j)
+    {
+        // mean PLUS y*sqrt(Q)
+        // Populate interface vectors.
+        i_xp = x_in;
+        i_q = Xq.col(j);
+        i_x.setZero(ukfa_t::n_x);
+        // Run transition function.
+        state_transition(i_xp, i_q, i_x);
+        // Capture output into X.
+        X.col(s++) = i_x;
+    }
+    for(uint32_t j = 0; j < ukfa_t::n_x; ++j)
+    {  
+        // mean MINUS y*sqrt(Q)
+        // Populate interface vectors.
+        i_xp = x_in;
+        i_q = -Xq.col(j);
+        i_x.setZero(ukfa_t::n_x);
+        // Run transition function.
+        state_transition(i_xp, i_q, i_x);
+        // Capture output into X.
+        X.col(s++) = i_x;
+    }
+
+    // Pass fourth set of sigma points, which injects Xr.
+    // R has no effect on the transition function, so the output sigma matrix
+    // just has extra copies of the mean at the end.
+    for(;s < ukfa_t::n_s; ++s)
+    {
+        X.col(s) = X.col(0);
+    }
+
+    // Calculate predicted state mean and covariance.
+
+    // Predicted state mean is a weighted average: sum(wm.*X) over all sigma points.
+    // Can be calculated via matrix multiplication with wm vector.
+    x_out.noalias() = X * w;
+
+    // Predicted state covariance is a weighted average: sum(wc.*(X-x)(X-x)') over all sigma points.
+    // This can be done more efficiently (speed & code) using (X-x)*wc*(X-x)', where wc is formed into a diagonal matrix.
+    dX = X - x_out.replicate(1, ukfa_t::n_s);
+    t_xs.noalias() = dX * w.asDiagonal();
+    P_out.noalias() = t_xs * dX.transpose();
+
+    return true;
+}
+
+bool ukfa_t::factor_process_noise(Eigen::LLT<Eigen::MatrixXd>& llt, Eigen::MatrixXd& Xq) const
+{
+    // Calculate square root of Q using Cholseky Decomposition.
+    llt.compute(ukfa_t::Q);
+    // Check if calculation succeeded (positive semi definite)
+    if(llt.info() != Eigen::ComputationInfo::Success)
+    {
+        return false;
+    }
+    // Fill +sqrt(Q) block of Xq.
+    Xq = llt.matrixL();
+    // Apply sqrt(n+lambda) to entire matrix.
+    Xq *= std::sqrt(static_cast<double>(ukfa_t::n_x) / (1.0 - ukfa_t::wo));
+
+    return true;
+}
+void ukfa_t::calculate_weights(Eigen::VectorXd& w) const
+{
+    w.setConstant(ukfa_t::n_s, (1.0 - ukfa_t::wo)/(2.0 * static_cast<double>(ukfa_t::n_x)));
+    w[0] = ukfa_t::wo;
+}
+
+// ACCESS
+double_t ukfa_t::iteration_cost() const
+{
+    // Estimate the cost of the sigma point prediction and a full update.
+    // NOTE: Model function evaluations are assumed to cost O(n_x^2) each. P, Q, and R are factorized.
+    double_t n_x = ukfa_t::n_x;
+    double_t n_z = ukfa_t::n_z;
+    double_t n_s = ukfa_t::n_s;
+    return 2.0*n_x*n_x*n_x/3.0 + n_z*n_z*n_z/3.0 + n_s*(n_x*n_x + n_x*n_x + n_z*n_z + n_x*n_z) + 2.0*n_z*n_x*n_x + n_z*n_z*n_z/3.0;
+}
+
+// CHECKPOINTING
+filter_type_t ukfa_t::filter_type() const
+{
+    return filter_type_t::UKFA;
+}
+void ukfa_t::checkpoint_fields(std::vector<std::pair<double_t*, uint32_t>>& fields)
+{
+    // Add base fields.
+    base_t::checkpoint_fields(fields);
+
+    // Add parameter fields.
+    fields.emplace_back(&(ukfa_t::wo), 1);
+}
+void ukfa_t::checkpoint_fields(std::vector<std::pair<const double_t*, uint32_t>>& fields) const
+{
+    // Add base fields.
+    base_t::checkpoint_fields(fields);
+
+    // Add parameter fields.
+    fields.emplace_back(&(ukfa_t::wo), 1);
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include <kalman_filter/replay.hpp>
+
+#include <dlfcn.h>
+
+#include <iostream>
+#include <sstream>
+
+using namespace kalman_filter;
+
+/// \brief The filter factory exported by a filter library.
+typedef base_t* (*create_filter_t)();
+/// \brief The optional step function exported by a filter library.
+typedef void (*step_filter_t)(base_t&, uint32_t);
+
+/// \brief Prints the command line usage.
+void print_usage()
+{
+    std::cerr << "usage: log_replay --filter LIBRARY --log FILE [OPTIONS]" << std::endl
+              << "  --filter LIBRARY           shared library exporting the filter to replay (see below)" << std::endl
+              << "  --log FILE                 CSV or compressed log written with log_config_t::iteration (for rotated logs, the" << std::endl
+              << "                             file passed to start_log, which loads all numbered files in order)" << std::endl
+              << "  --repeat N                 number of replays, each on a new filter (default: 1)" << std::endl
+              << "  --absolute-tolerance A     absolute tolerance of the estimated state (default: 1e-4)" << std::endl
+              << "  --relative-tolerance R     relative tolerance of the estimated state (default: 1e-6)" << std::endl
+              << std::endl
+              << "The filter library must export:" << std::endl
+              << "  extern \"C\" kalman_filter::base_t* kalman_filter_create();" << std::endl
+              << "returning a new filter in the state of the logged filter at the first logged iteration, and may export:" << std::endl
+              << "  extern \"C\" void kalman_filter_step(kalman_filter::base_t& filter, uint32_t step);" << std::endl
+              << "which is called before each step, for example to set inputs." << std::endl;
+}
+
+int32_t main(int32_t argc, char** argv)
+{
+    // Parse arguments.
+    std::string library;
+    std::string log_file;
+    uint32_t n_repeats = 1;
+    replay_t replay;
+    for(int32_t i = 1; i < argc; i += 2)
+    {
+        if(i + 1 >= argc)
+        {
+            print_usage();
+            return 1;
+        }
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        bool valid = true;
+        if(key == "--filter") library = value;
+        else if(key == "--log") log_file = value;
+        else if(key == "--repeat") valid = static_cast<bool>(std::stringstream(value) >> n_repeats) && n_repeats > 0;
+        else if(key == "--absolute-tolerance") valid = static_cast<bool>(std::stringstream(value) >> replay.absolute_tolerance);
+        else if(key == "--relative-tolerance") valid = static_cast<bool>(std::stringstream(value) >> replay.relative_tolerance);
+        else valid = false;
+
+        if(!valid)
+        {
+            std::cerr << "invalid argument: " << key << " " << value << std::endl;
+            print_usage();
+            return 1;
+        }
+    }
+    if(library.empty() || log_file.empty())
+    {
+        print_usage();
+        return 1;
+    }
+
+    // Load the filter library.
+    void* handle = dlopen(library.c_str(), RTLD_NOW);
+    if(!handle)
+    {
+        std::cerr << "failed to load filter library: " << dlerror() << std::endl;
+        return 1;
+    }
+    create_filter_t create_filter = reinterpret_cast<create_filter_t>(dlsym(handle, "kalman_filter_create"));
+    if(!create_filter)
+    {
+        std::cerr << "filter library does not export kalman_filter_create" << std::endl;
+        return 1;
+    }
+    step_filter_t step_filter = reinterpret_cast<step_filter_t>(dlsym(handle, "kalman_filter_step"));
+    if(step_filter)
+    {
+        replay.step_function = step_filter;
+    }
+
+    // Load the log into memory before timing.
+    if(!replay.load(log_file))
+    {
+        std::cerr << "failed to load log file (unreadable, no iteration column, or missing iterations or observers): " << log_file << std::endl;
+        return 1;
+    }
+    std::cout << "loaded " << replay.recording().n_steps() << " steps, " << replay.recording().n_observers() << " observers, " << replay.states().size() << " logged states, starting at iteration " << replay.first_iteration() << std::endl;
+
+    // Replay the log on a new filter each time.
+    bool success = true;
+    try
+    {
+        for(uint32_t r = 0; r < n_repeats; ++r)
+        {
+            std::unique_ptr<base_t> filter(create_filter());
+            if(!filter)
+            {
+                std::cerr << "kalman_filter_create returned no filter" << std::endl;
+                return 1;
+            }
+            replay_report_t report;
+            success = replay.run(*filter, report) && success;
+
+            // Print the report.
+            std::cout << "replay " << r << ": " << report.n_steps << " steps in " << report.runtime << " s (" << report.rate << " iterations/s), max state error " << report.max_state_error << std::endl;
+            if(!report.valid)
+            {
+                std::cout << "  filter failed at step " << report.n_steps - 1 << ": " << report.error << std::endl;
+            }
+            if(!report.matched)
+            {
+                std::cout << "  mismatch at step " << report.step << ": " << report.description << std::endl;
+            }
+        }
+    }
+    catch(const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return success ? 0 : 2;
+}
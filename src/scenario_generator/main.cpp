@@ -0,0 +1,130 @@
+#include <kalman_filter/scenario.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace kalman_filter;
+
+/// \brief Prints the command line usage.
+void print_usage()
+{
+    std::cerr << "usage: scenario_generator --output FILE [OPTIONS]" << std::endl
+              << "  --model NAME               cv, ca, turn, bearing, or pendulum (default: cv)" << std::endl
+              << "  --dimensions N             spatial dimensions (cv/ca) or sensors (bearing) (default: 2)" << std::endl
+              << "  --steps N                  number of steps (default: 1000)" << std::endl
+              << "  --dt T                     time between steps (default: 0.01)" << std::endl
+              << "  --seed N                   random seed (default: 0)" << std::endl
+              << "  --process-noise S          process noise standard deviation (default: 1)" << std::endl
+              << "  --turn-rate-noise S        turn rate noise standard deviation (default: 0.01)" << std::endl
+              << "  --observation-noise S      observation noise standard deviation (default: 1)" << std::endl
+              << "  --sensor-spacing D         spacing between bearing sensors (default: 100)" << std::endl
+              << "  --length L                 pendulum length (default: 1)" << std::endl
+              << "  --periods P0,P1,...        steps between observations of each observer (default: all 1)" << std::endl
+              << "  --dropouts D0,D1,...       dropout probability of each observer (default: all 0)" << std::endl;
+}
+
+/// \brief Parses a comma separated list of values.
+/// \param text The text to parse.
+/// \param values (OUTPUT) The parsed values.
+/// \returns TRUE if all values were parsed, otherwise FALSE.
+template <typename value_t>
+bool parse_list(const std::string& text, std::vector<value_t>& values)
+{
+    std::stringstream stream(text);
+    std::string item;
+    values.clear();
+    while(std::getline(stream, item, ','))
+    {
+        std::stringstream item_stream(item);
+        value_t value;
+        if(!(item_stream >> value))
+        {
+            return false;
+        }
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+int32_t main(int32_t argc, char** argv)
+{
+    // Parse arguments.
+    scenario_config_t config;
+    std::string output;
+    for(int32_t i = 1; i < argc; i += 2)
+    {
+        if(i + 1 >= argc)
+        {
+            print_usage();
+            return 1;
+        }
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        bool valid = true;
+        if(key == "--output")
+        {
+            output = value;
+        }
+        else if(key == "--model")
+        {
+            if(value == "cv") config.model = scenario_model_t::CONSTANT_VELOCITY;
+            else if(value == "ca") config.model = scenario_model_t::CONSTANT_ACCELERATION;
+            else if(value == "turn") config.model = scenario_model_t::COORDINATED_TURN;
+            else if(value == "bearing") config.model = scenario_model_t::BEARING_ONLY;
+            else if(value == "pendulum") config.model = scenario_model_t::PENDULUM;
+            else valid = false;
+        }
+        else if(key == "--dimensions") valid = static_cast<bool>(std::stringstream(value) >> config.n_dimensions);
+        else if(key == "--steps") valid = static_cast<bool>(std::stringstream(value) >> config.n_steps);
+        else if(key == "--dt") valid = static_cast<bool>(std::stringstream(value) >> config.dt);
+        else if(key == "--seed") valid = static_cast<bool>(std::stringstream(value) >> config.seed);
+        else if(key == "--process-noise") valid = static_cast<bool>(std::stringstream(value) >> config.process_noise);
+        else if(key == "--turn-rate-noise") valid = static_cast<bool>(std::stringstream(value) >> config.turn_rate_noise);
+        else if(key == "--observation-noise") valid = static_cast<bool>(std::stringstream(value) >> config.observation_noise);
+        else if(key == "--sensor-spacing") valid = static_cast<bool>(std::stringstream(value) >> config.sensor_spacing);
+        else if(key == "--length") valid = static_cast<bool>(std::stringstream(value) >> config.length);
+        else if(key == "--periods") valid = parse_list(value, config.periods);
+        else if(key == "--dropouts") valid = parse_list(value, config.dropouts);
+        else valid = false;
+
+        if(!valid)
+        {
+            std::cerr << "invalid argument: " << key << " " << value << std::endl;
+            print_usage();
+            return 1;
+        }
+    }
+    if(output.empty())
+    {
+        print_usage();
+        return 1;
+    }
+
+    try
+    {
+        // Set up the scenario and the output file.
+        scenario_t scenario(config);
+        scenario_writer_t writer;
+        if(!writer.open(output, scenario.n_variables(), scenario.n_observers(), config.dt))
+        {
+            std::cerr << "failed to open output file: " << output << std::endl;
+            return 1;
+        }
+
+        // Stream the scenario to the file.
+        scenario.generate(writer);
+        if(!writer.close())
+        {
+            std::cerr << "failed to write output file: " << output << std::endl;
+            return 1;
+        }
+    }
+    catch(const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}